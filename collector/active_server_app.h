@@ -23,6 +23,7 @@
 #include <coipc/misc.h>
 
 #include <common/noncopyable.h>
+#include <list>
 #include <memory>
 #include <mt/chrono.h>
 #include <mt/thread.h>
@@ -55,19 +56,31 @@ namespace micro_profiler
 		active_server_app(events &events_);
 		~active_server_app();
 
+		// Each call establishes one more session. Sessions coexist and are served from the same worker thread.
 		void connect(const client_factory_t &factory);
 
 		virtual void schedule(std::function<void ()> &&task, mt::milliseconds defer_by = mt::milliseconds(0)) override;
 
+	private:
+		struct connection
+		{
+			coipc::server_session *session;
+			bool awaiting_disconnect;
+			std::unique_ptr<ipc::marshalled_active_session> active_session;
+		};
+
+		typedef std::list<connection> connections_t;
+
 	private:
 		void worker();
+		void finalize();
+		void disconnected(connections_t::iterator i);
 
 	private:
 		events &_events;
-		coipc::server_session *_session;
+		connections_t _connections;
 		bool _exit_requested, _exit_confirmed;
 		tasker::task_queue _queue;
-		std::unique_ptr<ipc::marshalled_active_session> _active_session;
 		mt::thread _thread;
 	};
 
@@ -63,10 +63,11 @@ namespace micro_profiler
 		void start_buffer(buffer_ptr &ready_buffer) throw();
 		void adjust_empty_buffers(const buffering_policy &policy, size_t base_n);
 
-	private:
-		E *_ptr;
+	protected:
+		E *_ptr; // Written directly by assembly fast paths: must remain the first two fields.
 		unsigned int _n_left;
 
+	private:
 		unsigned int _id;
 		buffer_ptr _active_buffer;
 		polyq::circular_buffer< buffer_ptr, polyq::static_entry<buffer_ptr> > _ready_buffers;
@@ -109,10 +110,10 @@ namespace micro_profiler
 	{
 		buffer_ptr b;
 
+		// Only the active buffer is allocated on the thread being registered - empty ones are added by the reader.
 		_empty_buffers_top = _empty_buffers.get();
 		create_buffer(b);
 		start_buffer(b);
-		adjust_empty_buffers(policy, 0u);
 	}
 
 	template <typename E>
@@ -140,7 +141,11 @@ namespace micro_profiler
 			mt::lock_guard<mt::mutex> l(_mtx);
 
 			if (_empty_buffers_top == _empty_buffers.get())
-				continue;
+			{
+				if (_allocated_buffers >= _policy.max_buffers())
+					continue;
+				create_buffer(*_empty_buffers_top++);
+			}
 			start_buffer(*--_empty_buffers_top);
 			break;
 		}
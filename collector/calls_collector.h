@@ -26,6 +26,7 @@
 namespace micro_profiler
 {
 	class thread_monitor;
+	struct fast_trace_layout;
 
 	struct calls_collector_i
 	{
@@ -47,6 +48,7 @@ namespace micro_profiler
 	public:
 		calls_collector(allocator &allocator_, size_t trace_limit, thread_monitor &thread_monitor_,
 			mt::thread_callbacks &thread_callbacks);
+		~calls_collector();
 
 		virtual void read_collected(acceptor &a) override;
 		virtual void flush() override;
@@ -58,10 +60,18 @@ namespace micro_profiler
 
 		void track(timestamp_t timestamp, const void *callee);
 
+		// Makes the thread traces of this collector writable by fast-path trampolines built with the 'layout' set here.
+		// Only one collector in a process may have it enabled. Returns false if the platform has no fast path.
+		bool enable_fast_path(fast_trace_layout &layout);
+
 	private:
 		typedef thread_queue_manager<calls_collector_thread> base_t;
 
 	private:
 		calls_collector_thread &construct_thread_trace();
+		calls_collector_thread &get_thread_trace();
+
+	private:
+		bool _fast_path;
 	};
 }
@@ -22,12 +22,13 @@
 
 #include "buffers_queue.h"
 
-#include <common/pod_vector.h>
 #include <functional>
+#include <memory>
 
 namespace micro_profiler
 {
 	struct allocator;
+	struct fast_trace_layout;
 
 	class calls_collector_thread : public buffers_queue<call_record>
 	{
@@ -44,8 +45,15 @@ namespace micro_profiler
 
 		void flush();
 
+		// Sets the offsets of the fields a fast-path trampoline writes through (all, but 'tls_offset').
+		static void describe(fast_trace_layout &layout);
+
+	private:
+		bool grow_return_stack() throw();
+
 	private:
-		pod_vector<return_entry> _return_stack;
+		std::unique_ptr<return_entry[]> _return_stack;
+		return_entry *_return_top, *_return_limit; // Top is one past the last entry.
 	};
 
 
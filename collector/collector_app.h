@@ -22,6 +22,9 @@
 
 #include "active_server_app.h"
 
+#include <common/types.h>
+#include <vector>
+
 namespace micro_profiler
 {
 	class analyzer;
@@ -35,18 +38,25 @@ namespace micro_profiler
 	{
 	public:
 		collector_app(calls_collector_i &collector, const overhead &overhead_, thread_monitor &threads,
-			module_tracker &module_tracker_, patch_manager &patch_manager_);
+			module_tracker &module_tracker_, patch_manager &patch_manager_,
+			mt::milliseconds idle_timeout = mt::milliseconds(10000));
 		~collector_app();
 
 		void connect(const active_server_app::client_factory_t &factory, bool injected);
 
 		tasker::queue &get_queue();
 
+	private:
+		struct session_state;
+
 	private:
 		virtual void initialize_session(coipc::server_session &session) override;
 		virtual bool finalize_session(coipc::server_session &session) override;
 
 		void collect_and_reschedule();
+		void push_updates(session_state &state);
+		template <typename SenderT>
+		void deliver_statistics(session_state &recipient, const SenderT &send);
 
 	private:
 		calls_collector_i &_collector;
@@ -54,7 +64,9 @@ namespace micro_profiler
 		thread_monitor &_thread_monitor;
 		module_tracker &_module_tracker;
 		patch_manager &_patch_manager;
-		bool _injected;
+		const timestamp_t _idle_timeout;
+		bool _injected, _collecting;
+		std::vector< std::weak_ptr<session_state> > _sessions;
 		active_server_app _server;
 	};
 }
@@ -0,0 +1,59 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+
+#pragma once
+
+#include <common/noncopyable.h>
+#include <common/types.h>
+#include <string>
+#include <vector>
+
+namespace micro_profiler
+{
+	struct module_info_metadata;
+
+	// Keeps preprocessed (parsed and, optionally, demangled) module metadata on disk, so that the metadata of a module
+	// seen by any previous run is served without reading its image. Entries are named by the module hash, but are only
+	// served to the image whose full identity is recorded in them. They are stored as flat serialized blobs, one file
+	// per module, read in one go. Once the entries take more than max_size bytes, the least recently used are evicted.
+	class metadata_cache : noncopyable
+	{
+	public:
+		enum {	default_max_size = 256 * 1024 * 1024	};
+
+	public:
+		metadata_cache(const std::string &directory, unsigned long long max_size = default_max_size);
+
+		// Makes an image identity from its build ID or, if there is none, from its path, size and modification time.
+		static std::string identify(const std::vector<byte> &build_id, const std::string &path);
+
+		bool load(module_info_metadata &metadata, unsigned int hash, const std::string &identity, bool demangled) const;
+		void store(const module_info_metadata &metadata, const std::string &identity, bool demangled) const;
+
+	private:
+		std::string entry_path(unsigned int hash, bool demangled) const;
+		void evict(const std::string &keep_path) const;
+
+	private:
+		const std::string _directory;
+		const unsigned long long _max_size;
+	};
+}
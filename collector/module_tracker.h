@@ -33,6 +33,7 @@
 namespace micro_profiler
 {
 	struct image_info;
+	class metadata_cache;
 
 	class module_tracker : public mapping_access, module::events
 	{
@@ -60,10 +61,12 @@ namespace micro_profiler
 			file_id file;
 			std::string path;
 			std::uint32_t hash;
+			std::vector<byte> build_id;
 		};
 
 	public:
-		module_tracker(module &module_helper);
+		module_tracker(module &module_helper, bool demangle_names = true,
+			std::shared_ptr<const metadata_cache> cache = nullptr);
 
 		module &helper() const;
 
@@ -71,6 +74,12 @@ namespace micro_profiler
 		bool get_module(module_info& info, id_t module_id) const;
 		metadata_ptr get_metadata(id_t module_id) const;
 
+		// Fills in complete module metadata, taking it from the persistent cache (if one is set) when possible.
+		void get_metadata(module_info_metadata &metadata, id_t module_id) const;
+
+		// Locks the current mapping of a module (if it is mapped), like lock_mapping() does for a mapping.
+		std::shared_ptr<module::mapping> lock_module(id_t module_id);
+
 		// mapping_access methods
 		virtual std::shared_ptr<module::mapping> lock_mapping(id_t mapping_id) override;
 		virtual std::shared_ptr<void> notify(mapping_access::events &events_) override;
@@ -83,7 +92,7 @@ namespace micro_profiler
 		};
 
 	private:
-		static std::uint32_t calculate_hash(const std::string &path_);
+		static std::uint32_t calculate_hash(const module::mapping &mapping_);
 
 		// module::events methods
 		virtual void mapped(const module::mapping &mapping_) override;
@@ -92,6 +101,8 @@ namespace micro_profiler
 	private:
 		module &_module_helper;
 		const file_id _this_module_file;
+		const bool _demangle_names;
+		const std::shared_ptr<const metadata_cache> _cache;
 		const std::shared_ptr<mt::mutex> _mtx;
 		sdb::table< module_info, auto_increment_constructor<module_info> > _modules;
 		sdb::table< mapping, auto_increment_constructor<mapping> > _mappings;
@@ -0,0 +1,43 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+
+#pragma once
+
+#include <common/patch_results.h>
+#include <common/protocol.h>
+#include <vector>
+
+namespace micro_profiler
+{
+	typedef std::vector<patch_manager::apply_request> patch_targets;
+
+	// Selects the functions of a module to patch for request_apply_module_patches: size limits and the name pattern
+	// (searched in demangled names, even if the symbols come mangled) are applied first, then leaf functions are
+	// dropped (only when 'base' - the module's mapping - is given, as the code has to be examined), and then the top-K
+	// largest are kept. The targets come out sorted by RVA. Throws std::regex_error on a malformed name pattern.
+	void select_patch_targets(patch_targets &targets, const std::vector<symbol_info> &symbols,
+		const module_patch_request &request, const byte *base);
+
+	// Packs the outcome of patching 'targets' (in the same order as 'results') into a delta-coded RVA list and a
+	// run-length coded bitmap of patches that are active. decode_patch_results() unpacks it.
+	void encode_patch_results(module_patch_result &encoded, const patch_targets &targets,
+		const patch_manager::patch_change_results &results);
+}
@@ -0,0 +1,167 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <common/noncopyable.h>
+#include <cstddef>
+
+namespace micro_profiler
+{
+	// A growing array of slots, each reserved by a single writer and published once filled. Reserving and publishing
+	// are lock-free, so that threads may register concurrently; readers only ever see published slots. Slots are
+	// never moved or freed until the array is destroyed.
+	template <typename T, std::size_t chunk_size = 256>
+	class slot_array : noncopyable
+	{
+	public:
+		slot_array();
+		~slot_array();
+
+		std::size_t reserve();
+		T &operator [](std::size_t index);
+		void publish(std::size_t index);
+
+		std::size_t size() const;
+
+		template <typename CallbackT>
+		void for_each(const CallbackT &callback, std::size_t from = 0);
+
+	private:
+		struct slot
+		{
+			slot();
+
+			T value;
+			std::atomic<bool> published;
+		};
+
+		struct chunk : noncopyable
+		{
+			chunk();
+
+			slot slots[chunk_size];
+			std::atomic<chunk *> next;
+		};
+
+	private:
+		chunk *acquire_chunk(std::size_t chunk_index);
+
+	private:
+		chunk _first;
+		std::atomic<std::size_t> _size;
+	};
+
+
+
+	template <typename T, std::size_t chunk_size>
+	inline slot_array<T, chunk_size>::slot::slot()
+		: value(), published(false)
+	{	}
+
+
+	template <typename T, std::size_t chunk_size>
+	inline slot_array<T, chunk_size>::chunk::chunk()
+		: next(nullptr)
+	{	}
+
+
+	template <typename T, std::size_t chunk_size>
+	inline slot_array<T, chunk_size>::slot_array()
+		: _size(0)
+	{	}
+
+	template <typename T, std::size_t chunk_size>
+	inline slot_array<T, chunk_size>::~slot_array()
+	{
+		for (auto c = _first.next.load(std::memory_order_relaxed); c; )
+		{
+			const auto next = c->next.load(std::memory_order_relaxed);
+
+			delete c;
+			c = next;
+		}
+	}
+
+	template <typename T, std::size_t chunk_size>
+	inline std::size_t slot_array<T, chunk_size>::reserve()
+	{
+		const auto index = _size.fetch_add(1, std::memory_order_relaxed);
+
+		acquire_chunk(index / chunk_size);
+		return index;
+	}
+
+	template <typename T, std::size_t chunk_size>
+	inline T &slot_array<T, chunk_size>::operator [](std::size_t index)
+	{	return acquire_chunk(index / chunk_size)->slots[index % chunk_size].value;	}
+
+	template <typename T, std::size_t chunk_size>
+	inline void slot_array<T, chunk_size>::publish(std::size_t index)
+	{	acquire_chunk(index / chunk_size)->slots[index % chunk_size].published.store(true, std::memory_order_seq_cst);	}
+
+	template <typename T, std::size_t chunk_size>
+	inline std::size_t slot_array<T, chunk_size>::size() const
+	{	return _size.load(std::memory_order_acquire);	}
+
+	template <typename T, std::size_t chunk_size>
+	template <typename CallbackT>
+	inline void slot_array<T, chunk_size>::for_each(const CallbackT &callback, std::size_t from)
+	{
+		const auto n = size();
+		auto c = &_first;
+
+		for (auto i = from / chunk_size; c && i; --i)
+			c = c->next.load(std::memory_order_acquire);
+		for (auto index = from; c && index < n; )
+		{
+			auto &s = c->slots[index % chunk_size];
+
+			if (s.published.load(std::memory_order_acquire))
+				callback(index, s.value);
+			if (++index % chunk_size == 0)
+				c = c->next.load(std::memory_order_acquire);
+		}
+	}
+
+	template <typename T, std::size_t chunk_size>
+	inline typename slot_array<T, chunk_size>::chunk *slot_array<T, chunk_size>::acquire_chunk(std::size_t chunk_index)
+	{
+		auto c = &_first;
+
+		while (chunk_index--)
+		{
+			auto next = c->next.load(std::memory_order_acquire);
+
+			if (!next)
+			{
+				const auto allocated = new chunk;
+
+				if (c->next.compare_exchange_strong(next, allocated, std::memory_order_acq_rel))
+					next = allocated;
+				else
+					delete allocated; // Another writer has appended the chunk first - 'next' now points to it.
+			}
+			c = next;
+		}
+		return c;
+	}
+}
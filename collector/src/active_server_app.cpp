@@ -36,7 +36,7 @@ namespace micro_profiler
 	using namespace ipc;
 
 	active_server_app::active_server_app(events &events_)
-		: _events(events_), _session(nullptr), _exit_requested(false), _exit_confirmed(false),
+		: _events(events_), _exit_requested(false), _exit_confirmed(false),
 			_queue([] {	return mt::milliseconds(micro_profiler::clock());	}), _thread([this] {	worker();	})
 	{
 		LOG(PREAMBLE "constructed...") % A(this);
@@ -45,41 +45,57 @@ namespace micro_profiler
 	active_server_app::~active_server_app()
 	{
 		LOG(PREAMBLE "destroying...") % A(this);
-		schedule([this] {
-			LOG(PREAMBLE "finalizing...") % A(this) % A(_session);
-			(_session && _events.finalize_session(*_session) ? _exit_requested : _exit_confirmed) = true;
-			LOG(PREAMBLE "processing stop request...") % A(this) % A(_exit_confirmed);
-		});
+		schedule([this] {	finalize();	});
 		_thread.join();
 		LOG(PREAMBLE "destroyed...") % A(this);
 	}
 
 	void active_server_app::connect(const client_factory_t &factory)
 	{
-		const auto disconnected = [this] {
-			auto exit_confirmed = false;
+		LOG(PREAMBLE "connection scheduled...");
+		schedule([this, factory] {
+			const auto i = _connections.insert(_connections.end(), connection());
+
+			i->session = nullptr;
+			i->awaiting_disconnect = false;
+			i->active_session.reset(new marshalled_active_session(factory, *this, [this, i] (channel &outbound) -> channel_ptr_t {
+				const auto session = make_shared<server_session>(outbound);
 
-			if (_exit_requested)
-				exit_confirmed = _exit_confirmed = true;
-			_session = nullptr;
-			_active_session.reset();
+				_events.initialize_session(*session);
+				session->set_disconnect_handler([this, i] {	disconnected(i);	});
+				i->session = session.get();
+				return session;
+			}));
+			LOG(PREAMBLE "connection created!") % A(_connections.size());
+		});
+	}
 
-			LOG(PREAMBLE "remote session disconnected...") % A(exit_confirmed);
-		};
-		const auto server_session_factory = [this, disconnected] (channel &outbound) -> channel_ptr_t {
-			const auto session = make_shared<server_session>(outbound);
+	void active_server_app::finalize()
+	{
+		LOG(PREAMBLE "finalizing...") % A(this) % A(_connections.size());
+		for (auto i = _connections.begin(); i != _connections.end(); ++i)
+		{
+			if (i->session && _events.finalize_session(*i->session))
+				_exit_requested = i->awaiting_disconnect = true;
+		}
+		if (!_exit_requested)
+			_exit_confirmed = true;
+		LOG(PREAMBLE "processing stop request...") % A(this) % A(_exit_confirmed);
+	}
 
-			_events.initialize_session(*session);
-			session->set_disconnect_handler(disconnected);
-			_session = session.get();
-			return session;
-		};
+	void active_server_app::disconnected(connections_t::iterator i)
+	{
+		auto exit_confirmed = false;
 
-		LOG(PREAMBLE "connection scheduled...");
-		schedule([this, factory, server_session_factory] {
-			_active_session.reset(new marshalled_active_session(factory, *this, server_session_factory));
-			LOG(PREAMBLE "connection created!");
-		});
+		_connections.erase(i);
+		if (_exit_requested)
+		{
+			exit_confirmed = true;
+			for (auto j = _connections.begin(); j != _connections.end(); ++j)
+				exit_confirmed = exit_confirmed && !j->awaiting_disconnect;
+			_exit_confirmed = exit_confirmed;
+		}
+		LOG(PREAMBLE "remote session disconnected...") % A(exit_confirmed) % A(_connections.size());
 	}
 
 	void active_server_app::schedule(function<void ()> &&task, mt::milliseconds defer_by)
@@ -93,8 +109,8 @@ namespace micro_profiler
 			_queue.wait();
 			_queue.execute_ready(mt::milliseconds(100));
 		} while (!_exit_confirmed);
-		LOG(PREAMBLE "destroying the active session...");
-		_active_session.reset();
+		LOG(PREAMBLE "destroying the active sessions...");
+		_connections.clear();
 		LOG(PREAMBLE "worker thread exiting...");
 	}
 }
@@ -24,16 +24,51 @@
 #include <collector/calls_collector.h>
 
 #include <collector/thread_monitor.h>
+#include <patcher/dynamic_hooking.h>
+
+#if defined(__x86_64__) && defined(__linux__)
+	#define MP_FAST_TRACE
+#endif
 
 using namespace std;
 
 namespace micro_profiler
 {
+#ifdef MP_FAST_TRACE
+	namespace
+	{
+		// The slot fast-path trampolines read the calling thread's trace from. Static TLS is required for the slot to
+		// be at a fixed offset from the thread pointer.
+		__thread calls_collector_thread *g_fast_trace __attribute__((tls_model("initial-exec"))) = nullptr;
+	}
+#endif
+
 	calls_collector::calls_collector(allocator &allocator_, size_t trace_limit, thread_monitor &m,
 			mt::thread_callbacks &callbacks)
-		: base_t(allocator_, buffering_policy(trace_limit, 1, 1), callbacks, [&m] {	return m.register_self();	})
+		: base_t(allocator_, buffering_policy(trace_limit, 1, 1), callbacks, [&m] {	return m.register_self();	}),
+			_fast_path(false)
 	{	}
 
+	calls_collector::~calls_collector()
+	{
+#ifdef MP_FAST_TRACE
+		// The trace of the destroying thread goes away with the collector - fast-path trampolines must not find it.
+		if (_fast_path)
+			g_fast_trace = nullptr;
+#endif
+	}
+
+	inline calls_collector_thread &calls_collector::get_thread_trace()
+	{
+		auto &trace = get_queue();
+
+#ifdef MP_FAST_TRACE
+		if (_fast_path)
+			g_fast_trace = &trace;
+#endif
+		return trace;
+	}
+
 	void calls_collector::read_collected(acceptor &a)
 	{
 		base_t::read_collected([&a] (unsigned int thread_id, const call_record *calls, size_t count)	{
@@ -46,17 +81,32 @@ namespace micro_profiler
 
 	void CC_(fastcall) calls_collector::on_enter(calls_collector *instance, const void **stack_ptr,
 		timestamp_t timestamp, const void *callee)
-	{	instance->get_queue().on_enter(stack_ptr, timestamp, callee);	}
+	{	instance->get_thread_trace().on_enter(stack_ptr, timestamp, callee);	}
 
 	const void *CC_(fastcall) calls_collector::on_exit(calls_collector *instance, const void **stack_ptr,
 		timestamp_t timestamp)
-	{	return instance->get_queue().on_exit(stack_ptr, timestamp);	}
+	{	return instance->get_thread_trace().on_exit(stack_ptr, timestamp);	}
 
 #if !defined(_M_X64)
 	void calls_collector::track(timestamp_t timestamp, const void *callee)
 	{	get_queue().track(callee, timestamp);	}
 #endif
 
+	bool calls_collector::enable_fast_path(fast_trace_layout &layout)
+	{
+#ifdef MP_FAST_TRACE
+		if (!c_fast_trampoline_size)
+			return false;
+		layout.tls_offset = thread_pointer_offset(&g_fast_trace);
+		calls_collector_thread::describe(layout);
+		_fast_path = true;
+		return true;
+#else
+		(void)layout;
+		return false;
+#endif
+	}
+
 	calls_collector_thread &calls_collector::construct_thread_trace()
 	{	return construct_queue();	}
 }
@@ -20,26 +20,37 @@
 
 #include <collector/calls_collector_thread.h>
 
+#include <algorithm>
+#include <new>
+#include <patcher/dynamic_hooking.h>
+
 using namespace std;
 
 namespace micro_profiler
 {
+	namespace
+	{
+		const size_t c_initial_return_stack_size = 10000;
+	}
+
 	calls_collector_thread::calls_collector_thread(allocator &allocator_, const buffering_policy &policy, unsigned int id)
-		: buffers_queue<call_record>(allocator_, policy, id)
+		: buffers_queue<call_record>(allocator_, policy, id), _return_stack(new return_entry[c_initial_return_stack_size]),
+			_return_top(_return_stack.get()), _return_limit(_return_top + c_initial_return_stack_size)
 	{
 		return_entry re = { reinterpret_cast<const void **>(static_cast<size_t>(-1)), };
 
-		_return_stack.push_back(re);
+		*_return_top++ = re;
 	}
 
 	void calls_collector_thread::on_enter(const void **stack_ptr, timestamp_t timestamp, const void *callee) throw()
 	{
-		if (_return_stack.back().stack_ptr != stack_ptr)
+		if (_return_top[-1].stack_ptr != stack_ptr)
 		{
 			// Regular nesting...
-			_return_stack.push_back();
+			if (_return_top == _return_limit && !grow_return_stack())
+				--_return_top; // Out of memory: the top entry gets overwritten, as pod_vector used to do.
 
-			return_entry &e = _return_stack.back();
+			return_entry &e = *_return_top++;
 
 			e.stack_ptr = stack_ptr;
 			e.return_address = *stack_ptr;
@@ -58,14 +69,43 @@ namespace micro_profiler
 		
 		do
 		{
-			return_address = _return_stack.back().return_address;
-
-			_return_stack.pop_back();
+			return_address = (--_return_top)->return_address;
 			track(0, timestamp);
-		} while (_return_stack.back().stack_ptr <= stack_ptr);
+		} while (_return_top[-1].stack_ptr <= stack_ptr);
 		return return_address;
 	}
 
 	FORCE_NOINLINE void calls_collector_thread::flush()
 	{	buffers_queue<call_record>::flush();	}
+
+	void calls_collector_thread::describe(fast_trace_layout &layout)
+	{
+		// Only the addresses of the fields are taken - the storage is never accessed as an object.
+		union {	char bytes[sizeof(calls_collector_thread)]; void *alignment;	} storage;
+		const auto t = reinterpret_cast<const calls_collector_thread *>(&storage);
+		const auto offset = [t] (const void *field) {
+			return static_cast<int>(static_cast<const byte *>(field) - reinterpret_cast<const byte *>(t));
+		};
+
+		layout.record_ptr = offset(&t->_ptr);
+		layout.records_left = offset(&t->_n_left);
+		layout.return_top = offset(&t->_return_top);
+		layout.return_limit = offset(&t->_return_limit);
+	}
+
+	FORCE_NOINLINE bool calls_collector_thread::grow_return_stack() throw()
+	{
+		const auto size = static_cast<size_t>(_return_top - _return_stack.get());
+		const auto capacity = static_cast<size_t>(_return_limit - _return_stack.get());
+		const auto new_capacity = capacity + capacity / 2;
+		unique_ptr<return_entry[]> stack(new(nothrow) return_entry[new_capacity]);
+
+		if (!stack)
+			return false;
+		copy(_return_stack.get(), _return_top, stack.get());
+		_return_stack = move(stack);
+		_return_top = _return_stack.get() + size;
+		_return_limit = _return_stack.get() + new_capacity;
+		return true;
+	}
 }
@@ -22,6 +22,7 @@
 
 #include <collector/analyzer.h>
 #include <collector/module_tracker.h>
+#include <collector/patch_selection.h>
 #include <collector/serialization.h>
 #include <collector/thread_monitor.h>
 
@@ -31,6 +32,7 @@
 #include <common/time.h>
 #include <logger/log.h>
 #include <patcher/interface.h>
+#include <strmd/serializer.h>
 
 #define PREAMBLE "Collector app: "
 
@@ -39,10 +41,116 @@ using namespace std;
 
 namespace micro_profiler
 {
+	namespace
+	{
+		typedef containers::unordered_map<unsigned int, statistic_types::nodes_map> statistics_delta;
+
+		struct update_responder
+		{
+			template <typename StatisticsT>
+			void operator ()(const StatisticsT &statistics) const
+			{	resp(response_statistics_update, statistics);	}
+
+			server_session::response &resp;
+		};
+
+		struct size_counter
+		{
+			void write(const void * /*data*/, size_t size)
+			{	bytes += size;	}
+
+			size_t bytes;
+		};
+
+		template <typename ArchiveT, typename SessionStateT, typename StatisticsT>
+		void serialize_push(ArchiveT &archive, const SessionStateT &state, const StatisticsT &statistics)
+		{
+			archive(state.mapped);
+			archive(state.threads);
+			archive(statistics);
+			archive(state.unmapped);
+			archive(state.counters);
+		}
+
+		template <typename SessionStateT>
+		struct update_pusher
+		{
+			template <typename StatisticsT>
+			void operator ()(const StatisticsT &statistics) const
+			{
+				const auto &state_ = state;
+				size_counter counter = {	0	};
+				strmd::serializer<size_counter, packer> measure(counter);
+
+				serialize_push(measure, state, statistics);
+				state.budget -= static_cast<double>(counter.bytes);
+				state.session->message(statistics_pushed, [&state_, &statistics] (serializer &ser) {
+					serialize_push(ser, state_, statistics);
+				});
+			}
+
+			SessionStateT &state;
+		};
+
+		template <typename IteratorT>
+		void merge(statistic_types::nodes_map &lhs, IteratorT begin_, IteratorT end_)
+		{
+			for (; begin_ != end_; ++begin_)
+			{
+				auto &node = lhs[begin_->first];
+
+				add(node, begin_->second);
+				merge(node.callees, begin_->second.callees.begin(), begin_->second.callees.end());
+			}
+		}
+
+		count_t total_calls(const patch_counters &counters)
+		{
+			count_t total = 0;
+
+			for (auto i = counters.begin(); i != counters.end(); ++i)
+				total += i->calls;
+			return total;
+		}
+
+		void merge(statistics_delta &delta, const analyzer &analyzer_)
+		{
+			for (auto i = analyzer_.begin(); i != analyzer_.end(); ++i)
+			{
+				if (i->second.size())
+					merge(delta[i->first], i->second.begin(), i->second.end());
+			}
+		}
+	}
+
+	struct collector_app::session_state
+	{
+		server_session *session;
+		module_tracker::mapping_history_key history_key;
+		loaded_modules mapped;
+		unloaded_modules unmapped;
+		thread_monitor::history_key threads_key;
+		vector<thread_monitor::value_type> threads;
+		patch_counters counters;
+		count_t counted; // Total of the counters last pushed.
+
+		// Statistics analyzed while serving other sessions and not yet delivered to this one.
+		statistics_delta pending;
+		timestamp_t last_request; // Time of the last request_update, for telling idle sessions.
+
+		update_subscription settings;
+		bool active;
+		unsigned int in_flight;
+		double budget;
+		timestamp_t last_push, last_refill;
+	};
+
+
 	collector_app::collector_app(calls_collector_i &collector, const overhead &overhead_, thread_monitor &threads,
-			module_tracker &module_tracker_, patch_manager &patch_manager_)
+			module_tracker &module_tracker_, patch_manager &patch_manager_, mt::milliseconds idle_timeout)
 		: _collector(collector), _analyzer(new analyzer(overhead_)), _thread_monitor(threads),
-			_module_tracker(module_tracker_), _patch_manager(patch_manager_), _server(*this)
+			_module_tracker(module_tracker_), _patch_manager(patch_manager_), _idle_timeout(idle_timeout.count()),
+			_collecting(false), _server(*this)
 	{	}
 
 	collector_app::~collector_app()
@@ -62,40 +170,60 @@ namespace micro_profiler
 		typedef server_session::response response;
 
 		// Keep buffer objects to avoid excessive allocations.
-		auto history_key = make_shared<module_tracker::mapping_history_key>();
-		auto mapped_ = make_shared<loaded_modules>();
-		auto unmapped_ = make_shared<unloaded_modules>();
+		auto state = make_shared<session_state>();
 		auto metadata = make_shared<module_info_metadata>();
-		auto module_info = make_shared<module_tracker::module_info>();
 		auto threads_buffer = make_shared< vector< pair<thread_monitor::thread_id, thread_info> > >();
 		auto patch_results = make_shared<response_patched_data>();
+		auto patch_targets_ = make_shared<patch_targets>();
+		auto module_patch_result_ = make_shared<module_patch_result>();
+
+		state->session = &session;
+		state->active = false;
+		state->counted = 0;
+		state->last_request = clock();
+		_sessions.push_back(state);
+
+		session.add_handler(request_update, [this, state] (response &resp) {
+			const update_responder responder = {	resp	};
+
+			state->last_request = clock();
+			_module_tracker.get_changes(state->history_key, state->mapped, state->unmapped);
+			_thread_monitor.get_changes(state->threads_key, state->threads);
+			resp(response_modules_loaded, state->mapped);
+			resp(response_threads_info, state->threads);
+			_patch_manager.read_counters(state->counters);
+			resp(response_patch_counters, state->counters);
+			deliver_statistics(*state, responder);
+			resp(response_modules_unloaded, state->unmapped);
+		});
 
-		session.add_handler(request_update, [this, history_key, mapped_, unmapped_] (response &resp) {
-			_module_tracker.get_changes(*history_key, *mapped_, *unmapped_);
-			resp(response_modules_loaded, *mapped_);
-			resp(response_statistics_update, *_analyzer);
-			resp(response_modules_unloaded, *unmapped_);
-			_analyzer->clear();
+		session.add_handler(request_subscribe_updates, [state] (response &, const update_subscription &payload) {
+			const auto now = clock();
+
+			state->settings = payload;
+			state->settings.window = (max)(payload.window, 1u);
+			state->active = true;
+			state->in_flight = 0;
+			state->budget = payload.byte_budget;
+			state->last_push = now - payload.min_interval;
+			state->last_refill = now;
+			LOG(PREAMBLE "push updates subscribed...")
+				% A(payload.min_interval) % A(payload.byte_budget) % A(payload.window);
+		});
+
+		session.add_handler(request_unsubscribe_updates, [state] (response &) {
+			state->active = false;
+		});
+
+		session.add_handler(request_update_credit, [state] (response &, const update_credit &payload) {
+			state->in_flight -= (min)(state->in_flight, payload.pushes);
 		});
 
 		session.add_handler(request_module_metadata,
-			[this, metadata, module_info] (response &resp, unsigned int module_id) {
-
-			auto &md = *metadata;
-			auto metadata_ = _module_tracker.get_metadata(module_id);
-
-			_module_tracker.get_module(*module_info, module_id); // TODO: check the result.
-			md.path = module_info->path;
-			md.hash = module_info->hash;
-			md.symbols.clear();
-			md.source_files.clear();
-			metadata_->enumerate_functions([&] (const symbol_info &symbol) {
-				md.symbols.push_back(symbol);
-			});
-			metadata_->enumerate_files([&] (const pair<unsigned, string> &file) {
-				md.source_files.insert(file);
-			});
-			resp(response_module_metadata, md);
+			[this, metadata] (response &resp, unsigned int module_id) {
+
+			_module_tracker.get_metadata(*metadata, module_id);
+			resp(response_module_metadata, *metadata);
 		});
 
 		session.add_handler(request_threads_info,
@@ -107,27 +235,64 @@ namespace micro_profiler
 		});
 
 		session.add_handler(request_apply_patches, [this, patch_results] (response &resp, const patch_apply_request &payload) {
-			_patch_manager.apply(*patch_results, payload.module_id, make_range(payload.functions));
+			if (payload.count_only)
+				_patch_manager.apply_counters(*patch_results, payload.module_id, make_range(payload.functions));
+			else
+				_patch_manager.apply(*patch_results, payload.module_id, make_range(payload.functions));
 			resp(response_patched, *patch_results);
 		});
 
+		session.add_handler(request_apply_module_patches,
+			[this, metadata, patch_results, patch_targets_, module_patch_result_] (response &resp,
+				const module_patch_request &payload) {
+
+			const auto locked = payload.exclude_leaves ? _module_tracker.lock_module(payload.module_id) : nullptr;
+
+			_module_tracker.get_metadata(*metadata, payload.module_id);
+			try
+			{
+				select_patch_targets(*patch_targets_, metadata->symbols, payload, locked ? locked->base : nullptr);
+			}
+			catch (const exception &e)
+			{
+				LOGE(PREAMBLE "invalid module patch filter...") % A(payload.name_pattern) % A(e.what());
+				patch_targets_->clear();
+			}
+			patch_results->clear();
+			if (!patch_targets_->empty() && payload.count_only)
+				_patch_manager.apply_counters(*patch_results, payload.module_id, make_range(*patch_targets_));
+			else if (!patch_targets_->empty())
+				_patch_manager.apply(*patch_results, payload.module_id, make_range(*patch_targets_));
+			encode_patch_results(*module_patch_result_, *patch_targets_, *patch_results);
+			LOG(PREAMBLE "module patched...") % A(payload.module_id) % A(patch_targets_->size());
+			resp(response_module_patched, *module_patch_result_);
+		});
+
 		session.add_handler(request_revert_patches, [this, patch_results] (response &resp, const patch_revert_request &payload) {
 			_patch_manager.revert(*patch_results, payload.module_id, make_range(payload.functions_rva));
 			resp(response_reverted, *patch_results);
 		});
 
+		session.add_handler(request_pause_patches, [this, patch_results] (response &resp, const patch_pause_request &payload) {
+			_patch_manager.pause(*patch_results, payload.module_id, make_range(payload.functions_rva), payload.paused);
+			resp(response_paused, *patch_results);
+		});
+
 
 		session.message(init, [this] (serializer &ser) {
 			initialization_data idata = {
 				_module_tracker.helper().executable(),
 				ticks_per_second(),
 				_injected,
+				protocol_current,
 			};
 
 			ser(idata);
 		});
 
-		_server.schedule([this] {	collect_and_reschedule();	}, mt::milliseconds(10));
+		if (!_collecting)
+			_server.schedule([this] {	collect_and_reschedule();	}, mt::milliseconds(10));
+		_collecting = true;
 	}
 
 	bool collector_app::finalize_session(server_session &session)
@@ -140,6 +305,82 @@ namespace micro_profiler
 	void collector_app::collect_and_reschedule()
 	{
 		_collector.read_collected(*_analyzer);
+		for (auto i = _sessions.begin(); i != _sessions.end(); )
+		{
+			if (const auto state = i->lock())
+				push_updates(*state), ++i;
+			else
+				i = _sessions.erase(i);
+		}
 		_server.schedule([this] {	collect_and_reschedule();	}, mt::milliseconds(10));
 	}
+
+	void collector_app::push_updates(session_state &state)
+	{
+		const auto now = clock();
+		const auto &settings = state.settings;
+
+		if (settings.byte_budget)
+		{
+			state.budget = (min)(state.budget + 0.001 * settings.byte_budget * (now - state.last_refill),
+				static_cast<double>(settings.byte_budget));
+		}
+		state.last_refill = now;
+
+		// Undelivered data is kept in the analyzer (or the pending delta) and gets coalesced into the next push.
+		if (!state.active || state.in_flight >= settings.window || now - state.last_push < settings.min_interval
+			|| (settings.byte_budget && state.budget < 0))
+		{
+			return;
+		}
+		_module_tracker.get_changes(state.history_key, state.mapped, state.unmapped);
+		_thread_monitor.get_changes(state.threads_key, state.threads);
+		_patch_manager.read_counters(state.counters);
+
+		const auto counted = total_calls(state.counters);
+
+		if (!_analyzer->has_data() && state.pending.empty() && state.mapped.empty() && state.unmapped.empty()
+			&& state.threads.empty() && counted == state.counted)
+		{
+			return;
+		}
+		const update_pusher<session_state> pusher = {	state	};
+
+		deliver_statistics(state, pusher);
+		state.counted = counted;
+		state.last_push = now;
+		state.in_flight++;
+	}
+
+	template <typename SenderT>
+	void collector_app::deliver_statistics(session_state &recipient, const SenderT &send)
+	{
+		const auto now = clock();
+
+		// The analyzer is shared by all the sessions: whatever is drained by the recipient is kept for the others,
+		// unless they neither subscribe to pushes nor poll - those are not going to collect it anytime soon.
+		for (auto i = _sessions.begin(); i != _sessions.end(); ++i)
+		{
+			if (const auto other = i->lock())
+			{
+				if (other.get() == &recipient)
+					continue;
+				else if (other->active || now - other->last_request < _idle_timeout)
+					merge(other->pending, *_analyzer);
+				else
+					other->pending.clear();
+			}
+		}
+		if (recipient.pending.empty())
+		{
+			send(*_analyzer);
+		}
+		else
+		{
+			merge(recipient.pending, *_analyzer);
+			send(recipient.pending);
+			recipient.pending.clear();
+		}
+		_analyzer->clear();
+	}
 }
@@ -23,6 +23,7 @@
 #include <coipc/endpoint.h>
 #include <coipc/misc.h>
 #include <collector/calibration.h>
+#include <collector/metadata_cache.h>
 #include <collector/thread_monitor.h>
 #include <common/constants.h>
 #include <common/module.h>
@@ -129,11 +130,23 @@ namespace micro_profiler
 			calls_collector *&collector_ptr)
 		: _logger(create_writer(module_helper), (log::g_logger = &_logger, &get_datetime)),
 			_memory_manager(virtual_memory::granularity()), _thread_monitor(make_shared<thread_monitor>(thread_callbacks)),
-			_collector(_allocator, trace_limit, *_thread_monitor, thread_callbacks), _module_tracker(module_helper),
+			_collector(_allocator, trace_limit, *_thread_monitor, thread_callbacks),
+			_fast_path(_collector.enable_fast_path(_fast_layout)),
+			_module_tracker(module_helper, !getenv(constants::mangled_names_ev),
+				make_shared<metadata_cache>(constants::data_directory())),
 			_patch_manager([this] (void *target, size_t target_size, id_t /*id*/, executable_memory_allocator &allocator) {
-				return unique_ptr<patch>(new translated_function_patch(target, target_size, &_collector, allocator));
-//				return unique_ptr<patch>(new function_patch(target, &_collector, allocator));
-			}, _module_tracker, _memory_manager), _auto_connect(true)
+				return unique_ptr<patch>(new translated_function_patch(target, target_size, &_collector, allocator,
+					_fast_path ? &_fast_layout : nullptr));
+			}, _module_tracker, _memory_manager, [] (void *target, size_t target_size, volatile count_t *counter,
+				executable_memory_allocator &allocator) {
+
+				return unique_ptr<patch>(new translated_function_patch(target, target_size, counter, allocator));
+			}, [this] (void *target, id_t /*id*/, executable_memory_allocator &allocator) {
+				return unique_ptr<patch>(new function_patch(target, &_collector, allocator,
+					_fast_path ? &_fast_layout : nullptr));
+			}, translated_function_patch::max_size(translated_function_patch::trampoline_size(
+				_fast_path ? &_fast_layout : nullptr)), translated_function_patch::max_size(c_count_trampoline_size)),
+			_auto_connect(true)
 	{
 		collector_ptr = &_collector;
 
@@ -142,7 +155,7 @@ namespace micro_profiler
 		const auto inner_ns = static_cast<int>(oh.inner * period);
 		const auto total_ns = static_cast<int>((oh.inner + oh.outer) * period);
 
-		LOG(PREAMBLE "overhead calibrated...") % A(inner_ns) % A(total_ns);
+		LOG(PREAMBLE "overhead calibrated...") % A(inner_ns) % A(total_ns) % A(_fast_path);
 		_app.reset(new collector_app(_collector, oh, *_thread_monitor, _module_tracker, _patch_manager));
 		_app->get_queue().schedule([this, auto_frontend_factory] {
 			if (_auto_connect)
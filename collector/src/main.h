@@ -28,6 +28,7 @@
 #include <common/noncopyable.h>
 #include <logger/multithreaded_logger.h>
 #include <logger/writer.h>
+#include <patcher/dynamic_hooking.h>
 #include <patcher/image_patch_manager.h>
 
 namespace micro_profiler
@@ -56,6 +57,8 @@ namespace micro_profiler
 		memory_manager _memory_manager;
 		std::shared_ptr<thread_monitor> _thread_monitor;
 		calls_collector _collector;
+		fast_trace_layout _fast_layout;
+		bool _fast_path;
 		module_tracker _module_tracker;
 		image_patch_manager _patch_manager;
 		std::unique_ptr<collector_app> _app;
@@ -0,0 +1,264 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+
+#include <collector/metadata_cache.h>
+
+#include <algorithm>
+#include <common/file_stream.h>
+#include <common/formatting.h>
+#include <common/path.h>
+#include <common/pod_vector.h>
+#include <common/serialization.h>
+#include <common/stream.h>
+#include <cstdio>
+#include <strmd/deserializer.h>
+#include <strmd/packer.h>
+#include <strmd/serializer.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+	#include <process.h>
+	#include <sys/utime.h>
+	#include <windows.h>
+
+	#define getpid _getpid
+
+#else
+	#include <dirent.h>
+	#include <unistd.h>
+	#include <utime.h>
+
+#endif
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace
+	{
+		const unsigned int c_signature = 0x4D43504D; // 'MPCM'
+		const unsigned int c_format = strmd::version<module_info_metadata>::value;
+		const char c_entry_prefix[] = "metadata-";
+		const char c_entry_suffix[] = ".cache";
+
+		typedef strmd::serializer<buffer_writer< pod_vector<byte> >, packer> serializer;
+		typedef strmd::deserializer<buffer_reader, packer> deserializer;
+
+		struct entry_file
+		{
+			string path;
+			unsigned long long size;
+			long long modified;
+
+			bool operator <(const entry_file &rhs) const
+			{	return modified < rhs.modified;	}
+		};
+
+		// Puts the file in place of the existing one (if any) atomically.
+		bool replace_file(const string &from, const string &to)
+		{
+#ifdef _WIN32
+			return !!::MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+			return !rename(from.c_str(), to.c_str());
+#endif
+		}
+
+		void enumerate_entries(vector<string> &names, const string &directory)
+		{
+#ifdef _WIN32
+			WIN32_FIND_DATAA data;
+			const auto h = ::FindFirstFileA((directory & (string(c_entry_prefix) + "*" + c_entry_suffix)).c_str(), &data);
+
+			if (INVALID_HANDLE_VALUE == h)
+				return;
+			do
+				names.push_back(data.cFileName);
+			while (::FindNextFileA(h, &data));
+			::FindClose(h);
+#else
+			const auto prefix_length = sizeof(c_entry_prefix) - 1, suffix_length = sizeof(c_entry_suffix) - 1;
+
+			if (const auto d = ::opendir(directory.c_str()))
+			{
+				while (const auto e = ::readdir(d))
+				{
+					const string name = e->d_name;
+
+					if (name.size() > prefix_length + suffix_length && !name.compare(0, prefix_length, c_entry_prefix)
+							&& !name.compare(name.size() - suffix_length, suffix_length, c_entry_suffix))
+						names.push_back(name);
+				}
+				::closedir(d);
+			}
+#endif
+		}
+	}
+
+	metadata_cache::metadata_cache(const string &directory, unsigned long long max_size)
+		: _directory(directory), _max_size(max_size)
+	{	}
+
+	string metadata_cache::identify(const vector<byte> &build_id, const string &path)
+	{
+		string identity;
+
+		if (!build_id.empty())
+		{
+			identity = "build-id:";
+			for (auto i = build_id.begin(); i != build_id.end(); ++i)
+				itoa<16>(identity, *i, 2);
+		}
+		else
+		{
+			struct stat s = {	};
+
+			stat(path.c_str(), &s);
+			identity = "file:" + path + ":";
+			itoa<10>(identity, static_cast<unsigned long long>(s.st_size));
+			identity += ":";
+			itoa<10>(identity, static_cast<long long>(s.st_mtime));
+		}
+		return identity;
+	}
+
+	bool metadata_cache::load(module_info_metadata &metadata, unsigned int hash, const string &identity,
+		bool demangled) const
+	{
+		enum {	chunk = 1024 * 1024	};
+
+		const auto path = entry_path(hash, demangled);
+		vector<byte> buffer;
+
+		try
+		{
+			read_file_stream s(path);
+
+			for (size_t read = chunk; read == chunk; )
+			{
+				const auto offset = buffer.size();
+
+				buffer.resize(offset + chunk);
+				read = s.read_l(buffer.data() + offset, chunk);
+				buffer.resize(offset + read);
+			}
+		}
+		catch (const exception &)
+		{
+			return false;
+		}
+
+		try
+		{
+			buffer_reader r(const_byte_range(buffer.data(), buffer.size()));
+			deserializer d(r);
+			unsigned int signature, format, hash_;
+			unsigned char demangled_;
+			string identity_;
+
+			d(signature), d(format);
+			if (signature != c_signature || format != c_format)
+				return remove(path.c_str()), false; // Not an entry this version can ever read.
+			d(hash_), d(demangled_), d(identity_);
+			if (hash_ != hash || !!demangled_ != demangled || identity_ != identity)
+				return false;
+			d(metadata);
+		}
+		catch (const exception &)
+		{
+			remove(path.c_str()); // A truncated or corrupted entry.
+			return false;
+		}
+
+		utime(path.c_str(), nullptr); // Marks the entry as recently used for the eviction.
+		return true;
+	}
+
+	void metadata_cache::store(const module_info_metadata &metadata, const string &identity, bool demangled) const
+	{
+		pod_vector<byte> buffer;
+		buffer_writer< pod_vector<byte> > w(buffer);
+		serializer s(w);
+		const auto path = entry_path(metadata.hash, demangled);
+		auto temp_path = path + ".";
+
+		itoa<10>(temp_path, getpid());
+		temp_path += ".tmp";
+		s(c_signature), s(c_format), s(metadata.hash), s(static_cast<unsigned char>(demangled)), s(identity);
+		s(metadata);
+		try
+		{
+			{
+				write_file_stream f(temp_path);
+
+				f.write(buffer.data(), buffer.size());
+			}
+
+			// Concurrently running processes may store the same entry - each writes its own temporary file, and only
+			// complete files are ever put in place.
+			if (replace_file(temp_path, path))
+				evict(path);
+			else
+				remove(temp_path.c_str());
+		}
+		catch (const exception &)
+		{
+			remove(temp_path.c_str());
+		}
+	}
+
+	string metadata_cache::entry_path(unsigned int hash, bool demangled) const
+	{
+		char name[32];
+
+		sprintf(name, "%s%08X%s%s", c_entry_prefix, hash, demangled ? "" : "-m", c_entry_suffix);
+		return _directory & string(name);
+	}
+
+	void metadata_cache::evict(const string &keep_path) const
+	{
+		vector<string> names;
+		vector<entry_file> entries;
+		unsigned long long total = 0;
+
+		enumerate_entries(names, _directory);
+		for (auto i = names.begin(); i != names.end(); ++i)
+		{
+			struct stat s;
+			entry_file e = {	_directory & *i, 0, 0	};
+
+			if (stat(e.path.c_str(), &s))
+				continue;
+			e.size = static_cast<unsigned long long>(s.st_size);
+			e.modified = static_cast<long long>(s.st_mtime);
+			total += e.size;
+			if (e.path != keep_path)
+				entries.push_back(e);
+		}
+		sort(entries.begin(), entries.end());
+		for (auto i = entries.begin(); total > _max_size && i != entries.end(); ++i)
+		{
+			if (!remove(i->path.c_str()))
+				total -= i->size;
+		}
+	}
+}
@@ -22,7 +22,9 @@
 
 #include "xxhash32.h"
 
+#include <collector/metadata_cache.h>
 #include <common/file_stream.h>
+#include <common/image_info.h>
 #include <common/module.h>
 #include <sdb/integrated_index.h>
 #include <stdexcept>
@@ -83,24 +85,34 @@ namespace micro_profiler
 	{	}
 
 
-	uint32_t module_tracker::calculate_hash(const string &path_)
+	uint32_t module_tracker::calculate_hash(const module::mapping &mapping_)
 	{
-		enum {	n = 1024	};
+		enum {	n = 64 * 1024	};
 
 		XXHash32 h(0);
-		byte buffer[n];
-		read_file_stream s(path_);
 
-		for (size_t read = n; read == n; )
+		if (!mapping_.build_id.empty())
 		{
-			read = s.read_l(buffer, n);
-			h.add(buffer, read);
+			// The build ID is already in memory, while hashing the file may take seconds for large images.
+			h.add(mapping_.build_id.data(), mapping_.build_id.size());
+		}
+		else
+		{
+			vector<byte> buffer(n);
+			read_file_stream s(mapping_.path);
+
+			for (size_t read = n; read == n; )
+			{
+				read = s.read_l(buffer.data(), n);
+				h.add(buffer.data(), read);
+			}
 		}
 		return h.hash();
 	}
 
-	module_tracker::module_tracker(module &module_helper)
+	module_tracker::module_tracker(module &module_helper, bool demangle_names, shared_ptr<const metadata_cache> cache)
 		: _module_helper(module_helper), _this_module_file(module_helper.locate(&local_dummy).path),
+			_demangle_names(demangle_names), _cache(cache),
 			_mtx(make_shared<mt::mutex>()), _sinks(make_shared< list<mapping_access::events *> >()),
 			_module_notifier(module_helper.notify(*this))
 	{	}
@@ -110,6 +122,8 @@ namespace micro_profiler
 
 	void module_tracker::get_changes(mapping_history_key &key, loaded_modules &mapped_, unloaded_modules &unmapped_) const
 	{
+		_module_helper.refresh_mappings(); // Must go before locking: mapped()/unmapped() may be called back.
+
 		mt::lock_guard<mt::mutex> l(*_mtx);
 		auto last_reported_mapping_id = key.last_mapping_id;
 		auto last_reported_unmapped_id = key.last_unmapped_id;
@@ -156,7 +170,36 @@ namespace micro_profiler
 				throw invalid_argument("invalid persistent id");
 			path = m->path;
 		}
-		return load_image_info(path);
+		return load_image_info(path, _demangle_names);
+	}
+
+	void module_tracker::get_metadata(module_info_metadata &metadata, id_t module_id) const
+	{
+		module_info info;
+
+		if (!get_module(info, module_id))
+			throw invalid_argument("invalid persistent id");
+
+		const auto identity = _cache ? metadata_cache::identify(info.build_id, info.path) : string();
+
+		metadata.symbols.clear();
+		metadata.source_files.clear();
+		if (!_cache || !_cache->load(metadata, info.hash, identity, _demangle_names))
+		{
+			const auto image = load_image_info(info.path, _demangle_names);
+
+			image->enumerate_functions([&] (const symbol_info &symbol) {
+				metadata.symbols.push_back(symbol);
+			});
+			image->enumerate_files([&] (const pair<unsigned, string> &file) {
+				metadata.source_files.insert(file);
+			});
+			metadata.hash = info.hash;
+			if (_cache)
+				_cache->store(metadata, identity, _demangle_names);
+		}
+		metadata.path = info.path;
+		metadata.hash = info.hash;
 	}
 
 	shared_ptr<module::mapping> module_tracker::lock_mapping(id_t mapping_id)
@@ -180,6 +223,21 @@ namespace micro_profiler
 		return nullptr;
 	}
 
+	shared_ptr<module::mapping> module_tracker::lock_module(id_t module_id)
+	{
+		id_t mapping_id;
+
+		{
+			mt::lock_guard<mt::mutex> l(*_mtx);
+			const auto r = sdb::multi_index(_mappings, keyer::module_id()).equal_range(module_id);
+
+			if (r.first == r.second)
+				return nullptr;
+			mapping_id = r.first->id;
+		}
+		return lock_mapping(mapping_id);
+	}
+
 	shared_ptr<void> module_tracker::notify(mapping_access::events &events_)
 	{
 		auto mtx = _mtx;
@@ -207,6 +265,17 @@ namespace micro_profiler
 		if (_this_module_file == file)
 			return;
 
+		uint32_t hash = 0;
+		bool known;
+
+		{
+			mt::lock_guard<mt::mutex> l(*_mtx);
+
+			known = !!sdb::unique_index(_modules, keyer::file_id()).find(file);
+		}
+		if (!known)
+			hash = calculate_hash(mapping_); // May take long - must not block get_changes() and others.
+
 		mt::lock_guard<mt::mutex> l(*_mtx);
 		auto r = sdb::unique_index(_mappings, keyer::base())[mapping_.base];
 		auto r_module = sdb::unique_index(_modules, keyer::file_id())[file];
@@ -214,7 +283,8 @@ namespace micro_profiler
 		if (r_module.is_new())
 		{
 			(*r_module).path = path;
-			(*r_module).hash = calculate_hash(path);
+			(*r_module).hash = hash;
+			(*r_module).build_id = mapping_.build_id;
 			r_module.commit();
 		}
 		static_cast<module::mapping &>(*r) = mapping_;
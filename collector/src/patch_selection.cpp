@@ -0,0 +1,160 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+
+#include <collector/patch_selection.h>
+
+#include <algorithm>
+#include <cstring>
+#include <patcher/instruction_iterator.h>
+#include <regex>
+
+#if defined(__GNUC__)
+	#include <cstdlib>
+	#include <cxxabi.h>
+#endif
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace
+	{
+		bool is_leaf(const byte *body, unsigned int size)
+		{
+			for (instruction_iterator<const byte> i(const_byte_range(body, size)); i.fetch(); )
+			{
+				if (!strncmp(i.mnemonic(), "call", 4))
+					return false;
+			}
+			return true;
+		}
+
+		bool is_active(patch_change_result::errors result)
+		{	return patch_change_result::ok == result || patch_change_result::unchanged == result;	}
+
+		// Collectors may be configured to keep the names as they are in the image (MICROPROFILERMANGLEDNAMES), while
+		// the patterns are written against the names the user sees.
+		class demangler
+		{
+		public:
+			demangler()
+				: _buffer(0), _length(0)
+			{	}
+
+			~demangler()
+			{	free(_buffer);	}
+
+			const char *operator ()(const string &name)
+			{
+#if defined(__GNUC__)
+				int status = 0;
+
+				if (!name.compare(0, 2, "_Z"))
+				{
+					if (char *demangled = abi::__cxa_demangle(name.c_str(), _buffer, &_length, &status))
+						return _buffer = demangled;
+				}
+#endif
+				return name.c_str();
+			}
+
+		private:
+			demangler(const demangler &other);
+			void operator =(const demangler &rhs);
+
+		private:
+			char *_buffer;
+			size_t _length;
+		};
+	}
+
+	void select_patch_targets(patch_targets &targets, const vector<symbol_info> &symbols,
+		const module_patch_request &request, const byte *base)
+	{
+		const auto max_size = request.max_size ? request.max_size : ~0u;
+		const bool match_names = !request.name_pattern.empty();
+		const regex name_pattern(match_names ? request.name_pattern : string(), regex::ECMAScript | regex::optimize);
+		demangler demangle;
+
+		targets.clear();
+		for (auto i = symbols.begin(); i != symbols.end(); ++i)
+		{
+			if (i->size < request.min_size || i->size > max_size || !i->size)
+				continue;
+			if (match_names && !regex_search(demangle(i->name), name_pattern))
+				continue;
+			targets.push_back(make_pair(i->rva, i->size));
+		}
+
+		// Aliases share the body - only the first (after sorting - the largest) one is kept.
+		sort(targets.begin(), targets.end(), [] (const patch_manager::apply_request &lhs, const patch_manager::apply_request &rhs) {
+			return lhs.first < rhs.first || (lhs.first == rhs.first && lhs.second > rhs.second);
+		});
+		targets.erase(unique(targets.begin(), targets.end(),
+			[] (const patch_manager::apply_request &lhs, const patch_manager::apply_request &rhs) {
+			return lhs.first == rhs.first;
+		}), targets.end());
+
+		if (request.exclude_leaves && base)
+		{
+			targets.erase(remove_if(targets.begin(), targets.end(), [base] (const patch_manager::apply_request &target) {
+				return is_leaf(base + target.first, target.second);
+			}), targets.end());
+		}
+
+		if (request.top_k && request.top_k < targets.size())
+		{
+			nth_element(targets.begin(), targets.begin() + request.top_k, targets.end(),
+				[] (const patch_manager::apply_request &lhs, const patch_manager::apply_request &rhs) {
+				return lhs.second > rhs.second || (lhs.second == rhs.second && lhs.first < rhs.first);
+			});
+			targets.resize(request.top_k);
+			sort(targets.begin(), targets.end());
+		}
+	}
+
+	void encode_patch_results(module_patch_result &encoded, const patch_targets &targets,
+		const patch_manager::patch_change_results &results)
+	{
+		auto previous_rva = 0u;
+		auto active = true;
+		auto run = 0u;
+
+		encoded.rva_deltas.clear();
+		encoded.activated_runs.clear();
+		encoded.rva_deltas.reserve(targets.size());
+		for (size_t i = 0; i != targets.size(); ++i)
+		{
+			const auto active_ = i < results.size() && is_active(results[i].result);
+
+			encoded.rva_deltas.push_back(targets[i].first - previous_rva);
+			previous_rva = targets[i].first;
+			if (active_ != active)
+			{
+				encoded.activated_runs.push_back(run);
+				active = active_, run = 0;
+			}
+			run++;
+		}
+		if (run)
+			encoded.activated_runs.push_back(run);
+	}
+}
@@ -21,19 +21,30 @@
 #pragma once
 
 #include <common/types.h>
+#include <cstdint>
 #include <functional>
 #include <mt/chrono.h>
 
 namespace micro_profiler
 {
+	// A snapshot of a thread, cheap to take from the thread itself. It remains valid for opening the thread's info
+	// from any other thread while the thread is running.
+	struct thread_reference
+	{
+		unsigned long long native_id;
+		std::uintptr_t handle;
+		mt::milliseconds start_time; // Only taken on the systems that do not keep it.
+	};
+
 	struct this_process
 	{
 		static mt::milliseconds get_process_uptime();
+		static std::function<void (thread_info &info)> open_thread_info(const thread_reference &thread);
 	};
 
 	struct this_thread
 	{
 		static unsigned long long get_native_id();
-		static std::function<void (thread_info &info)> open_info();
+		static thread_reference get_reference();
 	};
 }
@@ -87,16 +87,13 @@ namespace micro_profiler
 		return mt::milliseconds(static_cast<long long>(uptime * 1000.0f)) - get_process_start_time();
 	}
 
-	unsigned long long this_thread::get_native_id()
-	{	return ::syscall(SYS_gettid);	}
-
-	function<void (thread_info &info)> this_thread::open_info()
+	function<void (thread_info &info)> this_process::open_thread_info(const thread_reference &thread)
 	{
-		const auto id = get_native_id();
-		const auto start_time = get_thread_start_time(get_native_id()) - get_process_start_time();
+		const auto id = thread.native_id;
+		const auto start_time = get_thread_start_time(static_cast<unsigned int>(id)) - get_process_start_time();
 		clockid_t clock_handle;
 
-		::pthread_getcpuclockid(::pthread_self(), &clock_handle);
+		::pthread_getcpuclockid(static_cast<pthread_t>(thread.handle), &clock_handle);
 		return [id, start_time, clock_handle] (thread_info &info) {
 			timespec t = {};
 
@@ -105,4 +102,13 @@ namespace micro_profiler
 			info.cpu_time = (::clock_gettime(clock_handle, &t), mt::milliseconds(t.tv_sec * 1000 + t.tv_nsec / 1000000));
 		};
 	}
+
+	unsigned long long this_thread::get_native_id()
+	{	return ::syscall(SYS_gettid);	}
+
+	thread_reference this_thread::get_reference()
+	{
+		thread_reference r = {	get_native_id(), static_cast<uintptr_t>(::pthread_self()), mt::milliseconds(0)	};
+		return r;
+	}
 }
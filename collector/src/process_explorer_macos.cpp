@@ -48,14 +48,11 @@ namespace micro_profiler
 	mt::milliseconds this_process::get_process_uptime()
 	{	return get_uptime() - c_process_start;	}
 
-	unsigned long long this_thread::get_native_id()
-	{	return pthread_mach_thread_np(pthread_self());	}
-
-	function<void (thread_info &info)> this_thread::open_info()
+	function<void (thread_info &info)> this_process::open_thread_info(const thread_reference &thread_)
 	{
-		const auto id = get_native_id();
-		const auto thread = mach_thread_self();
-		const auto start_time = this_process::get_process_uptime();
+		const auto id = thread_.native_id;
+		const auto thread = pthread_mach_thread_np(reinterpret_cast<pthread_t>(thread_.handle));
+		const auto start_time = thread_.start_time;
 
 		return [id, thread, start_time] (thread_info &info) {
 			mach_msg_type_number_t count = THREAD_EXTENDED_INFO_COUNT;
@@ -68,4 +65,16 @@ namespace micro_profiler
 			info.cpu_time = mt::milliseconds((ti.pth_user_time + ti.pth_system_time) / 1000000);
 		};
 	}
+
+	unsigned long long this_thread::get_native_id()
+	{	return pthread_mach_thread_np(pthread_self());	}
+
+	thread_reference this_thread::get_reference()
+	{
+		const auto self = pthread_self();
+		thread_reference r = {	pthread_mach_thread_np(self), reinterpret_cast<uintptr_t>(self),
+			this_process::get_process_uptime()	};
+
+		return r;
+	}
 }
@@ -36,13 +36,10 @@ namespace micro_profiler
 		const HRESULT (WINAPI *c_GetThreadDescription)(HANDLE hThread, PWSTR *ppszThreadDescription)
 			= c_kernel32 / "GetThreadDescription";
 
-		shared_ptr<void> get_current_thread()
+		shared_ptr<void> open_thread(DWORD native_id)
 		{
-			HANDLE handle = NULL;
-
-			::DuplicateHandle(::GetCurrentProcess(), ::GetCurrentThread(), ::GetCurrentProcess(), &handle,
-				0, FALSE, DUPLICATE_SAME_ACCESS);
-			return shared_ptr<void>(handle, &CloseHandle);
+			const auto handle = ::OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, native_id);
+			return handle ? shared_ptr<void>(handle, &CloseHandle) : shared_ptr<void>();
 		}
 
 		mt::milliseconds get_process_start_time()
@@ -62,19 +59,16 @@ namespace micro_profiler
 		return to_milliseconds(t) - get_process_start_time();
 	}
 
-	unsigned long long this_thread::get_native_id()
-	{	return ::GetCurrentThreadId();	}
-
-	function<void (thread_info &info)> this_thread::open_info()
+	function<void (thread_info &info)> this_process::open_thread_info(const thread_reference &thread)
 	{
-		FILETIME thread_start, dummy;
-		const auto handle = get_current_thread();
-		const auto native_id = ::GetCurrentThreadId();
+		FILETIME thread_start = {}, dummy;
+		const auto native_id = static_cast<DWORD>(thread.native_id);
+		const auto handle = open_thread(native_id);
 		const auto start_time = to_milliseconds((::GetThreadTimes(handle.get(), &thread_start, &dummy, &dummy, &dummy),
 			thread_start)) - get_process_start_time();
 
 		return [handle, native_id, start_time] (thread_info &info) {
-			FILETIME dummy, user;
+			FILETIME dummy, user = {};
 			PWSTR description;
 
 			info.native_id = native_id;
@@ -85,4 +79,13 @@ namespace micro_profiler
 			info.cpu_time = to_milliseconds(user);
 		};
 	}
+
+	unsigned long long this_thread::get_native_id()
+	{	return ::GetCurrentThreadId();	}
+
+	thread_reference this_thread::get_reference()
+	{
+		thread_reference r = {	::GetCurrentThreadId(), 0, mt::milliseconds(0)	};
+		return r;
+	}
 }
@@ -22,55 +22,153 @@
 
 #include "process_explorer.h"
 
+#include <common/time.h>
 #include <mt/thread_callbacks.h>
 
 using namespace std;
 
 namespace micro_profiler
 {
+	thread_monitor::history_key::history_key()
+		: last_change(0), last_refresh(0)
+	{	}
+
+
 	thread_monitor::thread_monitor(mt::thread_callbacks &callbacks)
-		: _callbacks(callbacks), _next_id(0)
+		: _callbacks(callbacks), _generation(0), _pruned_generation(0), _uncollected_from(0)
 	{	}
 
 	thread_monitor::thread_id thread_monitor::register_self()
 	{
-		const auto id = this_thread::get_native_id();
+		if (const auto r = _registration_tls.get())
+			return r->id;
+
+		const auto index = _registrations.reserve();
+		const auto thread = this_thread::get_reference();
+		const auto id = static_cast<thread_id>(index);
+		auto &r = _registrations[index];
+		weak_ptr<thread_monitor> wself = shared_from_this();
+
+		r.id = id;
+		r.native_id = thread.native_id;
+		r.handle = thread.handle;
+		r.start_time = thread.start_time;
+		r.collected = false;
+		_registrations.publish(index);
+		_registration_tls.set(&r);
+		_callbacks.at_thread_exit([wself, id] {
+			if (const auto self = wself.lock())
+				self->thread_exited(id);
+		});
+		return id;
+	}
+
+	void thread_monitor::get_changes(history_key &key, vector<value_type> &changes) const
+	{
+		const auto now = clock();
+		const auto refresh = now - key.last_refresh >= live_refresh_interval;
 		mt::lock_guard<mt::mutex> lock(_mutex);
-		const auto i = _alive_threads.insert(make_pair(id, live_thread_info()));
-		auto &lti = i.first->second;
 
-		if (i.second)
+		collect_registrations();
+		changes.clear();
+		if (key.last_change < _pruned_generation)
+		{
+			// Some changes this key has not seen are gone - resynchronize completely.
+			for (auto i = _threads.begin(); i != _threads.end(); ++i)
+			{
+				changes.push_back(*i);
+				if (!i->second.complete)
+					update_live_info(changes.back().second, i->first);
+			}
+			key.last_refresh = now;
+		}
+		else
 		{
-			weak_ptr<thread_monitor> wself = shared_from_this();
-			thread_info ti = { id, string(), mt::milliseconds(0), mt::milliseconds(0), mt::milliseconds(0), false };
-
-			(lti.accessor = this_thread::open_info())(ti);
-			lti.thread_info_entry = &*_threads.insert(make_pair(_next_id++, ti)).first;
-			_callbacks.at_thread_exit([wself, id] {
-				if (const auto self = wself.lock())
-					self->thread_exited(id);
-			});
+			if (refresh)
+			{
+				for (auto i = _alive_threads.begin(); i != _alive_threads.end(); ++i)
+				{
+					changes.push_back(*i->second.thread_info_entry);
+					i->second.accessor(changes.back().second);
+				}
+				key.last_refresh = now;
+			}
+			for (auto i = _changes.upper_bound(key.last_change); i != _changes.end(); ++i)
+			{
+				if (refresh && _alive_threads.find(i->second) != _alive_threads.end())
+					continue; // Already reported by the refresh above.
+
+				const auto t = _threads.find(i->second);
+
+				changes.push_back(*t);
+				if (!t->second.complete)
+					update_live_info(changes.back().second, t->first);
+			}
 		}
-		return lti.thread_info_entry->first;
+		key.last_change = _generation;
 	}
 
-	void thread_monitor::update_live_info(thread_info &info, native_thread_id native_id) const
+	void thread_monitor::update_live_info(thread_info &info, thread_id id) const
 	{
-		const auto i = _alive_threads.find(native_id);
+		const auto i = _alive_threads.find(id);
 
 		if (i != _alive_threads.end())
 			i->second.accessor(info);
 	}
 
-	void thread_monitor::thread_exited(native_thread_id native_id)
+	void thread_monitor::collect_registrations() const
+	{
+		auto uncollected_from = _uncollected_from;
+
+		_registrations.for_each([this, &uncollected_from] (size_t index, registration &r) {
+			if (!r.collected)
+			{
+				const thread_reference thread = {	r.native_id, r.handle, r.start_time	};
+				thread_info ti = {	r.native_id, string(), mt::milliseconds(0), mt::milliseconds(0), mt::milliseconds(0),
+					false	};
+				auto &lti = _alive_threads[r.id];
+
+				(lti.accessor = this_process::open_thread_info(thread))(ti);
+				lti.thread_info_entry = &*_threads.insert(make_pair(r.id, ti)).first;
+				lti.last_change = add_change(r.id);
+				r.collected = true;
+			}
+			if (index == uncollected_from)
+				uncollected_from++;
+		}, _uncollected_from);
+		_uncollected_from = uncollected_from;
+	}
+
+	size_t thread_monitor::add_change(thread_id id) const
+	{
+		_changes.insert(make_pair(++_generation, id));
+		if (_changes.size() > max_changes)
+		{
+			_pruned_generation = _changes.begin()->first;
+			_changes.erase(_changes.begin());
+		}
+		return _generation;
+	}
+
+	void thread_monitor::thread_exited(thread_id id)
 	{
 		mt::lock_guard<mt::mutex> lock(_mutex);
-		const auto i = _alive_threads.find(native_id);
+
+		collect_registrations();
+
+		const auto i = _alive_threads.find(id);
 		auto &ti = i->second.thread_info_entry->second;
 
-		update_live_info(ti, native_id);
+		update_live_info(ti, id);
 		ti.end_time = this_process::get_process_uptime();
 		ti.complete = true;
+		_changes.erase(i->second.last_change); // A change not yet reported is superseded by the exit.
+		add_change(id);
 		_alive_threads.erase(i);
+		if (const auto r = _registration_tls.get())
+		{
+			if (r->id == id)
+				_registration_tls.set(nullptr);
+		}
 	}
 }
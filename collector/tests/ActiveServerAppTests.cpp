@@ -460,6 +460,85 @@ namespace micro_profiler
 				t.join();
 			}
 
+
+			test( SeveralSessionsAreServedSimultaneously )
+			{
+				// INIT
+				mt::event ready;
+				shared_ptr<void> req[2];
+				vector<int> log;
+
+				app_events.initializing = [] (server_session &s) {
+					s.add_handler(1717, [] (server_session::response &resp, int value) {	resp(1718, 17 * value);	});
+				};
+
+				active_server_app app(app_events);
+
+				app.connect(factory);
+				client_ready.wait();
+				auto client1 = client;
+				app.connect(factory);
+				client_ready.wait();
+
+				// ACT
+				client1->request(req[0], 1717, 19, 1718, [&] (deserializer &d) {
+					int value;
+
+					d(value), log.push_back(value), ready.set();
+				});
+				ready.wait();
+				client->request(req[1], 1717, 10, 1718, [&] (deserializer &d) {
+					int value;
+
+					d(value), log.push_back(value), ready.set();
+				});
+				ready.wait();
+
+				// ASSERT
+				int reference[] = {	323, 170,	};
+
+				assert_not_equal(client1, client);
+				assert_equal(reference, log);
+			}
+
+
+			test( StoppingServerWaitsForAllSessionsRequiringDisconnection )
+			{
+				// INIT
+				mt::event ready, stopped;
+				vector<server_session *> finalized;
+
+				app_events.finalizing = [&] (server_session &session) -> bool {
+					finalized.push_back(&session);
+					if (finalized.size() == 2)
+						ready.set();
+					return true;
+				};
+
+				unique_ptr<active_server_app> app(new active_server_app(app_events));
+
+				app->connect(factory);
+				client_ready.wait();
+				auto client1 = client;
+				app->connect(factory);
+				client_ready.wait();
+
+				// ACT
+				mt::thread t([&] {	app.reset(), stopped.set();	});
+				ready.wait();
+				client1->disconnect_session();
+
+				// ASSERT
+				assert_is_false(stopped.wait(mt::milliseconds(100)));
+
+				// ACT
+				client->disconnect_session();
+
+				// ASSERT (shall exit)
+				t.join();
+				assert_equal(2u, finalized.size());
+			}
+
 		end_test_suite
 	}
 }
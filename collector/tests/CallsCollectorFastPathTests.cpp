@@ -0,0 +1,269 @@
+#include <collector/calls_collector.h>
+
+#include "mocks.h"
+#include "mocks_allocator.h"
+
+#include <common/memory_manager.h>
+#include <csetjmp>
+#include <patcher/dynamic_hooking.h>
+#include <patcher/jump.h>
+#include <test-helpers/helpers.h>
+#include <ut/assert.h>
+#include <ut/test.h>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace tests
+	{
+#if defined(__x86_64__) && defined(__linux__)
+		namespace
+		{
+			const void *const c_exit = nullptr;
+
+			jmp_buf g_unwind_target;
+			int (*g_inner)(int value);
+			void (*g_jumping)(int value);
+
+			int increment(int value)
+			{	return value + 1;	}
+
+			int call_inner(int value)
+			{	return 2 * g_inner(value);	}
+
+			void jump_back(int value)
+			{	longjmp(g_unwind_target, value);	}
+
+			int catch_jump(int value)
+			{
+				if (!setjmp(g_unwind_target))
+					g_jumping(value);
+				return value + 3;
+			}
+
+			// Forwards to the collector, counting the calls made by the trampolines (the slow path).
+			struct counting_interceptor : noncopyable
+			{
+				counting_interceptor(calls_collector &collector_)
+					: collector(collector_), entries(0), exits(0)
+				{	}
+
+				static void on_enter(counting_interceptor *self, const void **stack_ptr, timestamp_t timestamp,
+					const void *callee)
+				{	self->entries++, calls_collector::on_enter(&self->collector, stack_ptr, timestamp, callee);	}
+
+				static const void *on_exit(counting_interceptor *self, const void **stack_ptr, timestamp_t timestamp)
+				{	return self->exits++, calls_collector::on_exit(&self->collector, stack_ptr, timestamp);	}
+
+				calls_collector &collector;
+				unsigned int entries, exits;
+			};
+
+			class fast_hook : noncopyable
+			{
+			public:
+				fast_hook(executable_memory_allocator &allocator_, const void *target, counting_interceptor &interceptor,
+						const fast_trace_layout &layout)
+					: _trampoline(allocator_.allocate(c_fast_trampoline_size + c_jump_size))
+				{
+					const auto at = static_cast<byte *>(_trampoline.get());
+
+					initialize_fast_trampoline(at, id(), &interceptor, layout);
+					jump_initialize(at + c_fast_trampoline_size, target);
+				}
+
+				const void *id() const
+				{	return _trampoline.get();	}
+
+				template <typename F>
+				F *as() const
+				{	return address_cast_hack<F *>(_trampoline.get());	}
+
+			private:
+				shared_ptr<void> _trampoline;
+			};
+
+			struct collection_acceptor : calls_collector_i::acceptor
+			{
+				virtual void accept_calls(unsigned /*threadid*/, const call_record *calls, size_t count) override
+				{
+					buffer_sizes.push_back(count);
+					collected.insert(collected.end(), calls, calls + count);
+				}
+
+				vector<const void *> callees() const
+				{
+					vector<const void *> result;
+
+					for (auto i = collected.begin(); i != collected.end(); ++i)
+						result.push_back(i->callee);
+					return result;
+				}
+
+				bool ascending() const
+				{
+					for (auto i = collected.begin(); i != collected.end() && i + 1 != collected.end(); ++i)
+					{
+						if ((i + 1)->timestamp < i->timestamp)
+							return false;
+					}
+					return true;
+				}
+
+				vector<size_t> buffer_sizes;
+				vector<call_record> collected;
+			};
+		}
+
+		begin_test_suite( CallsCollectorFastPathTests )
+			mocks::thread_monitor threads;
+			mocks::thread_callbacks tcallbacks;
+			mocks::allocator allocator_;
+			unique_ptr<calls_collector> collector;
+			unique_ptr<counting_interceptor> interceptor;
+			shared_ptr<executable_memory_allocator> trampolines;
+			fast_trace_layout layout;
+
+			init( Init )
+			{
+				memory_manager mm(virtual_memory::granularity());
+
+				collector.reset(new calls_collector(allocator_, 100 * buffering_policy::buffer_size, threads, tcallbacks));
+				interceptor.reset(new counting_interceptor(*collector));
+				trampolines = mm.create_executable_allocator(const_byte_range(address_cast_hack<const byte *>(&increment),
+					1), 32);
+
+				assert_is_true(collector->enable_fast_path(layout));
+			}
+
+			void read_collected(collection_acceptor &a)
+			{
+				collector->flush();
+				collector->read_collected(a);
+			}
+
+
+			test( CallsAndReturnsAreRecordedInlineOnceTheThreadHasATrace )
+			{
+				// INIT
+				fast_hook f(*trampolines, address_cast_hack<const void *>(&increment), *interceptor, layout);
+				collection_acceptor a;
+
+				// ACT
+				assert_equal(3, f.as<int (int)>()(2));
+				assert_equal(11, f.as<int (int)>()(10));
+				assert_equal(-6, f.as<int (int)>()(-7));
+				read_collected(a);
+
+				// ASSERT
+				assert_equal(plural + f.id() + c_exit + f.id() + c_exit + f.id() + c_exit, a.callees());
+				assert_is_true(a.ascending());
+				assert_equal(1u, interceptor->entries); // The first call registers the thread trace.
+				assert_equal(0u, interceptor->exits);
+			}
+
+
+			test( NestedCallsAreRecordedInline )
+			{
+				// INIT
+				fast_hook outer(*trampolines, address_cast_hack<const void *>(&call_inner), *interceptor, layout);
+				fast_hook inner(*trampolines, address_cast_hack<const void *>(&increment), *interceptor, layout);
+				collection_acceptor a;
+
+				g_inner = inner.as<int (int)>();
+
+				// ACT
+				assert_equal(12, outer.as<int (int)>()(5));
+				assert_equal(4, outer.as<int (int)>()(1));
+				read_collected(a);
+
+				// ASSERT
+				assert_equal(plural
+					+ outer.id() + inner.id() + c_exit + c_exit
+					+ outer.id() + inner.id() + c_exit + c_exit, a.callees());
+				assert_is_true(a.ascending());
+				assert_equal(1u, interceptor->entries);
+				assert_equal(0u, interceptor->exits);
+			}
+
+
+			test( TailCallsAreLeftToTheInterceptorAndRecordedAsExitAndEntry )
+			{
+				// INIT
+				fast_hook callee(*trampolines, address_cast_hack<const void *>(&increment), *interceptor, layout);
+				fast_hook caller(*trampolines, callee.id(), *interceptor, layout);
+				collection_acceptor a;
+
+				// ACT
+				assert_equal(2, caller.as<int (int)>()(1));
+				assert_equal(8, caller.as<int (int)>()(7));
+				read_collected(a);
+
+				// ASSERT
+				assert_equal(plural
+					+ caller.id() + c_exit + callee.id() + c_exit
+					+ caller.id() + c_exit + callee.id() + c_exit, a.callees());
+				assert_is_true(a.ascending());
+				assert_equal(3u, interceptor->entries);
+				assert_equal(0u, interceptor->exits);
+			}
+
+
+			test( RecordsCompletingABufferAreLeftToTheInterceptor )
+			{
+				// INIT
+				const auto n = 1000u;
+				fast_hook f(*trampolines, address_cast_hack<const void *>(&increment), *interceptor, layout);
+				collection_acceptor a;
+				vector<const void *> reference;
+
+				for (auto i = 0u; i != n; ++i)
+					reference.push_back(f.id()), reference.push_back(c_exit);
+
+				// ACT
+				for (auto i = 0u; i != n; ++i)
+					f.as<int (int)>()(static_cast<int>(i));
+				read_collected(a);
+
+				// ASSERT
+				assert_equal(reference, a.callees());
+				assert_is_true(a.ascending());
+				assert_equal(6u, a.buffer_sizes.size());
+				assert_equal(buffering_policy::buffer_size, a.buffer_sizes[0]);
+				assert_equal(buffering_policy::buffer_size, a.buffer_sizes[4]);
+				assert_equal(2 * n - 5 * buffering_policy::buffer_size, a.buffer_sizes[5]);
+				assert_equal(1u, interceptor->entries);
+				assert_equal(5u, interceptor->exits); // Buffers are always completed by exits, as they are even-sized.
+			}
+
+
+			test( FramesSkippedByUnwindingAreExitedOnReturnOfTheirCaller )
+			{
+				// INIT
+				fast_hook outer(*trampolines, address_cast_hack<const void *>(&catch_jump), *interceptor, layout);
+				fast_hook inner(*trampolines, address_cast_hack<const void *>(&jump_back), *interceptor, layout);
+				fast_hook f(*trampolines, address_cast_hack<const void *>(&increment), *interceptor, layout);
+				collection_acceptor a;
+
+				g_jumping = inner.as<void (int)>();
+
+				// ACT
+				assert_equal(4, outer.as<int (int)>()(1));
+				assert_equal(5, outer.as<int (int)>()(2));
+				assert_equal(8, f.as<int (int)>()(7));
+				read_collected(a);
+
+				// ASSERT
+				assert_equal(plural
+					+ outer.id() + inner.id() + c_exit + c_exit
+					+ outer.id() + inner.id() + c_exit + c_exit
+					+ f.id() + c_exit, a.callees());
+				assert_is_true(a.ascending());
+				assert_equal(1u, interceptor->entries);
+				assert_equal(2u, interceptor->exits);
+			}
+		end_test_suite
+#endif
+	}
+}
@@ -448,10 +448,12 @@ namespace micro_profiler
 				// INIT
 				calls_collector c1(allocator_, 100u * buffering_policy::buffer_size, threads, tcallbacks);
 				calls_collector c2(allocator_, 100u * buffering_policy::buffer_size, threads, tcallbacks);
+				collection_acceptor a;
 
 				// ACT
 				c1.set_buffering_policy(buffering_policy(100u * buffering_policy::buffer_size, 1, 0.19001));
 				c1.track(123, (void *)123412345);
+				c1.read_collected(a);
 
 				// ASSERT
 				assert_equal(20u, allocator_.allocated);
@@ -459,6 +461,7 @@ namespace micro_profiler
 				// ACT
 				c2.set_buffering_policy(buffering_policy(100u * buffering_policy::buffer_size, 1, 0.37001));
 				c2.track(123, (void *)123412345);
+				c2.read_collected(a);
 
 				// ASSERT
 				assert_equal(58u, allocator_.allocated);
@@ -469,9 +472,12 @@ namespace micro_profiler
 			{
 				// INIT
 				calls_collector c(allocator_, 1000u * buffering_policy::buffer_size, threads, tcallbacks);
+				collection_acceptor a;
 
-				// ACT
 				c.track(123, (void *)123412345);
+				c.read_collected(a);
+
+				// ACT
 				c.set_buffering_policy(buffering_policy(100u * buffering_policy::buffer_size, 0.10001, 0));
 
 				// ASSERT
@@ -584,6 +584,12 @@ namespace micro_profiler
 				// INIT / ACT
 					calls_collector_thread c(a2, bp(13u), 1u);
 
+				// ASSERT
+					assert_equal(1u, a2.allocated);
+
+				// ACT
+					c.read_collected([] (...) {});
+
 				// ASSERT
 					assert_equal(13u, a2.allocated);
 
@@ -596,6 +602,8 @@ namespace micro_profiler
 				// INIT / ACT
 				calls_collector_thread c(a2, bp(17u), 1u);
 
+				c.read_collected([] (...) {});
+
 				// ASSERT
 				assert_equal(17u, a2.allocated);
 			}
@@ -623,6 +631,9 @@ namespace micro_profiler
 				mocks::allocator al1, al2;
 				calls_collector_thread c1(al1, bp(100u), 1u), c2(al2, bp(100u), 1u);
 
+				c1.read_collected([] (...) {});
+				c2.read_collected([] (...) {});
+
 				// ACT
 				c1.set_buffering_policy(buffering_policy(required_size(100u), 0.31001, 0));
 				c2.set_buffering_policy(buffering_policy(required_size(100u), 0.78001, 0));
@@ -639,6 +650,7 @@ namespace micro_profiler
 				mocks::allocator al;
 				calls_collector_thread c(al, bp(100u), 1u);
 
+				c.read_collected([] (...) {});
 				fill(c, buffering_policy::buffer_size * 7);
 
 				// ACT
@@ -670,7 +682,7 @@ namespace micro_profiler
 			}
 
 
-			test( LowWaterFreeBuffersAreCreatedOnConstructions )
+			test( OnlyActiveBufferIsCreatedOnConstruction )
 			{
 				// INIT
 				mocks::allocator al1, al2;
@@ -679,6 +691,23 @@ namespace micro_profiler
 				calls_collector_thread c1(al1, buffering_policy(required_size(100u), 1, 0.11001), 1u),
 					c2(al2, buffering_policy(required_size(100u), 1, 0.31001), 1u);
 
+				// ASSERT
+				assert_equal(1u, al1.allocated);
+				assert_equal(1u, al2.allocated);
+			}
+
+
+			test( LowWaterFreeBuffersAreCreatedOnFirstReading )
+			{
+				// INIT
+				mocks::allocator al1, al2;
+				calls_collector_thread c1(al1, buffering_policy(required_size(100u), 1, 0.11001), 1u),
+					c2(al2, buffering_policy(required_size(100u), 1, 0.31001), 1u);
+
+				// ACT
+				c1.read_collected([] (...) {});
+				c2.read_collected([] (...) {});
+
 				// ASSERT
 				assert_equal(1u + 11u, al1.allocated);
 				assert_equal(1u + 31u, al2.allocated);
@@ -692,6 +721,8 @@ namespace micro_profiler
 				calls_collector_thread c1(al1, buffering_policy(required_size(100u), 1, 0.11001), 1u),
 					c2(al2, buffering_policy(required_size(100u), 1, 0.31001), 1u);
 
+				c1.read_collected([] (...) {});
+				c2.read_collected([] (...) {});
 				al1.operations = al2.operations = 0u;
 
 				// ACT
@@ -711,6 +742,8 @@ namespace micro_profiler
 				calls_collector_thread c1(al1, buffering_policy(required_size(100u), 1, 0.11001), 1u),
 					c2(al2, buffering_policy(required_size(100u), 1, 0.31001), 1u);
 
+				c1.read_collected([] (...) {});
+				c2.read_collected([] (...) {});
 				al1.operations = al2.operations = 0u;
 				fill(c1, 3u * buffering_policy::buffer_size);
 				fill(c2, 7u * buffering_policy::buffer_size);
@@ -282,6 +282,161 @@ namespace micro_profiler
 				assert_equal(rresults2, log.back());
 			}
 
+
+			test( PatchPauseIsForwardedAndResultsAreReturned )
+			{
+				// INIT
+				collector_app app(collector, c_overhead, threads, *module_tracker, *pmanager);
+				shared_ptr<void> rq;
+				unsigned rva[] = {	100u, 3110u,	};
+				auto presults = plural
+					+ mkpatch_change(rva[0], patch_change_result::ok, 1)
+					+ mkpatch_change(rva[1], patch_change_result::unchanged, 2);
+				vector<unsigned> ids_log;
+				vector< vector<unsigned> > rva_log;
+				vector<bool> paused_log;
+				vector<patch_change_results> log;
+				mt::event ready;
+
+				app.connect(factory, false);
+				client_ready.wait();
+				pmanager->on_pause = [&] (patch_change_results &results, unsigned module_id,
+					patch_manager::revert_request_range tgts, bool paused) {
+
+					ids_log.push_back(module_id);
+					rva_log.push_back(vector<unsigned>(tgts.begin(), tgts.end()));
+					paused_log.push_back(paused);
+					results = presults;
+				};
+
+				// ACT
+				const patch_pause_request preq1 = {	2u, mkvector(rva), true	};
+				client->request(rq, request_pause_patches, preq1, response_paused, [&] (deserializer &d) {
+					log.resize(log.size() + 1);
+					d(log.back());
+					ready.set();
+				});
+				ready.wait();
+
+				// ASSERT
+				assert_equal(plural + 2u, ids_log);
+				assert_equal(rva, rva_log.back());
+				assert_equal(plural + true, paused_log);
+				assert_equal(presults, log.back());
+
+				// ACT
+				const patch_pause_request preq2 = {	1u, mkvector(rva), false	};
+				client->request(rq, request_pause_patches, preq2, response_paused, [&] (deserializer &d) {
+					log.resize(log.size() + 1);
+					d(log.back());
+					ready.set();
+				});
+				ready.wait();
+
+				// ASSERT
+				assert_equal(plural + 2u + 1u, ids_log);
+				assert_equal(rva, rva_log.back());
+				assert_equal(plural + true + false, paused_log);
+			}
+
+			test( CountOnlyPatchesAreAppliedOnRequestAndTheirCountersAreReportedInUpdates )
+			{
+				// INIT
+				collector_app app(collector, c_overhead, threads, *module_tracker, *pmanager);
+				shared_ptr<void> rq;
+				auto rva = plural + make_pair(100u, 11u) + make_pair(3110u, 13u);
+				patch_counter counters[] = {	{	3u, 100u, 17u	}, {	3u, 3110u, 1u	},	};
+				vector< vector<patch_manager::apply_request> > rva_log;
+				auto profiled = 0;
+				patch_counters received;
+				mt::event ready;
+
+				app.connect(factory, false);
+				client_ready.wait();
+				pmanager->on_apply = [&] (patch_change_results &, unsigned, patch_manager::apply_request_range) {
+					profiled++;
+				};
+				pmanager->on_apply_counters = [&] (patch_change_results &, unsigned module_id,
+					patch_manager::apply_request_range targets) {
+
+					assert_equal(3u, module_id);
+					rva_log.push_back(vector<patch_manager::apply_request>(targets.begin(), targets.end()));
+				};
+				pmanager->on_read_counters = [&] (patch_counters &counters_) {
+					counters_ = mkvector(counters);
+				};
+
+				// ACT
+				const patch_apply_request preq = {	3u, rva, true	};
+				client->request(rq, request_apply_patches, preq, response_patched, [&] (deserializer &) {
+					ready.set();
+				});
+				ready.wait();
+
+				// ASSERT
+				assert_equal(0, profiled);
+				assert_equal(plural + rva, rva_log);
+
+				// ACT
+				client->request(rq, request_update, 0, response_patch_counters, [&] (deserializer &d) {
+					d(received);
+					ready.set();
+				});
+				ready.wait();
+
+				// ASSERT
+				assert_equal(2u, received.size());
+				assert_equal(17u, received[0].calls);
+				assert_equal(3110u, received[1].rva);
+				assert_equal(1u, received[1].calls);
+			}
+
+
+			test( ModulePatchesAreAppliedAsCountersWhenRequested )
+			{
+				// INIT
+				collector_app app(collector, c_overhead, threads, *module_tracker, *pmanager);
+				shared_ptr<void> rq;
+				vector<unsigned> profiled, counted;
+				mt::event ready;
+
+				app.connect(factory, false);
+				client_ready.wait();
+				pmanager->on_apply = [&] (patch_change_results &, unsigned module_id, patch_manager::apply_request_range) {
+					profiled.push_back(module_id);
+				};
+				pmanager->on_apply_counters = [&] (patch_change_results &, unsigned module_id,
+					patch_manager::apply_request_range targets) {
+
+					assert_is_false(targets.begin() == targets.end());
+					counted.push_back(module_id);
+				};
+				module_helper.emulate_mapped(*img1);
+
+				// ACT
+				module_patch_request mpreq = {	1u, 0u, 0u, string(), false, 0u, true	};
+				client->request(rq, request_apply_module_patches, mpreq, response_module_patched, [&] (deserializer &) {
+					ready.set();
+				});
+				ready.wait();
+
+				// ASSERT
+				assert_is_empty(profiled);
+				assert_equal(plural + 1u, counted);
+
+				// INIT
+				mpreq.count_only = false;
+
+				// ACT
+				client->request(rq, request_apply_module_patches, mpreq, response_module_patched, [&] (deserializer &) {
+					ready.set();
+				});
+				ready.wait();
+
+				// ASSERT
+				assert_equal(plural + 1u, profiled);
+				assert_equal(plural + 1u, counted);
+			}
 		end_test_suite
 	}
 }
@@ -105,6 +105,7 @@ namespace micro_profiler
 				assert_is_false(!!id.injected);
 				assert_equal(unique_name, id.executable);
 				assert_approx_equal(ticks_per_second(), id.ticks_per_second, 0.05);
+				assert_equal((unsigned)protocol_current, id.protocol);
 			}
 
 
@@ -664,6 +665,359 @@ namespace micro_profiler
 				assert_equal(reference2, threads_);
 			}
 
+
+			test( AnalyzedStatisticsArePushedToSubscribedClientWithinCreditWindow )
+			{
+				// INIT
+				mt::event ready, pushed;
+				vector<thread_statistics_map> updates;
+				mt::mutex mtx;
+				vector<call_record> trace;
+				shared_ptr<void> req, req_credit;
+				call_record trace1[] = {
+					{	0, (void *)0x1223	},
+					{	1000 + c_overhead.inner, (void *)0	},
+				};
+				call_record trace2[] = {
+					{	10000, (void *)0x31223	},
+					{	14000 + c_overhead.inner, (void *)0	},
+				};
+				const update_subscription subscription = {	0, 0, 1	};
+				const update_credit credit = {	1	};
+
+				initialize_client = [&] (client_session &c) {
+					c.subscribe(new_subscription(), statistics_pushed, [&] (deserializer &d) {
+						loaded_modules l;
+						vector< pair<unsigned, thread_info> > t;
+						thread_statistics_map s;
+
+						d(l);
+						d(t);
+						d(s);
+						updates.push_back(s);
+						pushed.set();
+					});
+				};
+				collector.on_read_collected = [&] (calls_collector_i::acceptor &a) {
+					mt::lock_guard<mt::mutex> l(mtx);
+
+					if (trace.empty())
+						return;
+					a.accept_calls(11710u, &trace[0], trace.size());
+					trace.clear();
+					ready.set();
+				};
+
+				collector_app app(collector, c_overhead, threads, *module_tracker, *pmanager);
+
+				app.connect(factory, false);
+				client_ready.wait();
+
+				// ACT
+				client->request(req, request_subscribe_updates, subscription, no_response, [] (deserializer &) {	});
+				{	mt::lock_guard<mt::mutex> l(mtx);	trace.assign(trace1, trace1 + 2);	}
+				pushed.wait();
+
+				// ASSERT
+				addressed_statistics reference1[] = {
+					make_statistics(0x1223u, 1, 0, 1000, 1000, 1000),
+				};
+
+				assert_equal(1u, updates.size());
+				assert_equivalent(reference1, *find_by_first(updates[0], 11710u));
+
+				// ACT
+				{	mt::lock_guard<mt::mutex> l(mtx);	trace.assign(trace2, trace2 + 2);	}
+				ready.wait();
+
+				// ASSERT (the window is exhausted)
+				assert_is_false(pushed.wait(mt::milliseconds(100)));
+
+				// ACT
+				client->request(req_credit, request_update_credit, credit, no_response, [] (deserializer &) {	});
+				pushed.wait();
+
+				// ASSERT
+				addressed_statistics reference2[] = {
+					make_statistics(0x31223u, 1, 0, 4000, 4000, 4000),
+				};
+
+				assert_equal(2u, updates.size());
+				assert_equivalent(reference2, *find_by_first(updates[1], 11710u));
+			}
+
+
+			test( PushesAreWithheldOnceTheByteBudgetIsSpent )
+			{
+				// INIT
+				mt::event ready, pushed;
+				unsigned int updates = 0;
+				mt::mutex mtx;
+				vector<call_record> trace;
+				shared_ptr<void> req;
+				call_record trace1[] = {
+					{	0, (void *)0x1223	},
+					{	1000 + c_overhead.inner, (void *)0	},
+				};
+				call_record trace2[] = {
+					{	10000, (void *)0x31223	},
+					{	14000 + c_overhead.inner, (void *)0	},
+				};
+				const update_subscription subscription = {	0, 1 /*byte/s*/, 10	};
+
+				initialize_client = [&] (client_session &c) {
+					c.subscribe(new_subscription(), statistics_pushed, [&] (deserializer &) {
+						updates++;
+						pushed.set();
+					});
+				};
+				collector.on_read_collected = [&] (calls_collector_i::acceptor &a) {
+					mt::lock_guard<mt::mutex> l(mtx);
+
+					if (trace.empty())
+						return;
+					a.accept_calls(11710u, &trace[0], trace.size());
+					trace.clear();
+					ready.set();
+				};
+
+				collector_app app(collector, c_overhead, threads, *module_tracker, *pmanager);
+
+				app.connect(factory, false);
+				client_ready.wait();
+
+				// ACT
+				client->request(req, request_subscribe_updates, subscription, no_response, [] (deserializer &) {	});
+				{	mt::lock_guard<mt::mutex> l(mtx);	trace.assign(trace1, trace1 + 2);	}
+				pushed.wait();
+				{	mt::lock_guard<mt::mutex> l(mtx);	trace.assign(trace2, trace2 + 2);	}
+				ready.wait();
+
+				// ASSERT (the first push has cost more than a byte, the window is still open)
+				assert_is_false(pushed.wait(mt::milliseconds(100)));
+				assert_equal(1u, updates);
+			}
+
+
+			test( ThreadChangesArePiggybackedOntoUpdates )
+			{
+				// INIT
+				mt::event ready;
+				shared_ptr<void> req;
+				vector< pair<unsigned /*thread_id*/, thread_info> > threads_;
+				thread_info ti[] = {
+					{ 1221, "thread 1", mt::milliseconds(190212), mt::milliseconds(0), mt::milliseconds(1902), false },
+					{ 17171, "thread #3", mt::milliseconds(112), mt::milliseconds(3000), mt::milliseconds(900), true },
+				};
+
+				threads.add_info(1 /*thread_id*/, ti[0]);
+
+				collector_app app(collector, c_overhead, threads, *module_tracker, *pmanager);
+
+				app.connect(factory, false);
+				client_ready.wait();
+
+				// ACT
+				client->request(req, request_update, 0, response_threads_info, [&] (deserializer &d) {
+					d(threads_);
+					ready.set();
+				});
+				ready.wait();
+
+				// ASSERT
+				pair<thread_monitor::thread_id, thread_info> reference1[] = {
+					make_pair(1, ti[0]),
+				};
+
+				assert_equal(reference1, threads_);
+
+				// INIT
+				threads.add_info(19 /*thread_id*/, ti[1]);
+
+				// ACT
+				client->request(req, request_update, 0, response_threads_info, [&] (deserializer &d) {
+					d(threads_);
+					ready.set();
+				});
+				ready.wait();
+
+				// ASSERT
+				pair<thread_monitor::thread_id, thread_info> reference2[] = {
+					make_pair(19, ti[1]),
+				};
+
+				assert_equal(reference2, threads_);
+			}
+
+
+			test( EachSessionReceivesAllAnalyzedStatisticsSinceItsLastUpdate )
+			{
+				// INIT
+				mt::event ready, updated;
+				thread_statistics_map update;
+				mt::mutex mtx;
+				unsigned int tid;
+				vector<call_record> trace;
+				shared_ptr<void> req;
+				call_record trace1[] = {
+					{	0, (void *)0x1223	},
+					{	1000 + c_overhead.inner, (void *)0	},
+				};
+				call_record trace2[] = {
+					{	10000, (void *)0x31223	},
+					{	14000 + c_overhead.inner, (void *)0	},
+				};
+				const auto request_update_ = [&] (client_session &c) {
+					c.request(req, request_update, 0, response_statistics_update, [&] (deserializer &d) {
+						update.clear();
+						d(update);
+						updated.set();
+					});
+					updated.wait();
+				};
+
+				collector.on_read_collected = [&] (calls_collector_i::acceptor &a) {
+					mt::lock_guard<mt::mutex> l(mtx);
+
+					if (trace.empty())
+						return;
+					a.accept_calls(tid, &trace[0], trace.size());
+					trace.clear();
+					ready.set();
+				};
+
+				collector_app app(collector, c_overhead, threads, *module_tracker, *pmanager);
+
+				app.connect(factory, false);
+				client_ready.wait();
+				auto client1 = client;
+				app.connect(factory, false);
+				client_ready.wait();
+				auto client2 = client;
+
+				{	mt::lock_guard<mt::mutex> l(mtx);	tid = 11710u, trace.assign(trace1, trace1 + 2);	}
+				ready.wait();
+
+				// ACT
+				request_update_(*client1);
+
+				// ASSERT
+				addressed_statistics reference1[] = {
+					make_statistics(0x1223u, 1, 0, 1000, 1000, 1000),
+				};
+				addressed_statistics reference2[] = {
+					make_statistics(0x31223u, 1, 0, 4000, 4000, 4000),
+				};
+
+				assert_not_null(find_by_first(update, 11710u));
+				assert_equivalent(reference1, *find_by_first(update, 11710u));
+
+				// INIT
+				{	mt::lock_guard<mt::mutex> l(mtx);	tid = 11713u, trace.assign(trace2, trace2 + 2);	}
+				ready.wait();
+
+				// ACT
+				request_update_(*client2);
+
+				// ASSERT
+				assert_not_null(find_by_first(update, 11710u));
+				assert_equivalent(reference1, *find_by_first(update, 11710u));
+				assert_not_null(find_by_first(update, 11713u));
+				assert_equivalent(reference2, *find_by_first(update, 11713u));
+
+				// ACT
+				request_update_(*client1);
+
+				// ASSERT
+				assert_null(find_by_first(update, 11710u));
+				assert_not_null(find_by_first(update, 11713u));
+				assert_equivalent(reference2, *find_by_first(update, 11713u));
+
+				// ACT
+				request_update_(*client2);
+
+				// ASSERT
+				assert_not_null(find_by_first(update, 11710u));
+				assert_not_null(find_by_first(update, 11713u));
+				assert_is_empty(*find_by_first(update, 11710u));
+				assert_is_empty(*find_by_first(update, 11713u));
+			}
+
+
+			test( StatisticsAreNotAccumulatedForIdleSessions )
+			{
+				// INIT
+				mt::event ready, updated;
+				thread_statistics_map update;
+				mt::mutex mtx;
+				unsigned int tid;
+				vector<call_record> trace;
+				shared_ptr<void> req;
+				call_record trace1[] = {
+					{	0, (void *)0x1223	},
+					{	1000 + c_overhead.inner, (void *)0	},
+				};
+				call_record trace2[] = {
+					{	10000, (void *)0x31223	},
+					{	14000 + c_overhead.inner, (void *)0	},
+				};
+				const auto request_update_ = [&] (client_session &c) {
+					c.request(req, request_update, 0, response_statistics_update, [&] (deserializer &d) {
+						update.clear();
+						d(update);
+						updated.set();
+					});
+					updated.wait();
+				};
+
+				collector.on_read_collected = [&] (calls_collector_i::acceptor &a) {
+					mt::lock_guard<mt::mutex> l(mtx);
+
+					if (trace.empty())
+						return;
+					a.accept_calls(tid, &trace[0], trace.size());
+					trace.clear();
+					ready.set();
+				};
+
+				collector_app app(collector, c_overhead, threads, *module_tracker, *pmanager, mt::milliseconds(200));
+
+				app.connect(factory, false);
+				client_ready.wait();
+				auto client1 = client;
+				app.connect(factory, false);
+				client_ready.wait();
+				auto client2 = client;
+
+				mt::this_thread::sleep_for(mt::milliseconds(300));
+				{	mt::lock_guard<mt::mutex> l(mtx);	tid = 11710u, trace.assign(trace1, trace1 + 2);	}
+				ready.wait();
+
+				// ACT
+				request_update_(*client1);
+				request_update_(*client2);
+
+				// ASSERT
+				assert_not_null(find_by_first(update, 11710u));
+				assert_is_empty(*find_by_first(update, 11710u));
+
+				// INIT
+				{	mt::lock_guard<mt::mutex> l(mtx);	tid = 11713u, trace.assign(trace2, trace2 + 2);	}
+				ready.wait();
+
+				// ACT (the second session has polled recently)
+				request_update_(*client1);
+				request_update_(*client2);
+
+				// ASSERT
+				addressed_statistics reference2[] = {
+					make_statistics(0x31223u, 1, 0, 4000, 4000, 4000),
+				};
+
+				assert_not_null(find_by_first(update, 11713u));
+				assert_equivalent(reference2, *find_by_first(update, 11713u));
+			}
+
 		end_test_suite
 	}
 }
@@ -0,0 +1,267 @@
+#include <collector/metadata_cache.h>
+
+#include <common/file_stream.h>
+#include <common/path.h>
+#include <common/protocol.h>
+#include <map>
+#include <test-helpers/comparisons.h>
+#include <test-helpers/file_helpers.h>
+#include <test-helpers/helpers.h>
+#include <ut/assert.h>
+#include <ut/test.h>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace tests
+	{
+		namespace
+		{
+			module_info_metadata make_metadata(unsigned int hash)
+			{
+				symbol_info symbols[] = {
+					{	"foo", 0x1000, 13, 1, 17	},
+					{	"vale_of_mean_creatures::this_one_for_the_birds()", 0x1020, 130, 2, 171	},
+					{	"bar", 0x2000, 1, 0, 0	},
+				};
+				module_info_metadata md;
+
+				md.symbols.assign(begin(symbols), end(symbols));
+				md.source_files[1] = "c:/dev/foo.cpp";
+				md.source_files[2] = "/usr/src/birds.cpp";
+				md.path = "/usr/lib/libfoo.so";
+				md.hash = hash;
+				return md;
+			}
+
+			string identity(unsigned int hash)
+			{
+				byte build_id[] = {	0x19, 0x73, static_cast<byte>(hash >> 8), static_cast<byte>(hash)	};
+
+				return metadata_cache::identify(mkvector(build_id), string());
+			}
+		}
+
+		begin_test_suite( MetadataCacheTests )
+			temporary_directory dir;
+
+			init( TrackEntries )
+			{
+				dir.track_file("image-a.so");
+				dir.track_file("image-b.so");
+				dir.track_file("metadata-12345678.cache");
+				dir.track_file("metadata-12345678-m.cache");
+				dir.track_file("metadata-ABCDEF01.cache");
+			}
+
+
+			test( NothingIsLoadedFromEmptyCache )
+			{
+				// INIT
+				metadata_cache c(dir.path());
+				module_info_metadata md;
+
+				// ACT / ASSERT
+				assert_is_false(c.load(md, 0x12345678u, identity(0x12345678u), true));
+				assert_is_false(c.load(md, 0x12345678u, identity(0x12345678u), false));
+			}
+
+
+			test( StoredMetadataIsLoadedByHash )
+			{
+				// INIT
+				metadata_cache c(dir.path());
+				const auto md1 = make_metadata(0x12345678u);
+				const auto md2 = make_metadata(0xABCDEF01u);
+				module_info_metadata loaded;
+
+				// ACT
+				c.store(md1, identity(0x12345678u), true);
+
+				// ACT / ASSERT
+				assert_is_true(c.load(loaded, 0x12345678u, identity(0x12345678u), true));
+
+				// ASSERT
+				assert_equal(md1.symbols, loaded.symbols);
+				assert_equal((map<unsigned, string>(md1.source_files.begin(), md1.source_files.end())),
+					(map<unsigned, string>(loaded.source_files.begin(), loaded.source_files.end())));
+				assert_equal(0x12345678u, loaded.hash);
+				assert_is_false(c.load(loaded, 0xABCDEF01u, identity(0xABCDEF01u), true));
+
+				// ACT
+				c.store(md2, identity(0xABCDEF01u), true);
+
+				// ACT / ASSERT
+				assert_is_true(c.load(loaded, 0xABCDEF01u, identity(0xABCDEF01u), true));
+				assert_equal(0xABCDEF01u, loaded.hash);
+			}
+
+
+			test( EntriesAreSeparatedByDemanglingMode )
+			{
+				// INIT
+				metadata_cache c(dir.path());
+				auto md = make_metadata(0x12345678u);
+				module_info_metadata loaded;
+
+				c.store(md, identity(0x12345678u), true);
+
+				// ACT / ASSERT
+				assert_is_false(c.load(loaded, 0x12345678u, identity(0x12345678u), false));
+
+				// INIT
+				md.symbols[1].name = "_ZN22vale_of_mean_creatures22this_one_for_the_birdsEv";
+
+				// ACT
+				c.store(md, identity(0x12345678u), false);
+
+				// ASSERT
+				assert_is_true(c.load(loaded, 0x12345678u, identity(0x12345678u), false));
+				assert_equal("_ZN22vale_of_mean_creatures22this_one_for_the_birdsEv", loaded.symbols[1].name);
+				assert_is_true(c.load(loaded, 0x12345678u, identity(0x12345678u), true));
+				assert_equal("vale_of_mean_creatures::this_one_for_the_birds()", loaded.symbols[1].name);
+			}
+
+
+			test( CacheIsSharedBetweenInstancesOverTheSameDirectory )
+			{
+				// INIT
+				const auto md = make_metadata(0x12345678u);
+				module_info_metadata loaded;
+
+				metadata_cache(dir.path()).store(md, identity(0x12345678u), true);
+
+				// ACT / ASSERT
+				assert_is_true(metadata_cache(dir.path()).load(loaded, 0x12345678u, identity(0x12345678u), true));
+				assert_equal(md.symbols, loaded.symbols);
+			}
+
+
+			test( DamagedEntriesAreNotLoaded )
+			{
+				// INIT
+				metadata_cache c(dir.path());
+				const auto md = make_metadata(0x12345678u);
+				module_info_metadata loaded;
+				const char garbage[] = "0123456789ABCDEF";
+
+				c.store(md, identity(0x12345678u), true);
+				write_file_stream(dir.path() & "metadata-12345678.cache").write(garbage, 7);
+
+				// ACT / ASSERT
+				assert_is_false(c.load(loaded, 0x12345678u, identity(0x12345678u), true));
+
+				// ASSERT (the damaged entry is gone)
+				assert_throws(read_file_stream(dir.path() & "metadata-12345678.cache"), exception);
+			}
+
+
+			test( TruncatedEntriesAreNotLoadedAndAreRemoved )
+			{
+				// INIT
+				metadata_cache c(dir.path());
+				const auto md = make_metadata(0x12345678u);
+				const auto path = dir.path() & "metadata-12345678.cache";
+				module_info_metadata loaded;
+				vector<byte> content(1000);
+
+				c.store(md, identity(0x12345678u), true);
+				content.resize(read_file_stream(path).read_l(content.data(), content.size()) - 10);
+				write_file_stream(path).write(content.data(), content.size());
+
+				// ACT / ASSERT
+				assert_is_false(c.load(loaded, 0x12345678u, identity(0x12345678u), true));
+				assert_throws(read_file_stream{path}, exception);
+
+				// INIT
+				c.store(md, identity(0x12345678u), true);
+
+				// ACT / ASSERT
+				assert_is_true(c.load(loaded, 0x12345678u, identity(0x12345678u), true));
+			}
+
+
+			test( EntryIsNotServedToAnotherImageWithTheSameHash )
+			{
+				// INIT
+				metadata_cache c(dir.path());
+				const auto md = make_metadata(0x12345678u);
+				module_info_metadata loaded;
+
+				c.store(md, identity(0x12345678u), true);
+
+				// ACT / ASSERT
+				assert_is_false(c.load(loaded, 0x12345678u, identity(0x12345679u), true));
+				assert_is_false(c.load(loaded, 0x12345678u, metadata_cache::identify(vector<byte>(), md.path), true));
+				assert_is_true(c.load(loaded, 0x12345678u, identity(0x12345678u), true));
+			}
+
+
+			test( ImagesAreIdentifiedByBuildIDOrByPathSizeAndModificationTime )
+			{
+				// INIT
+				byte build_id1[] = {	0x10, 0x20, 0xF1,	};
+				byte build_id2[] = {	0x10, 0x20, 0xF2,	};
+				const auto path_a = dir.path() & "image-a.so";
+				const auto path_b = dir.path() & "image-b.so";
+
+				write_file_stream(path_a).write("abcdef", 6);
+				write_file_stream(path_b).write("abcdef", 6);
+
+				// ACT / ASSERT
+				assert_equal(metadata_cache::identify(mkvector(build_id1), path_a),
+					metadata_cache::identify(mkvector(build_id1), path_b));
+				assert_not_equal(metadata_cache::identify(mkvector(build_id1), path_a),
+					metadata_cache::identify(mkvector(build_id2), path_a));
+
+				// ACT
+				const auto identity_a = metadata_cache::identify(vector<byte>(), path_a);
+
+				// ASSERT
+				assert_equal(identity_a, metadata_cache::identify(vector<byte>(), path_a));
+				assert_not_equal(identity_a, metadata_cache::identify(vector<byte>(), path_b));
+				assert_not_equal(identity_a, metadata_cache::identify(mkvector(build_id1), path_a));
+
+				// INIT
+				write_file_stream(path_a).write("abcdefgh", 8);
+
+				// ACT / ASSERT
+				assert_not_equal(identity_a, metadata_cache::identify(vector<byte>(), path_a));
+			}
+
+
+			test( OlderEntriesAreEvictedOnceCacheExceedsItsSize )
+			{
+				// INIT
+				metadata_cache c(dir.path(), 1);
+				const auto md1 = make_metadata(0x12345678u);
+				const auto md2 = make_metadata(0xABCDEF01u);
+				module_info_metadata loaded;
+
+				// ACT
+				c.store(md1, identity(0x12345678u), true);
+
+				// ASSERT
+				assert_is_true(c.load(loaded, 0x12345678u, identity(0x12345678u), true));
+
+				// ACT
+				c.store(md2, identity(0xABCDEF01u), true);
+
+				// ASSERT
+				assert_is_false(c.load(loaded, 0x12345678u, identity(0x12345678u), true));
+				assert_is_true(c.load(loaded, 0xABCDEF01u, identity(0xABCDEF01u), true));
+
+				// INIT
+				metadata_cache c2(dir.path());
+
+				// ACT
+				c2.store(md1, identity(0x12345678u), true);
+
+				// ASSERT
+				assert_is_true(c2.load(loaded, 0x12345678u, identity(0x12345678u), true));
+				assert_is_true(c2.load(loaded, 0xABCDEF01u, identity(0xABCDEF01u), true));
+			}
+		end_test_suite
+	}
+}
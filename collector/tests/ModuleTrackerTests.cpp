@@ -3,6 +3,7 @@
 #include "helpers.h"
 #include "mocks.h"
 
+#include <collector/metadata_cache.h>
 #include <common/file_id.h>
 #include <common/path.h>
 #include <common/smart_ptr.h>
@@ -54,9 +55,17 @@ namespace micro_profiler
 
 			module_tracker::module_info make_module_info(id_t id, string path, unsigned hash)
 			{
-				module_tracker::module_info r = {	id, file_id(path), path, hash	};
+				module_tracker::module_info r = {	id, file_id(path), path, hash, vector<byte>()	};
 				return r;
 			}
+
+			string cache_entry_name(unsigned hash)
+			{
+				char name[32];
+
+				sprintf(name, "metadata-%08X.cache", hash);
+				return name;
+			}
 		}
 
 		begin_test_suite( ModuleTrackerTests )
@@ -166,6 +175,36 @@ namespace micro_profiler
 			}
 
 
+			test( BuildIDIsPreferredForModuleHashes )
+			{
+				// INIT
+				module_tracker t(module_helper);
+				module_tracker::mapping_history_key hk;
+				loaded_modules l;
+				unloaded_modules u;
+				byte id1[] = {	0x10, 0x91, 0xF3, 0x00, 0x17, 0x29, 0x33, 0xA1,	};
+				byte id2[] = {	0x10, 0x91, 0xF3, 0x00, 0x17, 0x29, 0x33, 0xA2,	};
+				auto m1 = module::platform().locate(img1->base_ptr());
+				auto m2 = module::platform().locate(img2->base_ptr());
+				auto m3 = module::platform().locate(img3->base_ptr());
+
+				m1.build_id.assign(begin(id1), end(id1));
+				m2.build_id.assign(begin(id1), end(id1));
+				m3.build_id.assign(begin(id2), end(id2));
+
+				// ACT
+				module_helper.emulate_mapped(m1);
+				module_helper.emulate_mapped(m2);
+				module_helper.emulate_mapped(m3);
+				t.get_changes(hk, l, u);
+
+				// ASSERT (the files differ, but the identities are what matters)
+				assert_equal(3u, l.size());
+				assert_equal(l[0].second.hash, l[1].second.hash);
+				assert_not_equal(l[0].second.hash, l[2].second.hash);
+			}
+
+
 			test( StableIDsAreAssignedToPreviouslyKnownModules )
 			{
 				// INIT
@@ -475,6 +514,49 @@ namespace micro_profiler
 			}
 
 
+			test( ModuleMetadataIsStoredToAndServedFromPersistentCache )
+			{
+				// INIT
+				const auto cache = make_shared<metadata_cache>(dir.path());
+				module_tracker t1(module_helper, true, cache);
+				module_tracker::module_info info;
+				module_info_metadata md;
+
+				module_helper.emulate_mapped(*img1);
+				t1.get_module(info, 1);
+				dir.track_file(cache_entry_name(info.hash));
+
+				// ACT
+				t1.get_metadata(md, 1);
+
+				// ASSERT
+				assert_equal(module1_path, md.path);
+				assert_equal(info.hash, md.hash);
+				assert_is_true(any_of(md.symbols.begin(), md.symbols.end(), [] (const symbol_info &s) {
+					return string::npos != s.name.find("get_function_addresses_1");
+				}));
+
+				// INIT
+				module_info_metadata cached;
+				symbol_info cached_symbols[] = {	{	"cached_function", 0x100, 10	},	};
+
+				assert_is_true(cache->load(cached, info.hash, metadata_cache::identify(info.build_id, info.path), true));
+				assert_equal(md.symbols, cached.symbols);
+
+				cached.symbols.assign(begin(cached_symbols), end(cached_symbols));
+				cache->store(cached, metadata_cache::identify(info.build_id, info.path), true);
+
+				module_tracker t2(module_helper, true, cache);
+
+				// ACT
+				t2.get_metadata(md, 1);
+
+				// ASSERT
+				assert_equal(cached.symbols, md.symbols);
+				assert_equal(module1_path, md.path);
+			}
+
+
 			test( SubscribingToTrackingNotificationListsLoadedModules )
 			{
 				// INIT
@@ -0,0 +1,225 @@
+#include <collector/patch_selection.h>
+
+#include <regex>
+#include <test-helpers/helpers.h>
+#include <ut/assert.h>
+#include <ut/test.h>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace tests
+	{
+		namespace
+		{
+			typedef pair<unsigned int, bool> decoded_result;
+
+			vector<symbol_info> make_symbols()
+			{
+				symbol_info symbols[] = {
+					{	"foo", 100, 10	},
+					{	"bar", 50, 20	},
+					{	"foo_bar", 300, 30	},
+					{	"baz", 200, 5	},
+					{	"foo_alias", 100, 12	},
+					{	"sizeless", 400, 0	},
+				};
+
+				return mkvector(symbols);
+			}
+
+			module_patch_request make_request(unsigned int min_size, unsigned int max_size, string name_pattern,
+				unsigned int top_k)
+			{
+				module_patch_request r = {	1, min_size, max_size, name_pattern, false, top_k, false	};
+				return r;
+			}
+
+			patch_change_result make_result(unsigned int rva, patch_change_result::errors result)
+			{
+				patch_change_result r = {	0, rva, result	};
+				return r;
+			}
+		}
+
+		begin_test_suite( PatchSelectionTests )
+			test( AllSizedFunctionsAreSelectedSortedByRVAWithAliasesCollapsed )
+			{
+				// INIT
+				patch_targets targets;
+
+				// ACT
+				select_patch_targets(targets, make_symbols(), make_request(0, 0, string(), 0), nullptr);
+
+				// ASSERT
+				assert_equal(plural
+					+ make_pair(50u, 20u)
+					+ make_pair(100u, 12u)
+					+ make_pair(200u, 5u)
+					+ make_pair(300u, 30u), targets);
+			}
+
+
+			test( FunctionsAreFilteredBySizeAndName )
+			{
+				// INIT
+				patch_targets targets;
+
+				// ACT
+				select_patch_targets(targets, make_symbols(), make_request(10, 20, string(), 0), nullptr);
+
+				// ASSERT
+				assert_equal(plural
+					+ make_pair(50u, 20u)
+					+ make_pair(100u, 12u), targets);
+
+				// ACT
+				select_patch_targets(targets, make_symbols(), make_request(0, 0, "^foo", 0), nullptr);
+
+				// ASSERT
+				assert_equal(plural
+					+ make_pair(100u, 12u)
+					+ make_pair(300u, 30u), targets);
+
+				// ACT
+				select_patch_targets(targets, make_symbols(), make_request(11, 0, "ba", 0), nullptr);
+
+				// ASSERT
+				assert_equal(plural
+					+ make_pair(50u, 20u)
+					+ make_pair(300u, 30u), targets);
+			}
+
+
+#if defined(__GNUC__)
+			test( NamePatternIsSearchedInDemangledNames )
+			{
+				// INIT
+				symbol_info symbols[] = {
+					{	"_ZN3app6engine4stepEv", 100, 10	},
+					{	"_ZN3app5audio3mixEi", 200, 20	},
+					{	"_Zmalformed", 300, 30	},
+					{	"app_main", 400, 40	},
+				};
+				patch_targets targets;
+
+				// ACT
+				select_patch_targets(targets, mkvector(symbols), make_request(0, 0, "^app::engine::", 0), nullptr);
+
+				// ASSERT
+				assert_equal(plural + make_pair(100u, 10u), targets);
+
+				// ACT
+				select_patch_targets(targets, mkvector(symbols), make_request(0, 0, "mix\\(int\\)$|^_Z|_main", 0), nullptr);
+
+				// ASSERT
+				assert_equal(plural
+					+ make_pair(200u, 20u)
+					+ make_pair(300u, 30u)
+					+ make_pair(400u, 40u), targets);
+			}
+#endif
+
+
+			test( OnlyTopKLargestFunctionsAreSelected )
+			{
+				// INIT
+				patch_targets targets;
+
+				// ACT
+				select_patch_targets(targets, make_symbols(), make_request(0, 0, string(), 2), nullptr);
+
+				// ASSERT
+				assert_equal(plural
+					+ make_pair(50u, 20u)
+					+ make_pair(300u, 30u), targets);
+
+				// ACT
+				select_patch_targets(targets, make_symbols(), make_request(0, 0, string(), 7), nullptr);
+
+				// ASSERT
+				assert_equal(4u, targets.size());
+			}
+
+
+			test( MalformedNamePatternIsReported )
+			{
+				// INIT
+				patch_targets targets;
+
+				// ACT / ASSERT
+				assert_throws(select_patch_targets(targets, make_symbols(), make_request(0, 0, "((", 0), nullptr),
+					regex_error);
+			}
+
+
+			test( ResultsAreDecodedAsTheyWereEncoded )
+			{
+				// INIT
+				patch_targets targets;
+				patch_manager::patch_change_results results;
+				module_patch_result encoded;
+				vector<decoded_result> decoded;
+
+				targets.push_back(make_pair(100u, 5u));
+				targets.push_back(make_pair(107u, 5u));
+				targets.push_back(make_pair(114u, 5u));
+				targets.push_back(make_pair(121u, 5u));
+				targets.push_back(make_pair(1128u, 5u));
+				targets.push_back(make_pair(1135u, 5u));
+				results.push_back(make_result(100, patch_change_result::unrecoverable_error));
+				results.push_back(make_result(107, patch_change_result::ok));
+				results.push_back(make_result(114, patch_change_result::unchanged));
+				results.push_back(make_result(121, patch_change_result::activation_error));
+				results.push_back(make_result(1128, patch_change_result::activation_error));
+				results.push_back(make_result(1135, patch_change_result::ok));
+
+				// ACT
+				encode_patch_results(encoded, targets, results);
+
+				// ASSERT
+				assert_equal(plural + 100u + 7u + 7u + 7u + 1007u + 7u, encoded.rva_deltas);
+				assert_equal(plural + 0u + 1u + 2u + 2u + 1u, encoded.activated_runs);
+
+				// ACT
+				decode_patch_results(decoded, encoded);
+
+				// ASSERT
+				assert_equal(plural
+					+ make_pair(100u, false)
+					+ make_pair(107u, true)
+					+ make_pair(114u, true)
+					+ make_pair(121u, false)
+					+ make_pair(1128u, false)
+					+ make_pair(1135u, true), decoded);
+			}
+
+
+			test( TargetsMissingResultsAreEncodedAsInactive )
+			{
+				// INIT
+				patch_targets targets;
+				patch_manager::patch_change_results results;
+				module_patch_result encoded;
+				vector<decoded_result> decoded;
+
+				targets.push_back(make_pair(10u, 5u));
+				targets.push_back(make_pair(20u, 5u));
+				targets.push_back(make_pair(30u, 5u));
+				results.push_back(make_result(10, patch_change_result::ok));
+
+				// ACT
+				encode_patch_results(encoded, targets, results);
+				decode_patch_results(decoded, encoded);
+
+				// ASSERT
+				assert_equal(plural + 1u + 2u, encoded.activated_runs);
+				assert_equal(plural
+					+ make_pair(10u, true)
+					+ make_pair(20u, false)
+					+ make_pair(30u, false), decoded);
+			}
+		end_test_suite
+	}
+}
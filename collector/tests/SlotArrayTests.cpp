@@ -0,0 +1,159 @@
+#include <collector/slot_array.h>
+
+#include <algorithm>
+#include <memory>
+#include <mt/thread.h>
+#include <ut/assert.h>
+#include <ut/test.h>
+#include <vector>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace tests
+	{
+		namespace
+		{
+			template <typename T, size_t chunk_size>
+			vector< pair<size_t, T> > get_published(slot_array<T, chunk_size> &slots, size_t from = 0)
+			{
+				vector< pair<size_t, T> > result;
+
+				slots.for_each([&result] (size_t index, const T &value) {
+					result.push_back(make_pair(index, value));
+				}, from);
+				return result;
+			}
+		}
+
+		begin_test_suite( SlotArrayTests )
+			test( NewlyCreatedArrayIsEmpty )
+			{
+				// INIT / ACT
+				slot_array<int> slots;
+
+				// ACT / ASSERT
+				assert_equal(0u, slots.size());
+				assert_is_empty(get_published(slots));
+			}
+
+
+			test( ReservedSlotsAreIndexedSequentially )
+			{
+				// INIT
+				slot_array<int, 4> slots;
+
+				// ACT / ASSERT
+				assert_equal(0u, slots.reserve());
+				assert_equal(1u, slots.reserve());
+				assert_equal(2u, slots.size());
+
+				// ACT / ASSERT
+				for (auto i = 2u; i != 11u; ++i)
+					assert_equal(i, slots.reserve());
+				assert_equal(11u, slots.size());
+			}
+
+
+			test( OnlyPublishedSlotsAreEnumerated )
+			{
+				// INIT
+				slot_array<int, 4> slots;
+
+				for (auto i = 0; i != 11; ++i)
+					slots[slots.reserve()] = 100 + i;
+
+				// ACT
+				slots.publish(1);
+				slots.publish(4);
+				slots.publish(10);
+
+				// ASSERT
+				pair<size_t, int> reference1[] = {	make_pair(1, 101), make_pair(4, 104), make_pair(10, 110),	};
+
+				assert_equal(reference1, get_published(slots));
+
+				// ACT
+				slots.publish(0);
+				slots.publish(7);
+
+				// ASSERT
+				pair<size_t, int> reference2[] = {
+					make_pair(0, 100), make_pair(1, 101), make_pair(4, 104), make_pair(7, 107), make_pair(10, 110),
+				};
+				pair<size_t, int> reference3[] = {	make_pair(4, 104), make_pair(7, 107), make_pair(10, 110),	};
+				pair<size_t, int> reference4[] = {	make_pair(10, 110),	};
+
+				assert_equal(reference2, get_published(slots));
+				assert_equal(reference3, get_published(slots, 2));
+				assert_equal(reference3, get_published(slots, 4));
+				assert_equal(reference4, get_published(slots, 8));
+				assert_is_empty(get_published(slots, 11));
+			}
+
+
+			test( SlotsDoNotMoveWhenArrayGrows )
+			{
+				// INIT
+				slot_array<int, 4> slots;
+				const auto i1 = slots.reserve();
+				const auto i2 = slots.reserve();
+				const auto p1 = &slots[i1];
+				const auto p2 = &slots[i2];
+
+				// ACT
+				for (auto n = 100; n--; )
+					slots.reserve();
+
+				// ASSERT
+				assert_equal(p1, &slots[i1]);
+				assert_equal(p2, &slots[i2]);
+			}
+
+
+			test( SlotsReservedConcurrentlyAreDistinct )
+			{
+				// INIT
+				const auto n = 16u, m = 100u;
+				slot_array<unsigned, 8> slots;
+				vector< unique_ptr<mt::thread> > threads;
+				vector<size_t> indices;
+
+				// ACT
+				for (auto i = 0u; i != n; ++i)
+				{
+					threads.push_back(unique_ptr<mt::thread>(new mt::thread([&slots, i] {
+						for (auto j = 0u; j != m; ++j)
+						{
+							const auto index = slots.reserve();
+
+							slots[index] = i * m + j;
+							slots.publish(index);
+						}
+					})));
+				}
+				for (auto i = threads.begin(); i != threads.end(); ++i)
+					(*i)->join();
+
+				// ASSERT
+				vector<unsigned> values;
+
+				slots.for_each([&] (size_t index, unsigned value) {
+					indices.push_back(index);
+					values.push_back(value);
+				});
+				sort(values.begin(), values.end());
+
+				assert_equal(n * m, slots.size());
+				assert_equal(n * m, indices.size());
+				for (auto i = 0u; i != n * m; ++i)
+				{
+					assert_equal(i, indices[i]);
+					assert_equal(i, values[i]);
+				}
+			}
+
+		end_test_suite
+	}
+}
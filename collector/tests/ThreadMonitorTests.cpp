@@ -5,6 +5,7 @@
 #include <test-helpers/helpers.h>
 #include <test-helpers/thread.h>
 
+#include <algorithm>
 #include <iterator>
 #include <math.h>
 #include <mt/thread.h>
@@ -402,6 +403,244 @@ namespace micro_profiler
 #endif
 			}
 
+
+			test( ThreadCreationAndExitAreReportedOnceThroughHistoryKey )
+			{
+				// INIT
+				mocks::thread_callbacks tc;
+				const auto monitor2 = make_shared<thread_monitor>(tc);
+				thread_monitor::history_key key;
+				vector<thread_monitor::value_type> changes;
+
+				// ACT
+				monitor2->get_changes(key, changes);
+
+				// ASSERT
+				assert_equal(0u, changes.size());
+
+				// ACT
+				const auto id1 = monitor2->register_self();
+				monitor2->get_changes(key, changes);
+
+				// ASSERT
+				assert_equal(1u, changes.size());
+				assert_equal(id1, changes[0].first);
+				assert_is_false(changes[0].second.complete);
+
+				// ACT
+				monitor2->get_changes(key, changes);
+
+				// ASSERT
+				assert_equal(0u, changes.size());
+
+				// ACT
+				tc.invoke_destructors();
+				monitor2->get_changes(key, changes);
+
+				// ASSERT
+				assert_equal(1u, changes.size());
+				assert_equal(id1, changes[0].first);
+				assert_is_true(changes[0].second.complete);
+			}
+
+
+			test( ThreadStartedAndExitedBetweenQueriesIsReportedOnceAsComplete )
+			{
+				// INIT
+				mocks::thread_callbacks tc;
+				const auto monitor2 = make_shared<thread_monitor>(tc);
+				thread_monitor::history_key key, key2;
+				vector<thread_monitor::value_type> changes;
+
+				monitor2->get_changes(key, changes);
+
+				// ACT
+				const auto id1 = monitor2->register_self();
+				tc.invoke_destructors();
+				monitor2->get_changes(key, changes);
+
+				// ASSERT
+				assert_equal(1u, changes.size());
+				assert_equal(id1, changes[0].first);
+				assert_is_true(changes[0].second.complete);
+
+				// ACT
+				monitor2->get_changes(key2, changes);
+
+				// ASSERT
+				assert_equal(1u, changes.size());
+				assert_equal(id1, changes[0].first);
+				assert_is_true(changes[0].second.complete);
+			}
+
+
+			test( LiveThreadsAreReportedPeriodically )
+			{
+				// INIT
+				mocks::thread_callbacks tc;
+				const auto monitor2 = make_shared<thread_monitor>(tc);
+				thread_monitor::history_key key;
+				vector<thread_monitor::value_type> changes;
+				const auto id1 = monitor2->register_self();
+
+				monitor2->get_changes(key, changes);
+
+				// ACT
+				key.last_refresh -= thread_monitor::live_refresh_interval;
+				monitor2->get_changes(key, changes);
+
+				// ASSERT
+				assert_equal(1u, changes.size());
+				assert_equal(id1, changes[0].first);
+
+				// ACT
+				monitor2->get_changes(key, changes);
+
+				// ASSERT
+				assert_equal(0u, changes.size());
+			}
+
+
+			test( ThreadStartedBeforeRefreshIsReportedOnce )
+			{
+				// INIT
+				mocks::thread_callbacks tc;
+				const auto monitor2 = make_shared<thread_monitor>(tc);
+				thread_monitor::history_key key;
+				vector<thread_monitor::value_type> changes;
+
+				monitor2->get_changes(key, changes);
+
+				// ACT
+				const auto id1 = monitor2->register_self();
+				key.last_refresh -= thread_monitor::live_refresh_interval;
+				monitor2->get_changes(key, changes);
+
+				// ASSERT
+				assert_equal(1u, changes.size());
+				assert_equal(id1, changes[0].first);
+				assert_is_false(changes[0].second.complete);
+			}
+
+
+			test( KeysOlderThanRetainedChangesGetAllThreadsReported )
+			{
+				// INIT
+				mocks::thread_callbacks tc;
+				const auto monitor2 = make_shared<thread_monitor>(tc);
+				thread_monitor::history_key key, key2;
+				vector<thread_monitor::value_type> changes;
+				const auto n = thread_monitor::max_changes + 10u;
+
+				monitor2->get_changes(key, changes);
+				for (auto i = 0u; i != n - 1; ++i)
+					monitor2->register_self(), tc.invoke_destructors();
+				monitor2->get_changes(key2, changes);
+
+				// ACT
+				const auto id = monitor2->register_self();
+				monitor2->get_changes(key, changes);
+
+				// ASSERT
+				assert_equal(n, changes.size());
+				assert_equal(n - 1, static_cast<unsigned>(count_if(changes.begin(), changes.end(),
+					[] (const thread_monitor::value_type &v) {	return v.second.complete;	})));
+
+				// ACT
+				monitor2->get_changes(key2, changes);
+
+				// ASSERT
+				assert_equal(1u, changes.size());
+				assert_equal(id, changes[0].first);
+				assert_is_false(changes[0].second.complete);
+			}
+
+
+			test( ThreadsRegisteringConcurrentlyGetDistinctIDsAndTheirOwnInfo )
+			{
+				// INIT
+				const auto n = 32u;
+				vector<thread_monitor::thread_id> tids(2 * n);
+				vector<unsigned long long> ntids(n);
+				vector< unique_ptr<mt::thread> > threads;
+
+				// ACT
+				for (auto i = 0u; i != n; ++i)
+				{
+					threads.push_back(unique_ptr<mt::thread>(new mt::thread([&, i] {
+						tids[2 * i] = monitor->register_self();
+						tids[2 * i + 1] = monitor->register_self();
+						ntids[i] = this_thread::get_native_id();
+					})));
+				}
+				for (auto i = threads.begin(); i != threads.end(); ++i)
+					(*i)->join();
+
+				// ASSERT
+				vector<thread_monitor::thread_id> ids;
+
+				for (auto i = 0u; i != n; ++i)
+				{
+					assert_equal(tids[2 * i], tids[2 * i + 1]);
+					assert_equal(ntids[i], get_info(*monitor, tids[2 * i]).native_id);
+					assert_is_true(get_info(*monitor, tids[2 * i]).complete);
+					ids.push_back(tids[2 * i]);
+				}
+				sort(ids.begin(), ids.end());
+				for (auto i = 0u; i != n; ++i)
+					assert_equal(i, ids[i]);
+			}
+
+
+			test( RunningThreadsRegisteredAreReportedOnceCollected )
+			{
+				// INIT
+				thread_monitor::history_key key;
+				vector<thread_monitor::value_type> changes;
+				thread_monitor::thread_id tids[2];
+				unsigned long long ntids[2];
+				mt::event registered[2], go[2];
+
+				monitor->get_changes(key, changes);
+
+				mt::thread t1([&] {
+					tids[0] = monitor->register_self(), ntids[0] = this_thread::get_native_id();
+					registered[0].set();
+					go[0].wait();
+				});
+				registered[0].wait();
+				mt::thread t2([&] {
+					tids[1] = monitor->register_self(), ntids[1] = this_thread::get_native_id();
+					registered[1].set();
+					go[1].wait();
+				});
+				registered[1].wait();
+
+				// ACT
+				monitor->get_changes(key, changes);
+
+				// ASSERT
+				assert_equal(2u, changes.size());
+				assert_equal(tids[0], changes[0].first);
+				assert_equal(ntids[0], changes[0].second.native_id);
+				assert_is_false(changes[0].second.complete);
+				assert_equal(tids[1], changes[1].first);
+				assert_equal(ntids[1], changes[1].second.native_id);
+				assert_is_false(changes[1].second.complete);
+
+				// ACT
+				go[0].set();
+				go[1].set();
+				t1.join();
+				t2.join();
+				monitor->get_changes(key, changes);
+
+				// ASSERT
+				assert_equal(2u, changes.size());
+				assert_is_true(changes[0].second.complete);
+				assert_is_true(changes[1].second.complete);
+			}
+
 		end_test_suite
 	}
 }
@@ -3,6 +3,7 @@
 #include "mocks.h"
 #include "mocks_allocator.h"
 
+#include <algorithm>
 #include <collector/buffers_queue.h>
 #include <mt/thread.h>
 #include <test-helpers/helpers.h>
@@ -59,6 +60,50 @@ namespace micro_profiler
 
 				assert_equal(reference2, log);
 			}
+
+
+			test( QueuesConstructedConcurrentlyAreAllRead )
+			{
+				// INIT
+				const auto n = 32u;
+				auto next_id = 0u;
+				mt::mutex mtx;
+				thread_queue_manager< buffers_queue<int> > qm(al, big_policy, thread_callbacks_, [&] () -> unsigned {
+					mt::lock_guard<mt::mutex> l(mtx);
+					return next_id++;
+				});
+				vector< unique_ptr<mt::thread> > threads;
+				vector<unsigned> ids, values;
+
+				// ACT
+				for (auto i = 0u; i != n; ++i)
+				{
+					threads.push_back(unique_ptr<mt::thread>(new mt::thread([&, i] {
+						auto &q = qm.get_queue();
+
+						q.current() = static_cast<int>(i);
+						q.push();
+						q.flush();
+					})));
+				}
+				for (auto i = threads.begin(); i != threads.end(); ++i)
+					(*i)->join();
+				qm.read_collected([&] (unsigned id, const int *data, size_t size) {
+					ids.push_back(id);
+					values.insert(values.end(), data, data + size);
+				});
+
+				// ASSERT
+				sort(ids.begin(), ids.end());
+				sort(values.begin(), values.end());
+				assert_equal(n, ids.size());
+				assert_equal(n, values.size());
+				for (auto i = 0u; i != n; ++i)
+				{
+					assert_equal(i, ids[i]);
+					assert_equal(i, values[i]);
+				}
+			}
 		end_test_suite
 	}
 }
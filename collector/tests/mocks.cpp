@@ -70,6 +70,9 @@ namespace micro_profiler
 			shared_ptr<module::mapping> module_helper::lock_at(void *address)
 			{	return on_lock_at(address);	}
 
+			void module_helper::refresh_mappings()
+			{	}
+
 			shared_ptr<void> module_helper::notify(events &consumer)
 			{
 				mt::lock_guard<mt::mutex> l(_mtx);
@@ -145,7 +148,10 @@ namespace micro_profiler
 			{	return get_id(mt::this_thread::get_id());	}
 
 			void thread_monitor::add_info(thread_id id, const thread_info &info)
-			{	_threads[id] = info;	}
+			{
+				_threads[id] = info;
+				_changes.insert(make_pair(++_generation, id));
+			}
 
 			thread_monitor::thread_id thread_monitor::register_self()
 			{
@@ -39,6 +39,7 @@ namespace micro_profiler
 				virtual mapping locate(const void *address) override;
 				virtual std::shared_ptr<mapping> lock_at(void *address) override;
 				virtual std::shared_ptr<void> notify(events &consumer) override;
+				virtual void refresh_mappings() override;
 
 			private:
 				mt::mutex _mtx;
@@ -14,11 +14,20 @@ namespace micro_profiler
 				std::function<void (patch_states &states, id_t module_id)> on_query;
 				std::function<void (patch_change_results &results, id_t module_id, apply_request_range targets)> on_apply;
 				std::function<void (patch_change_results &results, id_t module_id, revert_request_range targets)> on_revert;
+				std::function<void (patch_change_results &results, id_t module_id, apply_request_range targets)> on_apply_counters;
+				std::function<void (patch_counters &counters)> on_read_counters; // No counters are reported if not set.
+				std::function<void (patch_change_results &results, id_t module_id, revert_request_range targets,
+					bool paused)> on_pause;
 
 			private:
 				virtual void query(patch_states &states, id_t module_id) override;
 				virtual void apply(patch_change_results &results, id_t module_id, apply_request_range targets) override;
 				virtual void revert(patch_change_results &results, id_t module_id, revert_request_range targets) override;
+				virtual void apply_counters(patch_change_results &results, id_t module_id,
+					apply_request_range targets) override;
+				virtual void read_counters(patch_counters &counters) override;
+				virtual void pause(patch_change_results &results, id_t module_id, revert_request_range targets,
+					bool paused) override;
 			};
 
 
@@ -31,6 +40,17 @@ namespace micro_profiler
 
 			inline void patch_manager::revert(patch_change_results &results, id_t module_id, revert_request_range targets)
 			{	on_revert(results, module_id, targets);	}
+
+			inline void patch_manager::apply_counters(patch_change_results &results, id_t module_id,
+				apply_request_range targets)
+			{	on_apply_counters(results, module_id, targets);	}
+
+			inline void patch_manager::read_counters(patch_counters &counters)
+			{	on_read_counters ? on_read_counters(counters) : counters.clear();	}
+
+			inline void patch_manager::pause(patch_change_results &results, id_t module_id, revert_request_range targets,
+				bool paused)
+			{	on_pause(results, module_id, targets, paused);	}
 		}
 	}
 }
@@ -20,11 +20,17 @@
 
 #pragma once
 
+#include "slot_array.h"
+
 #include <common/types.h>
+#include <cstdint>
 #include <functional>
+#include <map>
 #include <memory>
 #include <mt/mutex.h>
+#include <mt/tls.h>
 #include <common/unordered_map.h>
+#include <vector>
 
 namespace mt
 {
@@ -40,36 +46,71 @@ namespace micro_profiler
 		typedef unsigned long long native_thread_id;
 		typedef std::pair<thread_id, thread_info> value_type;
 
+		struct history_key
+		{
+			history_key();
+
+			std::size_t last_change;
+			timestamp_t last_refresh;
+		};
+
+		enum {	live_refresh_interval = 1000 /*ms*/	};
+		enum {	max_changes = 1024	};
+
 	public:
 		thread_monitor(mt::thread_callbacks &callbacks);
 
+		// Registers the calling thread without locking: the thread's info is only collected when the monitor is queried
+		// next time (or when the thread exits).
 		virtual thread_id register_self();
 
 		template <typename OutputIteratorT, typename IteratorT>
 		void get_info(OutputIteratorT destination, IteratorT begin_id, IteratorT end_id) const;
 
+		// Reports threads created or exited since the key was last used. Information for the threads still running
+		// is additionally reported each live_refresh_interval milliseconds (mostly for CPU time). Only the latest
+		// max_changes changes are kept: a key older than that gets all the threads reported.
+		void get_changes(history_key &key, std::vector<value_type> &changes) const;
+
 	protected:
 		struct live_thread_info;
+		struct registration;
 
-		typedef containers::unordered_map<native_thread_id, live_thread_info> running_threads_map;
+		typedef containers::unordered_map<thread_id, live_thread_info> running_threads_map;
 		typedef containers::unordered_map<thread_id, thread_info> threads_map;
 
 		struct live_thread_info
 		{
 			threads_map::value_type *thread_info_entry;
 			std::function<void (thread_info &info)> accessor;
+			std::size_t last_change;
+		};
+
+		struct registration
+		{
+			thread_id id;
+			native_thread_id native_id;
+			std::uintptr_t handle;
+			mt::milliseconds start_time;
+			bool collected; // Guarded by _mutex.
 		};
 
 	protected:
-		virtual void update_live_info(thread_info &info, native_thread_id native_id) const;
-		void thread_exited(native_thread_id native_id);
+		virtual void update_live_info(thread_info &info, thread_id id) const;
+		void collect_registrations() const;
+		std::size_t add_change(thread_id id) const;
+		void thread_exited(thread_id id);
 
 	protected:
 		mt::thread_callbacks &_callbacks;
 		mutable mt::mutex _mutex;
 		mutable threads_map _threads;
 		mutable running_threads_map _alive_threads;
-		thread_id _next_id;
+		mutable std::map<std::size_t /*generation*/, thread_id> _changes; // The last change of each thread only.
+		mutable std::size_t _generation, _pruned_generation;
+		mutable slot_array<registration> _registrations;
+		mutable std::size_t _uncollected_from;
+		mt::tls<registration> _registration_tls;
 	};
 
 
@@ -80,6 +121,7 @@ namespace micro_profiler
 		value_type v;
 		mt::lock_guard<mt::mutex> lock(_mutex);
 
+		collect_registrations();
 		for (; begin_id != end_id; ++begin_id)
 		{
 			threads_map::iterator i = _threads.find(*begin_id);
@@ -89,7 +131,7 @@ namespace micro_profiler
 			v.first = i->first;
 			v.second = i->second;
 			if (!v.second.complete)
-				update_live_info(v.second, i->second.native_id);
+				update_live_info(v.second, i->first);
 			*destination++ = v;
 		}
 	}
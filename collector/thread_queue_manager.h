@@ -20,8 +20,10 @@
 
 #pragma once
 
+#include "slot_array.h"
 #include "types.h"
 
+#include <atomic>
 #include <common/allocator.h>
 #include <common/noncopyable.h>
 #include <common/compiler.h>
@@ -37,7 +39,7 @@ namespace micro_profiler
 	class thread_queue_manager : noncopyable
 	{
 	public:
-		typedef std::function<unsigned int ()> id_gen_cb;
+		typedef std::function<unsigned int ()> id_gen_cb; // Invoked concurrently by the threads constructing queues.
 
 	public:
 		thread_queue_manager(allocator &allocator_, const buffering_policy &policy, mt::thread_callbacks &callbacks,
@@ -53,7 +55,8 @@ namespace micro_profiler
 		Q &construct_queue();
 
 	private:
-		typedef std::vector< std::shared_ptr<Q> > queues_t;
+		typedef slot_array< std::shared_ptr<Q> > queues_t;
+		typedef std::vector< std::unique_ptr<const buffering_policy> > policies_t;
 
 	private:
 		mt::tls<Q> _queue_pointers_tls;
@@ -62,7 +65,8 @@ namespace micro_profiler
 		mt::thread_callbacks &_thread_callbacks;
 		allocator &_allocator;
 		mt::mutex _mtx;
-		buffering_policy _policy;
+		policies_t _policies; // Policies ever set are kept for lock-free reading by the queues being constructed.
+		std::atomic<const buffering_policy *> _policy;
 		const id_gen_cb _id_gen;
 	};
 
@@ -71,17 +75,22 @@ namespace micro_profiler
 	template <typename Q>
 	inline thread_queue_manager<Q>::thread_queue_manager(allocator &allocator_, const buffering_policy &policy,
 			mt::thread_callbacks &callbacks, const id_gen_cb &id_gen)
-		: _thread_callbacks(callbacks), _allocator(allocator_), _policy(policy), _id_gen(id_gen)
-	{	}
+		: _thread_callbacks(callbacks), _allocator(allocator_), _policy(nullptr), _id_gen(id_gen)
+	{
+		_policies.push_back(std::unique_ptr<const buffering_policy>(new buffering_policy(policy)));
+		_policy = _policies.back().get();
+	}
 
 	template <typename Q>
 	inline void thread_queue_manager<Q>::set_buffering_policy(const buffering_policy &policy)
 	{
 		mt::lock_guard<mt::mutex> l(_mtx);
 
-		for (auto i = _queues.begin(); i != _queues.end(); ++i)
-			(*i)->set_buffering_policy(policy);
-		_policy = policy;
+		_policies.push_back(std::unique_ptr<const buffering_policy>(new buffering_policy(policy)));
+		_policy = _policies.back().get();
+		_queues.for_each([&policy] (std::size_t, const std::shared_ptr<Q> &queue) {
+			queue->set_buffering_policy(policy);
+		});
 	}
 
 	template <typename Q>
@@ -90,8 +99,9 @@ namespace micro_profiler
 	{
 		mt::lock_guard<mt::mutex> l(_mtx);
 
-		for (auto i = _queues.begin(); i != _queues.end(); ++i)
-			(*i)->read_collected(reader);
+		_queues.for_each([&reader] (std::size_t, const std::shared_ptr<Q> &queue) {
+			queue->read_collected(reader);
+		});
 	}
 
 	template <typename Q>
@@ -112,25 +122,20 @@ namespace micro_profiler
 	template <typename Q>
 	FORCE_NOINLINE inline Q &thread_queue_manager<Q>::construct_queue()
 	{
-		unsigned int id;
-		buffering_policy policy(0, 0, 0);
-
-		{
-			mt::lock_guard<mt::mutex> l(_mtx);
-			
-			id = _id_gen();
-			policy = _policy;
-		}
-
-		const auto trace = std::make_shared<Q>(_allocator, policy, id);
+		const auto policy = _policy.load();
+		const auto trace = std::make_shared<Q>(_allocator, *policy, _id_gen());
+		const auto index = _queues.reserve();
 
 		_thread_callbacks.at_thread_exit([trace] {	trace->flush();	});
 		_queue_pointers_tls.set(trace.get());
-
+		_queues[index] = trace;
+		_queues.publish(index);
+		if (_policy.load() != policy)
 		{
+			// The policy was changed before the queue got published, thus, possibly not applied to it.
 			mt::lock_guard<mt::mutex> l(_mtx);
 
-			_queues.push_back(trace);
+			trace->set_buffering_policy(*_policy.load());
 		}
 		return *trace;
 	}
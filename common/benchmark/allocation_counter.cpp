@@ -0,0 +1,28 @@
+#include "allocation_counter.h"
+
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+namespace
+{
+	size_t g_allocations = 0;
+}
+
+void *operator new(size_t size)
+{
+	g_allocations++;
+	if (void *p = malloc(size ? size : 1))
+		return p;
+	throw bad_alloc();
+}
+
+void operator delete(void *p) throw()
+{	free(p);	}
+
+namespace micro_profiler
+{
+	size_t allocations_made()
+	{	return g_allocations;	}
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstddef>
+
+namespace micro_profiler
+{
+	// Total of the global operator new calls made by the process so far. Linking allocation_counter.cpp into a
+	// benchmark replaces the global operator new/delete with the counting ones.
+	std::size_t allocations_made();
+}
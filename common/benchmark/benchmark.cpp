@@ -0,0 +1,64 @@
+#include <common/image_info.h>
+
+#include <common/time.h>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace
+	{
+		struct measurement
+		{
+			unsigned functions, positioned, files;
+			double load, first_enumeration, next_enumeration, files_enumeration;
+		};
+
+		measurement measure(const string &path, bool demangle_names)
+		{
+			stopwatch sw;
+			measurement m = {	};
+
+			sw();
+
+			const auto ii = load_image_info(path, demangle_names);
+
+			m.load = sw();
+			ii->enumerate_functions([&] (const symbol_info &symbol) {
+				m.functions++;
+				m.positioned += !!symbol.line;
+			});
+			m.first_enumeration = sw();
+			ii->enumerate_functions([] (const symbol_info &) {	});
+			m.next_enumeration = sw();
+			ii->enumerate_files([&] (const pair<id_t, string> &) {
+				m.files++;
+			});
+			m.files_enumeration = sw();
+			return m;
+		}
+	}
+}
+
+int main(int argc, const char *argv[])
+{
+	using namespace micro_profiler;
+
+	const string path = argc > 1 ? argv[1] : "/proc/self/exe";
+
+	for (auto demangle_names = 0; demangle_names != 2; ++demangle_names)
+	{
+		const auto m = measure(path, !!demangle_names);
+
+		printf("Image '%s' (%s): %u functions, %u with source positions, %u source files\n", path.c_str(),
+			demangle_names ? "demangled" : "mangled", m.functions, m.positioned, m.files);
+		printf("Load: %.2fms\n", 1000 * m.load);
+		printf("First enumeration (symbols, line tables, demangling): %.2fms\n", 1000 * m.first_enumeration);
+		printf("Next enumeration (cached): %.2fms\n", 1000 * m.next_enumeration);
+		printf("Files enumeration: %.2fms\n", 1000 * m.files_enumeration);
+	}
+	return 0;
+}
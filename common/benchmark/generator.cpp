@@ -0,0 +1,32 @@
+#include <cstdio>
+#include <cstdlib>
+
+// Writes a translation unit made of functions ten source lines long each, so that every line gets its own line
+// table row.
+int main(int argc, const char *argv[])
+{
+	if (argc != 4)
+		return fprintf(stderr, "Usage: %s <output.cpp> <unit> <functions>\n", argv[0]), 1;
+
+	FILE *f = fopen(argv[1], "w");
+	const int unit = atoi(argv[2]);
+	const int functions = atoi(argv[3]);
+
+	if (!f)
+		return 1;
+	for (int i = 0; i != functions; ++i)
+	{
+		fprintf(f, "extern \"C\" __attribute__((visibility(\"default\"))) int line_heavy_%d_%d(int a)\n", unit, i);
+		fprintf(f, "{\n");
+		fprintf(f, "\tvolatile int b = a;\n");
+		fprintf(f, "\tb += %d;\n", i);
+		fprintf(f, "\tb ^= b >> 3;\n");
+		fprintf(f, "\tb *= %d;\n", unit);
+		fprintf(f, "\tb -= a;\n");
+		fprintf(f, "\tb |= 1;\n");
+		fprintf(f, "\treturn b;\n");
+		fprintf(f, "}\n");
+	}
+	fclose(f);
+	return 0;
+}
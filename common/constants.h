@@ -36,6 +36,7 @@ namespace micro_profiler
 		static const char *profiler_name;
 		static const char *profilerdir_ev;
 		static const char *frontend_id_ev;
+		static const char *mangled_names_ev;
 		static const coipc::guid_t standalone_frontend_id;
 		static const coipc::guid_t integrated_frontend_id;
 
@@ -25,6 +25,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace micro_profiler
 {
@@ -46,5 +47,11 @@ namespace micro_profiler
 		virtual void enumerate_files(const file_callback_t &/*callback*/) const {	}
 	};
 
-	std::shared_ptr<image_info> load_image_info(const std::string &image_path);
+	// Names that are not demangled by the image info (demangle_names == false) are reported as they are in the image.
+	std::shared_ptr<image_info> load_image_info(const std::string &image_path, bool demangle_names = true);
+
+	// Reads the sorted RVAs of the NOP sleds reserved by -fpatchable-function-entry (the image's
+	// __patchable_function_entries section). The section is relocated by the loader, so the entries are read off the
+	// image mapped at 'base'. Images not having the section yield no entries.
+	void read_patchable_entries(std::vector<unsigned int> &rvas, const std::string &image_path, const byte *base);
 }
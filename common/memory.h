@@ -33,6 +33,10 @@ namespace micro_profiler
 	void mem_copy(void *dest, const void *src, std::size_t length);
 	void mem_set(void *dest, byte value, std::size_t length);
 
+	// Makes every thread of the process execute a serializing instruction before it runs any further code, so that code
+	// modified before the call is fetched anew by all of them.
+	void serialize_code_modifications();
+
 	struct protection
 	{
 		enum flags {	read = (1 << 0), write = (1 << 1), execute = (1 << 2),	};
@@ -85,11 +89,24 @@ namespace micro_profiler
 	public:
 		enum { block_size = 0x10000 };
 
+		struct statistics
+		{
+			std::size_t blocks; // Regions currently held.
+			std::size_t reserved; // Total size of the regions held.
+			std::size_t allocated; // Bytes in live allocations.
+		};
+
 	public:
 		executable_memory_allocator();
 
 		virtual std::shared_ptr<void> allocate(std::size_t size);
 
+		// Hints that the next allocations of 'size' bytes in total are to be placed contiguously, so that a batch
+		// does not pay for a new block every few allocations. Allocations that exceed the reservation still succeed.
+		virtual void reserve(std::size_t size);
+
+		virtual statistics get_statistics() const;
+
 	private:
 		class block;
 
@@ -104,6 +121,7 @@ namespace micro_profiler
 		~block();
 
 		void *allocate(std::size_t size);
+		std::size_t available() const;
 
 	private:
 		const byte_range _region;
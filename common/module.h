@@ -47,6 +47,9 @@ namespace micro_profiler
 		virtual std::shared_ptr<mapping> lock_at(void *address) = 0;
 		virtual std::shared_ptr<void> notify(events &consumer) = 0;
 
+		// Delivers the mapping changes not yet notified of, for the platforms that only detect them periodically.
+		virtual void refresh_mappings() = 0;
+
 		static module &platform();
 	};
 
@@ -61,6 +64,7 @@ namespace micro_profiler
 		std::string path;
 		byte *base;
 		std::vector<mapped_region> regions;
+		std::vector<byte> build_id; // Linker-assigned image identity (e.g. NT_GNU_BUILD_ID), empty if unavailable.
 	};
 
 	struct module::mapping_ex
@@ -0,0 +1,52 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+#pragma once
+
+#include "protocol.h"
+
+#include <utility>
+#include <vector>
+
+namespace micro_profiler
+{
+	typedef std::vector< std::pair<unsigned int /*rva*/, bool /*active*/> > decoded_patch_results;
+
+	// Unpacks response_module_patched payload into the RVAs of the functions selected along with their activity.
+	inline void decode_patch_results(decoded_patch_results &decoded, const module_patch_result &encoded)
+	{
+		auto rva = 0u;
+		auto active = true;
+		auto run = encoded.activated_runs.begin();
+		auto remaining = run != encoded.activated_runs.end() ? *run : 0u;
+
+		decoded.clear();
+		decoded.reserve(encoded.rva_deltas.size());
+		for (auto i = encoded.rva_deltas.begin(); i != encoded.rva_deltas.end(); ++i)
+		{
+			while (!remaining && run != encoded.activated_runs.end() && ++run != encoded.activated_runs.end())
+				remaining = *run, active = !active;
+			rva += *i;
+			decoded.push_back(std::make_pair(rva, active && remaining));
+			if (remaining)
+				remaining--;
+		}
+	}
+}
@@ -32,7 +32,7 @@ namespace micro_profiler
 {
 	enum messages_id {
 		// Requests...
-		request_update = 0x100, // responded with [modules_loaded, ]statistics_update[, modules_unloaded] sequence.
+		request_update = 0x100, // responded with [modules_loaded, ][threads_info, ][patch_counters, ]statistics_update[, modules_unloaded] sequence.
 		response_modules_loaded = 1,
 		response_statistics_update = 6,
 		response_modules_unloaded = 3,
@@ -46,18 +46,41 @@ namespace micro_profiler
 		request_apply_patches = 10,
 		response_patched = 11,
 
+		request_apply_module_patches = 12, // + module_patch_request
+		response_module_patched = 13,
+
 		request_revert_patches = 15,
 		response_reverted = 16,
 
+		request_pause_patches = 17, // + patch_pause_request
+		response_paused = 18,
+
 		request_query_patches = 20,
 		response_patches_state = 21,
 
+		response_patch_counters = 22, // Part of the request_update sequence (protocol_patch_counters and later).
+
+		// One-way requests (never responded, the response id passed is no_response)...
+		request_subscribe_updates = 25, // + update_subscription; updates are pushed with statistics_pushed afterwards.
+		request_unsubscribe_updates = 26,
+		request_update_credit = 27, // + update_credit; acknowledges the pushes processed, reopening the window.
+		no_response = 0x1FF,
+
 		// Notifications...
 		init_v1 = 0,
 		legacy_update_statistics = 2,
 
 		init = 0x101,
 		exiting = 0x102,
+		statistics_pushed = 0x103, // modules_loaded, threads_info, statistics_update, modules_unloaded[ and patch_counters] in a single message.
+	};
+
+	// initialization_data::protocol
+	enum protocol_versions {
+		protocol_polling = 0, // request_update only.
+		protocol_push_updates = 1, // request_subscribe_updates, request_update_credit and statistics_pushed.
+		protocol_patch_counters = 2, // response_patch_counters in request_update and the trailer of statistics_pushed.
+		protocol_current = protocol_patch_counters,
 	};
 
 	// response_modules_loaded
@@ -66,6 +89,20 @@ namespace micro_profiler
 	// response_modules_unloaded
 	typedef std::vector<id_t> unloaded_modules;
 
+	// request_subscribe_updates
+	struct update_subscription
+	{
+		unsigned int min_interval; // Minimal interval between two consequent pushes, milliseconds.
+		unsigned int byte_budget; // Bytes per second the frontend is willing to consume (zero means unlimited).
+		unsigned int window; // Maximal number of pushes sent but not yet credited back.
+	};
+
+	// request_update_credit
+	struct update_credit
+	{
+		unsigned int pushes; // Number of statistics_pushed messages processed since the previous credit.
+	};
+
 	// response_module_metadata
 	struct module_info_metadata
 	{
@@ -87,11 +124,44 @@ namespace micro_profiler
 	{
 		id_t module_id;
 		std::vector<patch_manager::apply_request> functions;
+		bool count_only; // Only count the calls to the functions (see patch_manager::apply_counters()).
 	};
 
 	// response_patched
 	typedef std::vector<patch_change_result> response_patched_data;
 
+	// request_apply_module_patches
+	struct module_patch_request
+	{
+		id_t module_id;
+		unsigned int min_size, max_size; // Zero max_size means no upper limit.
+		std::string name_pattern; // A regular expression (ECMAScript) to search in demangled function names; empty matches all.
+		bool exclude_leaves; // Skip the functions not calling anything.
+		unsigned int top_k; // Only take this many of the largest functions passing the filters; zero means all.
+		bool count_only; // Only count the calls to the functions selected (see patch_manager::apply_counters()).
+	};
+
+	// response_module_patched
+	struct module_patch_result
+	{
+		std::vector<unsigned int> rva_deltas; // Ascending RVAs of the functions selected, each relative to the previous.
+		std::vector<unsigned int> activated_runs; // Alternating run lengths of active/failed patches, active first.
+	};
+
 	// response_reverted
 	typedef std::vector<patch_change_result> response_reverted_data;
+
+	// request_pause_patches
+	struct patch_pause_request
+	{
+		id_t module_id;
+		std::vector<unsigned int> functions_rva;
+		bool paused; // False resumes the measurement.
+	};
+
+	// response_paused
+	typedef std::vector<patch_change_result> response_paused_data;
+
+	// response_patch_counters
+	typedef patch_manager::patch_counters patch_counters;
 }
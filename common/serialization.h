@@ -33,15 +33,21 @@
 
 namespace strmd
 {
-	template <> struct version<micro_profiler::initialization_data> {	enum {	value = 6	};	};
+	template <> struct version<micro_profiler::initialization_data> {	enum {	value = 7	};	};
 	template <> struct version<micro_profiler::function_statistics> {	enum {	value = 5	};	};
 	template <> struct version<micro_profiler::module::mapping_ex> {	enum {	value = 6	};	};
 	template <> struct version<micro_profiler::symbol_info> {	enum {	value = 4	};	};
 	template <> struct version<micro_profiler::module_info_metadata> {	enum {	value = 6	};	};
 	template <> struct version<micro_profiler::thread_info> {	enum {	value = 4	};	};
 	template <> struct version<micro_profiler::patch_revert_request> {	enum {	value = 4	};	};
-	template <> struct version<micro_profiler::patch_apply_request> {	enum {	value = 5	};	};
+	template <> struct version<micro_profiler::patch_apply_request> {	enum {	value = 6	};	};
 	template <> struct version<micro_profiler::patch_change_result> {	enum {	value = 5	};	};
+	template <> struct version<micro_profiler::module_patch_request> {	enum {	value = 2	};	};
+	template <> struct version<micro_profiler::patch_pause_request> {	enum {	value = 1	};	};
+	template <> struct version<micro_profiler::patch_counter> {	enum {	value = 1	};	};
+	template <> struct version<micro_profiler::module_patch_result> {	enum {	value = 1	};	};
+	template <> struct version<micro_profiler::update_subscription> {	enum {	value = 1	};	};
+	template <> struct version<micro_profiler::update_credit> {	enum {	value = 1	};	};
 }
 
 namespace micro_profiler
@@ -60,6 +66,8 @@ namespace micro_profiler
 			archive(data.executable);
 		if (ver >= 6)
 			archive(data.injected);
+		if (ver >= 7)
+			archive(data.protocol);
 	}	
 
 	template <typename ArchiveT>
@@ -136,12 +144,66 @@ namespace micro_profiler
 	}
 
 	template <typename ArchiveT>
-	inline void serialize(ArchiveT &archive, patch_apply_request &data, unsigned int /*ver*/)
+	inline void serialize(ArchiveT &archive, patch_apply_request &data, unsigned int ver)
 	{
 		archive(data.module_id);
 		archive(data.functions);
+		if (ver >= 6)
+			archive(reinterpret_cast<unsigned char &>(data.count_only));
+		else
+			data.count_only = false;
+	}
+
+	template <typename ArchiveT>
+	inline void serialize(ArchiveT &archive, patch_pause_request &data, unsigned int /*ver*/)
+	{
+		archive(data.module_id);
+		archive(data.functions_rva);
+		archive(data.paused);
+	}
+
+	template <typename ArchiveT>
+	inline void serialize(ArchiveT &archive, patch_counter &data, unsigned int /*ver*/)
+	{
+		archive(data.module_id);
+		archive(data.rva);
+		archive(data.calls);
+	}
+
+	template <typename ArchiveT>
+	inline void serialize(ArchiveT &archive, module_patch_request &data, unsigned int ver)
+	{
+		archive(data.module_id);
+		archive(data.min_size);
+		archive(data.max_size);
+		archive(data.name_pattern);
+		archive(reinterpret_cast<unsigned char &>(data.exclude_leaves));
+		archive(data.top_k);
+		if (ver >= 2)
+			archive(reinterpret_cast<unsigned char &>(data.count_only));
+		else
+			data.count_only = false;
+	}
+
+	template <typename ArchiveT>
+	inline void serialize(ArchiveT &archive, module_patch_result &data, unsigned int /*ver*/)
+	{
+		archive(data.rva_deltas);
+		archive(data.activated_runs);
 	}
 
+	template <typename ArchiveT>
+	inline void serialize(ArchiveT &archive, update_subscription &data, unsigned int /*ver*/)
+	{
+		archive(data.min_interval);
+		archive(data.byte_budget);
+		archive(data.window);
+	}
+
+	template <typename ArchiveT>
+	inline void serialize(ArchiveT &archive, update_credit &data, unsigned int /*ver*/)
+	{	archive(data.pushes);	}
+
 	template <typename ArchiveT>
 	inline void serialize(ArchiveT &archive, patch_change_result::errors &data)
 	{	archive(reinterpret_cast<int &>(data));	}
@@ -38,6 +38,7 @@ namespace micro_profiler
 	const char *constants::profiler_name = ".microprofiler";
 	const char *constants::profilerdir_ev = "MICROPROFILERDIR";
 	const char *constants::frontend_id_ev = "MICROPROFILERFRONTEND";
+	const char *constants::mangled_names_ev = "MICROPROFILERMANGLEDNAMES";
 
 	// {0ED7654C-DE8A-4964-9661-0B0C391BE15E}
 	const guid_t constants::standalone_frontend_id = {
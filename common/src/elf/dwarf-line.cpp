@@ -0,0 +1,899 @@
+#include "dwarf-line.h"
+
+#include "sym-elf.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <elf.h>
+#include <string.h>
+#include <unordered_map>
+
+#if defined(MP_HAVE_ZLIB)
+	#include <zlib.h>
+#endif
+
+using namespace std;
+
+namespace symreader
+{
+	namespace
+	{
+		enum {
+			DW_FORM_addr = 0x01, DW_FORM_block2 = 0x03, DW_FORM_block4 = 0x04, DW_FORM_data2 = 0x05,
+			DW_FORM_data4 = 0x06, DW_FORM_data8 = 0x07, DW_FORM_string = 0x08, DW_FORM_block = 0x09,
+			DW_FORM_block1 = 0x0a, DW_FORM_data1 = 0x0b, DW_FORM_flag = 0x0c, DW_FORM_sdata = 0x0d,
+			DW_FORM_strp = 0x0e, DW_FORM_udata = 0x0f, DW_FORM_ref_addr = 0x10, DW_FORM_ref1 = 0x11,
+			DW_FORM_ref2 = 0x12, DW_FORM_ref4 = 0x13, DW_FORM_ref8 = 0x14, DW_FORM_ref_udata = 0x15,
+			DW_FORM_indirect = 0x16, DW_FORM_sec_offset = 0x17, DW_FORM_exprloc = 0x18, DW_FORM_flag_present = 0x19,
+			DW_FORM_strx = 0x1a, DW_FORM_addrx = 0x1b, DW_FORM_ref_sup4 = 0x1c, DW_FORM_strp_sup = 0x1d,
+			DW_FORM_data16 = 0x1e, DW_FORM_line_strp = 0x1f, DW_FORM_ref_sig8 = 0x20, DW_FORM_implicit_const = 0x21,
+			DW_FORM_loclistx = 0x22, DW_FORM_rnglistx = 0x23, DW_FORM_ref_sup8 = 0x24, DW_FORM_strx1 = 0x25,
+			DW_FORM_strx2 = 0x26, DW_FORM_strx3 = 0x27, DW_FORM_strx4 = 0x28, DW_FORM_addrx1 = 0x29,
+			DW_FORM_addrx2 = 0x2a, DW_FORM_addrx3 = 0x2b, DW_FORM_addrx4 = 0x2c,
+			DW_FORM_GNU_addr_index = 0x1f01, DW_FORM_GNU_str_index = 0x1f02, DW_FORM_GNU_ref_alt = 0x1f20,
+			DW_FORM_GNU_strp_alt = 0x1f21,
+		};
+
+		enum {
+			DW_AT_stmt_list = 0x10,
+			DW_AT_comp_dir = 0x1b,
+			DW_AT_str_offsets_base = 0x72,
+		};
+
+		enum {
+			DW_UT_compile = 0x01,
+			DW_UT_partial = 0x03,
+		};
+
+		enum {
+			DW_LNS_copy = 1, DW_LNS_advance_pc, DW_LNS_advance_line, DW_LNS_set_file, DW_LNS_set_column,
+			DW_LNS_negate_stmt, DW_LNS_set_basic_block, DW_LNS_const_add_pc, DW_LNS_fixed_advance_pc,
+		};
+
+		enum {
+			DW_LNE_end_sequence = 1,
+			DW_LNE_set_address = 2,
+			DW_LNE_define_file = 3,
+		};
+
+		enum {
+			DW_LNCT_path = 1,
+			DW_LNCT_directory_index = 2,
+		};
+
+		enum {	c_elfcompress_zlib = 1	};
+
+		struct compression_header32
+		{
+			uint32_t type, size, align;
+		};
+
+		struct compression_header64
+		{
+			uint32_t type, reserved;
+			uint64_t size, align;
+		};
+
+		class data_reader
+		{
+		public:
+			data_reader()
+				: _ptr(0), _end(0)
+			{	}
+
+			data_reader(const uint8_t *begin, const uint8_t *end)
+				: _ptr(begin), _end(end)
+			{	}
+
+			bool eof() const
+			{	return _ptr == _end;	}
+
+			const uint8_t *ptr() const
+			{	return _ptr;	}
+
+			const uint8_t *end() const
+			{	return _end;	}
+
+			template <typename T>
+			T read()
+			{
+				T value = T();
+
+				if (sizeof(T) <= static_cast<size_t>(_end - _ptr))
+					memcpy(&value, _ptr, sizeof(T)), _ptr += sizeof(T);
+				else
+					_ptr = _end;
+				return value;
+			}
+
+			uint64_t read_uint(unsigned int bytes)
+			{
+				switch (bytes)
+				{
+				case 1: return read<uint8_t>();
+				case 2: return read<uint16_t>();
+				case 4: return read<uint32_t>();
+				case 8: return read<uint64_t>();
+
+				default:
+					uint64_t value = 0;
+
+					for (unsigned int i = 0; i != bytes && _ptr != _end; ++i)
+						value |= static_cast<uint64_t>(*_ptr++) << (8 * i);
+					return value;
+				}
+			}
+
+			uint64_t read_uleb()
+			{
+				uint64_t value = 0;
+
+				for (unsigned int shift = 0; _ptr != _end; shift += 7)
+				{
+					const uint8_t b = *_ptr++;
+
+					if (shift < 64)
+						value |= static_cast<uint64_t>(b & 0x7F) << shift;
+					if (!(b & 0x80))
+						break;
+				}
+				return value;
+			}
+
+			int64_t read_sleb()
+			{
+				uint64_t value = 0;
+				unsigned int shift = 0;
+				uint8_t b = 0;
+
+				while (_ptr != _end)
+				{
+					b = *_ptr++;
+					if (shift < 64)
+						value |= static_cast<uint64_t>(b & 0x7F) << shift;
+					shift += 7;
+					if (!(b & 0x80))
+						break;
+				}
+				if (shift < 64 && (b & 0x40))
+					value |= ~0ull << shift;
+				return static_cast<int64_t>(value);
+			}
+
+			const char *read_string()
+			{
+				const uint8_t *s = _ptr;
+
+				while (_ptr != _end && *_ptr)
+					++_ptr;
+				if (_ptr == _end)
+					return "";
+				++_ptr;
+				return reinterpret_cast<const char *>(s);
+			}
+
+			void skip(uint64_t size)
+			{	_ptr = size < static_cast<uint64_t>(_end - _ptr) ? _ptr + size : _end;	}
+
+			// Reads the initial length of a unit (32- or 64-bit DWARF format) and returns the reader bounded by the unit.
+			data_reader read_unit(unsigned int &offset_size)
+			{
+				uint64_t length = read<uint32_t>();
+				const uint8_t *begin;
+
+				offset_size = 4;
+				if (0xFFFFFFFF == length)
+					length = read<uint64_t>(), offset_size = 8;
+				begin = _ptr;
+				skip(length);
+				return data_reader(begin, _ptr);
+			}
+
+		private:
+			const uint8_t *_ptr, *_end;
+		};
+
+		struct debug_section
+		{
+			debug_section()
+				: data(0), size(0)
+			{	}
+
+			data_reader reader(uint64_t offset = 0) const
+			{	return offset <= size ? data_reader(data + offset, data + size) : data_reader();	}
+
+			const char *string_at(uint64_t offset) const
+			{
+				if (offset >= size)
+					return 0;
+				const auto s = data + offset;
+				return memchr(s, 0, size - static_cast<size_t>(offset)) ? reinterpret_cast<const char *>(s) : 0;
+			}
+
+			const uint8_t *data;
+			size_t size;
+			vector<uint8_t> inflated;
+		};
+
+		struct debug_sections
+		{
+			debug_section info, abbrev, aranges, line, str, line_str, str_offsets;
+		};
+
+		struct unit_header
+		{
+			unsigned int version, offset_size, address_size;
+			uint64_t str_offsets_base;
+		};
+
+		struct form_value
+		{
+			enum kind_ {	constant, inline_string, string_offset, line_string_offset, string_index, other	};
+
+			kind_ kind;
+			uint64_t value;
+			const char *string;
+		};
+
+		struct file_entry
+		{
+			const char *name;
+			uint64_t directory;
+		};
+
+		void inflate_section(debug_section &section, bool zdebug, bool elf64)
+		{
+			data_reader r(section.data, section.data + section.size);
+			uint64_t inflated_size = 0;
+
+			if (zdebug)
+			{
+				if (section.size >= 12 && !memcmp(section.data, "ZLIB", 4))
+				{
+					r.skip(4);
+					for (int i = 0; i != 8; ++i)
+						inflated_size = (inflated_size << 8) | r.read<uint8_t>();
+				}
+			}
+			else if (elf64)
+			{
+				const auto h = r.read<compression_header64>();
+
+				if (c_elfcompress_zlib == h.type)
+					inflated_size = h.size;
+			}
+			else
+			{
+				const auto h = r.read<compression_header32>();
+
+				if (c_elfcompress_zlib == h.type)
+					inflated_size = h.size;
+			}
+
+			section.data = 0;
+			section.size = 0;
+
+#if defined(MP_HAVE_ZLIB)
+			uLongf length = static_cast<uLongf>(inflated_size);
+			const auto compressed = r.ptr();
+
+			section.inflated.resize(static_cast<size_t>(inflated_size));
+			if (inflated_size && Z_OK == uncompress(section.inflated.data(), &length, compressed,
+				static_cast<uLong>(r.end() - compressed)))
+			{
+				section.data = section.inflated.data();
+				section.size = static_cast<size_t>(length);
+				return;
+			}
+#else
+			(void)inflated_size;
+#endif
+			section.inflated.clear();
+		}
+
+		bool load_sections(const elf_image &image, debug_sections &sections)
+		{
+			for (auto i = image.sections().begin(); i != image.sections().end(); ++i)
+			{
+				const section &s = *i;
+				const bool zdebug = !strncmp(s.name, ".zdebug_", 8);
+				const char *name = zdebug ? s.name + 8 : !strncmp(s.name, ".debug_", 7) ? s.name + 7 : 0;
+				debug_section *target = 0;
+
+				if (!name)
+					continue;
+				else if (!strcmp(name, "info"))
+					target = &sections.info;
+				else if (!strcmp(name, "abbrev"))
+					target = &sections.abbrev;
+				else if (!strcmp(name, "aranges"))
+					target = &sections.aranges;
+				else if (!strcmp(name, "line"))
+					target = &sections.line;
+				else if (!strcmp(name, "str"))
+					target = &sections.str;
+				else if (!strcmp(name, "line_str"))
+					target = &sections.line_str;
+				else if (!strcmp(name, "str_offsets"))
+					target = &sections.str_offsets;
+				else
+					continue;
+				if (!(target->data = image.map_section(s)))
+					continue;
+				target->size = s.size;
+				if (zdebug || (s.flags & SHF_COMPRESSED))
+					inflate_section(*target, zdebug, image.is_64bit());
+			}
+			return sections.info.size && sections.abbrev.size && sections.line.size;
+		}
+
+		form_value read_form(data_reader &r, uint64_t form, const unit_header &unit)
+		{
+			form_value v = {	form_value::constant, 0, 0	};
+
+			switch (form)
+			{
+			case DW_FORM_data1: case DW_FORM_ref1: case DW_FORM_flag: case DW_FORM_strx1: case DW_FORM_addrx1:
+				v.value = r.read_uint(1);
+				break;
+
+			case DW_FORM_data2: case DW_FORM_ref2: case DW_FORM_strx2: case DW_FORM_addrx2:
+				v.value = r.read_uint(2);
+				break;
+
+			case DW_FORM_strx3: case DW_FORM_addrx3:
+				v.value = r.read_uint(3);
+				break;
+
+			case DW_FORM_data4: case DW_FORM_ref4: case DW_FORM_ref_sup4: case DW_FORM_strx4: case DW_FORM_addrx4:
+				v.value = r.read_uint(4);
+				break;
+
+			case DW_FORM_data8: case DW_FORM_ref8: case DW_FORM_ref_sig8: case DW_FORM_ref_sup8:
+				v.value = r.read_uint(8);
+				break;
+
+			case DW_FORM_udata: case DW_FORM_ref_udata: case DW_FORM_strx: case DW_FORM_addrx: case DW_FORM_loclistx:
+			case DW_FORM_rnglistx: case DW_FORM_GNU_addr_index: case DW_FORM_GNU_str_index:
+				v.value = r.read_uleb();
+				break;
+
+			case DW_FORM_sdata:
+				v.value = static_cast<uint64_t>(r.read_sleb());
+				break;
+
+			case DW_FORM_addr:
+				v.value = r.read_uint(unit.address_size);
+				break;
+
+			case DW_FORM_ref_addr:
+				v.value = r.read_uint(unit.version < 3 ? unit.address_size : unit.offset_size);
+				break;
+
+			case DW_FORM_strp: case DW_FORM_line_strp: case DW_FORM_sec_offset: case DW_FORM_strp_sup:
+			case DW_FORM_GNU_ref_alt: case DW_FORM_GNU_strp_alt:
+				v.value = r.read_uint(unit.offset_size);
+				break;
+
+			case DW_FORM_string:
+				v.kind = form_value::inline_string;
+				v.string = r.read_string();
+				return v;
+
+			case DW_FORM_block1:
+				r.skip(r.read_uint(1));
+				break;
+
+			case DW_FORM_block2:
+				r.skip(r.read_uint(2));
+				break;
+
+			case DW_FORM_block4:
+				r.skip(r.read_uint(4));
+				break;
+
+			case DW_FORM_block: case DW_FORM_exprloc:
+				r.skip(r.read_uleb());
+				break;
+
+			case DW_FORM_data16:
+				r.skip(16);
+				break;
+
+			case DW_FORM_flag_present: case DW_FORM_implicit_const:
+				break;
+
+			case DW_FORM_indirect:
+				return read_form(r, r.read_uleb(), unit);
+
+			default:
+				r.skip(~0ull); // Cannot tell the size of an unknown form - the rest of the entry is unreadable.
+				v.kind = form_value::other;
+				return v;
+			}
+
+			switch (form)
+			{
+			case DW_FORM_strp:
+				v.kind = form_value::string_offset;
+				break;
+
+			case DW_FORM_line_strp:
+				v.kind = form_value::line_string_offset;
+				break;
+
+			case DW_FORM_strx: case DW_FORM_strx1: case DW_FORM_strx2: case DW_FORM_strx3: case DW_FORM_strx4:
+			case DW_FORM_GNU_str_index:
+				v.kind = form_value::string_index;
+				break;
+			}
+			return v;
+		}
+
+		const char *get_string(const debug_sections &sections, const form_value &v, const unit_header &unit)
+		{
+			switch (v.kind)
+			{
+			case form_value::inline_string:
+				return v.string;
+
+			case form_value::string_offset:
+				return sections.str.string_at(v.value);
+
+			case form_value::line_string_offset:
+				return sections.line_str.string_at(v.value);
+
+			case form_value::string_index:
+				{
+					auto r = sections.str_offsets.reader(unit.str_offsets_base + v.value * unit.offset_size);
+
+					return r.eof() ? 0 : sections.str.string_at(r.read_uint(unit.offset_size));
+				}
+
+			default:
+				return 0;
+			}
+		}
+
+		bool find_abbreviation(const debug_section &abbrev, uint64_t offset, uint64_t code, data_reader &specs)
+		{
+			for (auto r = abbrev.reader(offset); !r.eof(); )
+			{
+				const auto code_ = r.read_uleb();
+
+				if (!code_)
+					break;
+				r.read_uleb(); // tag
+				r.read<uint8_t>(); // children
+				if (code_ == code)
+					return specs = r, true;
+				for (uint64_t attribute = 1, form = 1; attribute || form; )
+				{
+					attribute = r.read_uleb(), form = r.read_uleb();
+					if (DW_FORM_implicit_const == form)
+						r.read_sleb();
+					if (r.eof())
+						return false;
+				}
+			}
+			return false;
+		}
+
+		// Reads the root DIE of the compilation unit for the line program offset and the compilation directory.
+		bool read_unit_root(const debug_sections &sections, data_reader r, unit_header &unit, uint64_t &line_offset,
+			const char *&compilation_directory)
+		{
+			uint64_t abbrev_offset;
+			form_value comp_dir = {	form_value::other, 0, 0	};
+			bool has_line_program = false;
+			data_reader specs;
+
+			if (unit.version < 2 || unit.version > 5)
+				return false;
+			if (unit.version >= 5)
+			{
+				const auto unit_type = r.read<uint8_t>();
+
+				if (DW_UT_compile != unit_type && DW_UT_partial != unit_type)
+					return false;
+				unit.address_size = r.read<uint8_t>();
+				abbrev_offset = r.read_uint(unit.offset_size);
+			}
+			else
+			{
+				abbrev_offset = r.read_uint(unit.offset_size);
+				unit.address_size = r.read<uint8_t>();
+			}
+			unit.str_offsets_base = unit.version >= 5 ? 2 * unit.offset_size : 0;
+			if (!find_abbreviation(sections.abbrev, abbrev_offset, r.read_uleb(), specs))
+				return false;
+			for (uint64_t attribute, form; attribute = specs.read_uleb(), form = specs.read_uleb(), attribute || form; )
+			{
+				const int64_t implicit = DW_FORM_implicit_const == form ? specs.read_sleb() : 0;
+				form_value v = read_form(r, form, unit);
+
+				if (DW_FORM_implicit_const == form)
+					v.value = static_cast<uint64_t>(implicit);
+				if (form_value::other == v.kind || specs.eof())
+					break;
+				switch (attribute)
+				{
+				case DW_AT_stmt_list:
+					line_offset = v.value, has_line_program = true;
+					break;
+
+				case DW_AT_comp_dir:
+					comp_dir = v;
+					break;
+
+				case DW_AT_str_offsets_base:
+					unit.str_offsets_base = v.value;
+					break;
+				}
+			}
+			compilation_directory = get_string(sections, comp_dir, unit);
+			return has_line_program;
+		}
+
+		string join_path(const string &lhs, const char *rhs)
+		{
+			if (lhs.empty())
+				return rhs;
+			if (!*rhs)
+				return lhs;
+			return lhs + ('/' == lhs.back() ? "" : "/") + rhs;
+		}
+
+		class line_program_reader
+		{
+		public:
+			line_program_reader(const debug_sections &sections, line_table &table, unordered_map<string, unsigned> &ids,
+				size_t &unresolved);
+
+			void read(uint64_t offset, const char *compilation_directory, unsigned int address_size);
+
+		private:
+			bool read_header(data_reader &r, unsigned int version, const unit_header &unit);
+			void read_entries(data_reader &r, const unit_header &unit, bool directories);
+			void run(data_reader &r);
+			void assign(size_t index, uint64_t file, unsigned int line);
+			unsigned int get_file_id(uint64_t file);
+
+		private:
+			const debug_sections &_sections;
+			line_table &_table;
+			unordered_map<string, unsigned> &_ids;
+			size_t &_unresolved;
+			const char *_compilation_directory;
+			unsigned int _minimum_instruction_length, _line_range, _opcode_base;
+			int _line_base;
+			const uint8_t *_standard_opcode_lengths;
+			vector<const char *> _directories;
+			vector<file_entry> _files;
+			vector<unsigned int> _file_ids;
+		};
+
+
+
+		line_program_reader::line_program_reader(const debug_sections &sections, line_table &table,
+				unordered_map<string, unsigned> &ids, size_t &unresolved)
+			: _sections(sections), _table(table), _ids(ids), _unresolved(unresolved)
+		{	}
+
+		void line_program_reader::read(uint64_t offset, const char *compilation_directory, unsigned int address_size)
+		{
+			unit_header unit = {	0, 0, address_size, 0	};
+			auto r = _sections.line.reader(offset);
+			auto program = r.read_unit(unit.offset_size);
+
+			unit.version = program.read<uint16_t>();
+			if (unit.version < 2 || unit.version > 5)
+				return;
+			_compilation_directory = compilation_directory;
+			if (read_header(program, unit.version, unit))
+				run(program);
+		}
+
+		bool line_program_reader::read_header(data_reader &r, unsigned int version, const unit_header &unit)
+		{
+			unit_header header_unit = unit;
+
+			if (version >= 5)
+			{
+				header_unit.address_size = r.read<uint8_t>();
+				r.read<uint8_t>(); // segment selector size
+			}
+
+			const auto header_length = r.read_uint(unit.offset_size);
+			auto h = r;
+
+			r.skip(header_length);
+			_minimum_instruction_length = h.read<uint8_t>();
+			if (version >= 4)
+				h.read<uint8_t>(); // maximum operations per instruction (VLIW)
+			h.read<uint8_t>(); // default is_stmt
+			_line_base = h.read<int8_t>();
+			_line_range = h.read<uint8_t>();
+			_opcode_base = h.read<uint8_t>();
+			if (!_opcode_base || static_cast<size_t>(h.end() - h.ptr()) < _opcode_base - 1u)
+				return false; // The standard opcode lengths are truncated.
+			_standard_opcode_lengths = h.ptr();
+			h.skip(_opcode_base - 1);
+			_directories.clear();
+			_files.clear();
+			if (version >= 5)
+			{
+				read_entries(h, header_unit, true);
+				read_entries(h, header_unit, false);
+			}
+			else
+			{
+				_directories.push_back(_compilation_directory);
+				for (const char *directory; directory = h.read_string(), *directory; )
+					_directories.push_back(directory);
+
+				const file_entry nothing = {	0, 0	};
+
+				_files.push_back(nothing); // File numbering starts from 1 prior to DWARF 5.
+				for (file_entry f; f.name = h.read_string(), *f.name; )
+				{
+					f.directory = h.read_uleb();
+					h.read_uleb(); // modification time
+					h.read_uleb(); // length
+					_files.push_back(f);
+				}
+			}
+			_file_ids.assign(_files.size(), 0u);
+			return _line_range && !r.eof();
+		}
+
+		void line_program_reader::read_entries(data_reader &r, const unit_header &unit, bool directories)
+		{
+			vector< pair<uint64_t, uint64_t> > format(r.read<uint8_t>());
+
+			for (auto i = format.begin(); i != format.end(); ++i)
+				i->first = r.read_uleb(), i->second = r.read_uleb();
+			for (auto n = r.read_uleb(); n-- && !r.eof(); )
+			{
+				file_entry entry = {	0, 0	};
+
+				for (auto i = format.begin(); i != format.end(); ++i)
+				{
+					const auto v = read_form(r, i->second, unit);
+
+					if (DW_LNCT_path == i->first)
+						entry.name = get_string(_sections, v, unit);
+					else if (DW_LNCT_directory_index == i->first)
+						entry.directory = v.value;
+				}
+				if (directories)
+					_directories.push_back(entry.name);
+				else
+					_files.push_back(entry);
+			}
+		}
+
+		void line_program_reader::run(data_reader &r)
+		{
+			const auto &addresses = _table.addresses;
+			uint64_t address = 0, row_address = 0;
+			uint64_t file = 1, row_file = 0;
+			int64_t line = 1;
+			unsigned int row_line = 0;
+			bool in_sequence = false;
+			size_t next = 0;
+
+			// Each row covers addresses up to the next row in the same sequence, so the addresses requested are assigned the
+			// position of the last row preceding them.
+			auto emit_row = [&] (bool end_sequence) {
+				if (!in_sequence || address < row_address)
+				{
+					next = lower_bound(addresses.begin(), addresses.end(), static_cast<ptrdiff_t>(address)) - addresses.begin();
+				}
+				else
+				{
+					for (; next != addresses.size() && addresses[next] < static_cast<ptrdiff_t>(address); ++next)
+						assign(next, row_file, row_line);
+				}
+				row_address = address, row_file = file, row_line = static_cast<unsigned int>(line);
+				in_sequence = !end_sequence;
+			};
+
+			while (!r.eof() && _unresolved)
+			{
+				const unsigned int opcode = r.read<uint8_t>();
+
+				if (opcode >= _opcode_base)
+				{
+					const auto adjusted = opcode - _opcode_base;
+
+					address += (adjusted / _line_range) * _minimum_instruction_length;
+					line += _line_base + static_cast<int>(adjusted % _line_range);
+					emit_row(false);
+				}
+				else switch (opcode)
+				{
+				case 0:
+					{
+						const auto length = r.read_uleb();
+						auto e = r;
+
+						r.skip(length);
+						switch (e.read<uint8_t>())
+						{
+						case DW_LNE_end_sequence:
+							emit_row(true);
+							address = 0, file = 1, line = 1;
+							break;
+
+						case DW_LNE_set_address:
+							address = e.read_uint(static_cast<unsigned int>(length - 1));
+							break;
+
+						case DW_LNE_define_file:
+							{
+								file_entry f = {	e.read_string(), e.read_uleb()	};
+
+								_files.push_back(f);
+								_file_ids.push_back(0u);
+							}
+							break;
+						}
+					}
+					break;
+
+				case DW_LNS_copy:
+					emit_row(false);
+					break;
+
+				case DW_LNS_advance_pc:
+					address += r.read_uleb() * _minimum_instruction_length;
+					break;
+
+				case DW_LNS_advance_line:
+					line += r.read_sleb();
+					break;
+
+				case DW_LNS_set_file:
+					file = r.read_uleb();
+					break;
+
+				case DW_LNS_const_add_pc:
+					address += ((255 - _opcode_base) / _line_range) * _minimum_instruction_length;
+					break;
+
+				case DW_LNS_fixed_advance_pc:
+					address += r.read<uint16_t>();
+					break;
+
+				default:
+					// 0 < opcode < _opcode_base: read_header() has made sure all the lengths are present.
+					for (auto n = _standard_opcode_lengths[opcode - 1]; n--; )
+						r.read_uleb();
+				}
+			}
+		}
+
+		void line_program_reader::assign(size_t index, uint64_t file, unsigned int line)
+		{
+			auto &position = _table.positions[index];
+
+			if (position.line || !line)
+				return;
+			if (const auto file_id = get_file_id(file))
+				position.file_id = file_id, position.line = line, _unresolved--;
+		}
+
+		unsigned int line_program_reader::get_file_id(uint64_t file)
+		{
+			if (file >= _files.size() || !_files[file].name)
+				return 0;
+
+			auto &id = _file_ids[static_cast<size_t>(file)];
+
+			if (!id)
+			{
+				const auto &f = _files[static_cast<size_t>(file)];
+				const char *directory = f.directory < _directories.size() ? _directories[f.directory] : 0;
+				string path;
+
+				if ('/' != *f.name)
+				{
+					if (directory && '/' != *directory && _compilation_directory && directory != _compilation_directory)
+						path = join_path(_compilation_directory, directory);
+					else if (directory)
+						path = directory;
+					else if (_compilation_directory)
+						path = _compilation_directory;
+				}
+				path = join_path(path, f.name);
+
+				const auto i = _ids.insert(make_pair(path, static_cast<unsigned>(_ids.size() + 1)));
+
+				if (i.second)
+					_table.files.push_back(path);
+				id = i.first->second;
+			}
+			return id;
+		}
+
+		bool contains_any(const vector<ptrdiff_t> &addresses, uint64_t begin, uint64_t end)
+		{
+			const auto i = lower_bound(addresses.begin(), addresses.end(), static_cast<ptrdiff_t>(begin));
+
+			return addresses.end() != i && *i < static_cast<ptrdiff_t>(end);
+		}
+
+		// Collects the compilation units described in .debug_aranges ('described') and the ones of them covering any of
+		// the addresses requested ('required').
+		void select_units(const debug_section &aranges, const vector<ptrdiff_t> &addresses,
+			vector<uint64_t> &described, vector<uint64_t> &required)
+		{
+			for (auto r = aranges.reader(); !r.eof(); )
+			{
+				const auto set_begin = r.ptr();
+				unit_header unit = {	0, 0, 0, 0	};
+				auto set = r.read_unit(unit.offset_size);
+
+				unit.version = set.read<uint16_t>();
+
+				const auto info_offset = set.read_uint(unit.offset_size);
+				const auto tuple_size = 2 * (unit.address_size = set.read<uint8_t>());
+				const auto segment_size = set.read<uint8_t>();
+
+				if (2 != unit.version || !tuple_size || segment_size)
+					continue;
+				set.skip((tuple_size - (set.ptr() - set_begin) % tuple_size) % tuple_size);
+				described.push_back(info_offset);
+				while (!set.eof())
+				{
+					const auto begin = set.read_uint(unit.address_size), length = set.read_uint(unit.address_size);
+
+					if (!begin && !length)
+						break;
+					if (contains_any(addresses, begin, begin + length))
+					{
+						required.push_back(info_offset);
+						break;
+					}
+				}
+			}
+			sort(described.begin(), described.end());
+			sort(required.begin(), required.end());
+		}
+	}
+
+	void read_line_positions(const elf_image &image, line_table &table)
+	{
+		const line_position unresolved_position = {	0, 0	};
+		debug_sections sections;
+		vector<uint64_t> described, required;
+		unordered_map<string, unsigned> ids;
+		size_t unresolved = table.addresses.size();
+
+		table.positions.assign(table.addresses.size(), unresolved_position);
+		table.files.clear();
+		if (!unresolved || !load_sections(image, sections))
+			return;
+		select_units(sections.aranges, table.addresses, described, required);
+
+		line_program_reader lines(sections, table, ids, unresolved);
+
+		// Compilation units missing from .debug_aranges (it is optional) are read unconditionally.
+		for (auto r = sections.info.reader(); !r.eof() && unresolved; )
+		{
+			const auto offset = static_cast<uint64_t>(r.ptr() - sections.info.data);
+			unit_header unit = {	0, 0, 0, 0	};
+			auto u = r.read_unit(unit.offset_size);
+			uint64_t line_offset = 0;
+			const char *compilation_directory = 0;
+
+			unit.version = u.read<uint16_t>();
+			if (!binary_search(required.begin(), required.end(), offset)
+					&& binary_search(described.begin(), described.end(), offset))
+				continue;
+			if (read_unit_root(sections, u, unit, line_offset, compilation_directory))
+				lines.read(line_offset, compilation_directory, unit.address_size);
+		}
+	}
+}
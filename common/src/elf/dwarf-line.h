@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace symreader
+{
+	class elf_image;
+
+	struct line_position
+	{
+		unsigned int file_id; // Index into the file table produced (1-based), zero if unresolved.
+		unsigned int line;
+	};
+
+	struct line_table
+	{
+		std::vector<std::ptrdiff_t> addresses; // Sorted unique addresses to resolve.
+		std::vector<line_position> positions; // Parallel to 'addresses'.
+		std::vector<std::string> files; // File with id N is stored at N - 1.
+	};
+
+	// Resolves source positions of the sorted unique 'table.addresses' from the DWARF line programs of the ELF image.
+	// Only the compilation units covering the addresses (according to .debug_aranges) are decoded, and only the files
+	// actually referenced by the resolved positions are put into the file table. Compressed (.zdebug* and
+	// SHF_COMPRESSED) sections are read when the library is built with zlib, and are skipped otherwise.
+	void read_line_positions(const elf_image &image, line_table &table);
+}
@@ -7,5 +7,24 @@ namespace symreader
 {
 	typedef std::pair<const void *, size_t> mapped_region;
 
-	std::shared_ptr<const mapped_region> map_file(const char *path);
+	class file
+	{
+	public:
+		explicit file(const char *path);
+		~file();
+
+		bool valid() const;
+		size_t size() const;
+
+		bool read(void *buffer, size_t offset, size_t length) const;
+		std::shared_ptr<const mapped_region> map(size_t offset, size_t length) const;
+
+	private:
+		file(const file &other);
+		void operator =(const file &rhs);
+
+	private:
+		int _file;
+		size_t _size;
+	};
 }
@@ -1,8 +1,8 @@
 #include "filemapping.h"
 
 #include <fcntl.h>
-#include <stdio.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 using namespace std;
@@ -11,50 +11,74 @@ namespace symreader
 {
 	namespace
 	{
-		size_t get_file_size(const char *path)
-		{
-			if (FILE *f = fopen(path, "rb"))
-			{
-				fseek(f, 0, SEEK_END);
-				size_t s = ftell(f);
-				fseek(f, 0, SEEK_SET);
-				fclose(f);
-				return s;
-			}
-			return 0;
-		}
-
 		struct mapping : mapped_region
 		{
-			mapping(const char *path)
-				: mapped_region(0, 0)
+			mapping(int file, size_t offset, size_t length)
+				: mapped_region(0, 0), base(MAP_FAILED), size(0)
 			{
-				if ((file = ::open(path, O_RDONLY)) >= 0)
-				{
-					if (second = get_file_size(path), second)
-					{
-						first = ::mmap(0, second, PROT_READ, MAP_PRIVATE, file, 0);
-						if (first != MAP_FAILED)
-							return;
-						first = 0, second = 0;
-					}
-					close(file);
-					file = -1;
-				}
+				const size_t page_mask = static_cast<size_t>(sysconf(_SC_PAGESIZE)) - 1;
+				const size_t aligned_offset = offset & ~page_mask;
+
+				size = length + (offset - aligned_offset);
+				base = ::mmap(0, size, PROT_READ, MAP_PRIVATE, file, static_cast<off_t>(aligned_offset));
+				if (base != MAP_FAILED)
+					first = static_cast<const char *>(base) + (offset - aligned_offset), second = length;
 			}
 
 			~mapping()
 			{
-				if (first)
-					::munmap((void *)first, second);
-				if (-1 != file)
-					::close(file);
+				if (base != MAP_FAILED)
+					::munmap(base, size);
 			}
 
-			int file;
+			void *base;
+			size_t size;
 		};
 	}
 
-	shared_ptr<const mapped_region> map_file(const char *path)
-	{	return shared_ptr<mapping>(new mapping(path));	}
+	file::file(const char *path)
+		: _file(::open(path, O_RDONLY)), _size(0)
+	{
+		struct stat s;
+
+		if (_file >= 0 && !::fstat(_file, &s) && S_ISREG(s.st_mode))
+			_size = static_cast<size_t>(s.st_size);
+	}
+
+	file::~file()
+	{
+		if (_file >= 0)
+			::close(_file);
+	}
+
+	bool file::valid() const
+	{	return _file >= 0 && _size;	}
+
+	size_t file::size() const
+	{	return _size;	}
+
+	bool file::read(void *buffer, size_t offset, size_t length) const
+	{
+		if (offset > _size || length > _size - offset)
+			return false;
+		for (auto ptr = static_cast<char *>(buffer); length; )
+		{
+			const auto n = ::pread(_file, ptr, length, static_cast<off_t>(offset));
+
+			if (n <= 0)
+				return false;
+			ptr += n, offset += n, length -= n;
+		}
+		return true;
+	}
+
+	shared_ptr<const mapped_region> file::map(size_t offset, size_t length) const
+	{
+		if (!length || offset > _size || length > _size - offset)
+			return shared_ptr<const mapped_region>();
+
+		shared_ptr<mapping> m(new mapping(_file, offset, length));
+
+		return m->first ? m : shared_ptr<const mapped_region>();
+	}
 }
@@ -1,8 +1,7 @@
 #include "sym-elf.h"
 
-#include <cstdint>
+#include <algorithm>
 #include <elf.h>
-#include <stdexcept>
 #include <string.h>
 
 using namespace std;
@@ -11,130 +10,243 @@ namespace symreader
 {
 	namespace
 	{
-		enum bitness { _unsupported, _32bit, _64bit };
+		const size_t c_symbols_per_read = 1024;
+		const char *c_debug_root = "/usr/lib/debug";
 
-		bitness get_bitness(const void *image)
+		bool is_native_byte_order(unsigned char encoding)
 		{
-			if (static_cast<const uint8_t *>(image)[EI_CLASS] == ELFCLASS32)
-				return _32bit;
-			else if (static_cast<const uint8_t *>(image)[EI_CLASS] == ELFCLASS64)
-				return _64bit;
-			return _unsupported;
+			const uint16_t probe = 1;
+
+			return (ELFDATA2LSB == encoding) == (1 == *reinterpret_cast<const uint8_t *>(&probe));
+		}
+
+		string directory_of(const string &path)
+		{
+			const auto slash = path.rfind('/');
+
+			return string::npos != slash ? path.substr(0, slash) : string(".");
+		}
+	}
+
+	elf_image::elf_image(const char *path)
+		: _file(path), _64bit(false)
+	{
+		unsigned char ident[EI_NIDENT];
+
+		if (!_file.read(ident, 0, sizeof(ident)) || memcmp(ident, ELFMAG, SELFMAG) || !is_native_byte_order(ident[EI_DATA]))
+			return;
+		if (ELFCLASS32 == ident[EI_CLASS])
+			read_headers<Elf32_Ehdr, Elf32_Shdr>();
+		else if (ELFCLASS64 == ident[EI_CLASS])
+			_64bit = true, read_headers<Elf64_Ehdr, Elf64_Shdr>();
+	}
+
+	bool elf_image::valid() const
+	{	return !_sections.empty();	}
+
+	bool elf_image::is_64bit() const
+	{	return _64bit;	}
+
+	const vector<section> &elf_image::sections() const
+	{	return _sections;	}
+
+	const section *elf_image::find_section(const char *name) const
+	{
+		for (auto i = _sections.begin(); i != _sections.end(); ++i)
+		{
+			if (!strcmp(i->name, name))
+				return &*i;
 		}
+		return 0;
+	}
+
+	const uint8_t *elf_image::map_section(const section &s) const
+	{
+		if (SHT_NOBITS == s.type)
+			return 0;
+
+		auto &m = _mappings[s.index];
+
+		if (!m)
+			m = _file.map(static_cast<size_t>(s.file_offset), s.size);
+		return m ? static_cast<const uint8_t *>(m->first) : 0;
+	}
+
+	void elf_image::read_symbols(const function<void (const symbol &)> &callback) const
+	{
+		const auto text = find_section(".text");
+		const auto code_section_index = text ? text->index : -1;
+
+		for (auto i = _sections.begin(); i != _sections.end(); ++i)
+		{
+			if ((SHT_SYMTAB != i->type && SHT_DYNSYM != i->type) || i->link >= _sections.size())
+				continue;
+			if (_64bit)
+				read_symbols<Elf64_Sym>(*i, _sections[i->link], code_section_index, callback);
+			else
+				read_symbols<Elf32_Sym>(*i, _sections[i->link], code_section_index, callback);
+		}
+	}
+
+	vector<uint8_t> elf_image::get_build_id() const
+	{
+		vector<uint8_t> notes;
 
-		template <typename ElfHeaderT, typename SectionHeaderT, typename CallbackT>
-		void read_sections(const void *image, size_t /*size*/, const CallbackT &callback)
+		for (auto i = _sections.begin(); i != _sections.end(); ++i)
 		{
-			const ElfHeaderT *ehdr = static_cast<const ElfHeaderT *>(image);
-			const SectionHeaderT *shdrs = (const SectionHeaderT *)((const uint8_t *)image + ehdr->e_shoff);
-			const SectionHeaderT *strhdr = &shdrs[ehdr->e_shstrndx];
-			const char *strtab = static_cast<const char *>(image) + strhdr->sh_offset;
+			if (SHT_NOTE != i->type)
+				continue;
 
-			for (int i = 0; i < ehdr->e_shnum; ++i)
+			const auto alignment = max<size_t>(4, i->address_align);
+			const auto align = [alignment] (size_t value) {	return (value + alignment - 1) & ~(alignment - 1);	};
+
+			notes.resize(i->size);
+			if (!_file.read(notes.data(), static_cast<size_t>(i->file_offset), notes.size()))
+				continue;
+			for (size_t offset = 0; offset + sizeof(Elf32_Nhdr) <= notes.size(); )
 			{
-				section s;
-
-				s.index= i;
-				s.name = strtab + shdrs[i].sh_name;
-				s.type = shdrs[i].sh_type;
-				s.virtual_address = static_cast<ptrdiff_t>(shdrs[i].sh_addr);
-				s.file_offset = static_cast<ptrdiff_t>(shdrs[i].sh_offset);
-				s.size = static_cast<size_t>(shdrs[i].sh_size);
-				s.entry_size = static_cast<size_t>(shdrs[i].sh_entsize);
-				s.address_align = static_cast<size_t>(shdrs[i].sh_addralign);
-				callback(s);
+				Elf32_Nhdr note; // Note headers are the same for ELF32 and ELF64.
+
+				memcpy(&note, notes.data() + offset, sizeof(note));
+
+				const auto name = offset + sizeof(note);
+				const auto description = name + align(note.n_namesz);
+				const auto next = description + align(note.n_descsz);
+
+				if (next > notes.size())
+					break;
+				if (NT_GNU_BUILD_ID == note.n_type && 4 == note.n_namesz && !memcmp(&notes[name], "GNU", 4))
+					return vector<uint8_t>(notes.begin() + description, notes.begin() + description + note.n_descsz);
+				offset = next;
 			}
 		}
+		return vector<uint8_t>();
+	}
+
+	const char *elf_image::get_debuglink() const
+	{
+		const auto s = find_section(".gnu_debuglink");
+		const auto data = s ? map_section(*s) : 0;
+
+		return data && memchr(data, 0, s->size) && *data ? reinterpret_cast<const char *>(data) : 0;
+	}
+
+	template <typename ElfHeaderT, typename SectionHeaderT>
+	bool elf_image::read_headers()
+	{
+		ElfHeaderT ehdr;
+		SectionHeaderT first;
+		size_t count, names_index;
+		vector<SectionHeaderT> shdrs;
+
+		if (!_file.read(&ehdr, 0, sizeof(ehdr)) || !ehdr.e_shoff || sizeof(SectionHeaderT) != ehdr.e_shentsize
+				|| !_file.read(&first, static_cast<size_t>(ehdr.e_shoff), sizeof(first)))
+			return false;
+		count = ehdr.e_shnum ? ehdr.e_shnum : static_cast<size_t>(first.sh_size); // Extended section numbering.
+		names_index = SHN_XINDEX != ehdr.e_shstrndx ? ehdr.e_shstrndx : first.sh_link;
+		if (count > _file.size() / sizeof(SectionHeaderT) || names_index >= count)
+			return false;
+		shdrs.resize(count);
+		if (!_file.read(shdrs.data(), static_cast<size_t>(ehdr.e_shoff), count * sizeof(SectionHeaderT)))
+			return false;
+
+		const auto &names = shdrs[names_index];
+
+		_section_names.resize(static_cast<size_t>(names.sh_size) + 1);
+		if (!_file.read(_section_names.data(), static_cast<size_t>(names.sh_offset), _section_names.size() - 1))
+			return false;
+		_sections.resize(count);
+		for (size_t i = 0; i != count; ++i)
+		{
+			section &s = _sections[i];
+
+			s.index = static_cast<int>(i);
+			s.name = shdrs[i].sh_name < _section_names.size() ? &_section_names[shdrs[i].sh_name] : "";
+			s.type = shdrs[i].sh_type;
+			s.link = shdrs[i].sh_link;
+			s.flags = static_cast<size_t>(shdrs[i].sh_flags);
+			s.virtual_address = static_cast<ptrdiff_t>(shdrs[i].sh_addr);
+			s.file_offset = static_cast<ptrdiff_t>(shdrs[i].sh_offset);
+			s.size = static_cast<size_t>(shdrs[i].sh_size);
+			s.entry_size = static_cast<size_t>(shdrs[i].sh_entsize);
+			s.address_align = static_cast<size_t>(shdrs[i].sh_addralign);
+		}
+		return true;
+	}
 
+	template <typename SymbolEntryT>
+	void elf_image::read_symbols(const section &symbols, const section &names, int code_section_index,
+		const function<void (const symbol &)> &callback) const
+	{
+		const size_t total_syms = symbols.size / sizeof(SymbolEntryT);
+		const auto strings = reinterpret_cast<const char *>(map_section(names));
+		vector<SymbolEntryT> buffer(min(c_symbols_per_read, total_syms));
 
-		template <typename SymbolEntryT, typename CallbackT>
-		void read_symbols(const void *image, unsigned int code_section_index, const section &symbols, const char *names,
-			const CallbackT &callback)
+		if (!strings || SHT_NOBITS == symbols.type)
+			return;
+		for (size_t i = 0; i < total_syms; i += buffer.size())
 		{
-			const size_t total_syms = symbols.size / sizeof(SymbolEntryT);
-			const SymbolEntryT *syms_data = (const SymbolEntryT *)((const uint8_t *)image + symbols.file_offset);
+			const auto n = min(buffer.size(), total_syms - i);
 
-			for (size_t i = 0; i < total_syms; ++i)
+			if (!_file.read(buffer.data(), static_cast<size_t>(symbols.file_offset) + i * sizeof(SymbolEntryT),
+				n * sizeof(SymbolEntryT)))
+			{
+				return;
+			}
+			for (auto sd = buffer.begin(); sd != buffer.begin() + n; ++sd)
 			{
 				symbol s = { };
-				const SymbolEntryT &sd = syms_data[i];
-				const unsigned type = ELF32_ST_TYPE(sd.st_info);
 
-				if (type != STT_FUNC)
+				if (STT_FUNC != ELF32_ST_TYPE(sd->st_info))
 					continue;
-				if (sd.st_shndx != code_section_index || !sd.st_size)
+				if (sd->st_shndx != code_section_index || !sd->st_size || sd->st_name >= names.size)
 					continue;
-				s.name = names + sd.st_name;
-				s.size = static_cast<size_t>(sd.st_size);
-				s.virtual_address = static_cast<ptrdiff_t>(sd.st_value);
+				s.name = strings + sd->st_name;
+				s.size = static_cast<size_t>(sd->st_size);
+				s.virtual_address = static_cast<ptrdiff_t>(sd->st_value);
 				callback(s);
 			}
 		}
 	}
 
-	void read_sections(const void *image, size_t size, const std::function<void (const section &)> &callback)
-	{
-		switch (get_bitness(image))
-		{
-		case _32bit:
-			read_sections<Elf32_Ehdr, Elf32_Shdr>(image, size, callback);
-			break;
 
-		case _64bit:
-			read_sections<Elf64_Ehdr, Elf64_Shdr>(image, size, callback);
-			break;
+	unique_ptr<elf_image> open_debug_image(const elf_image &image, const string &path)
+	{
+		const char c_hex[] = "0123456789abcdef";
+		const auto build_id = image.get_build_id();
+		vector<string> candidates;
 
-		default:
-			throw runtime_error("Only 32-bit & 64-bit platforms are supported!");
-		}
-	}
+		if (build_id.size() > 1)
+		{
+			string name = string(c_debug_root) + "/.build-id/";
 
-	void read_symbols(const void *image, size_t size, const std::function<void (const symbol &)> &callback)
-	{
-		unsigned code_section_index = 0;
-		section symtab = { }, dynsym = { };
-		const char *strtab = 0, *dynstr = 0;
-
-		read_sections(image, size, [&] (const section &s) {
-			if (!strcmp(s.name, ".text"))
-				code_section_index = s.index;
-			switch (s.type)
+			for (auto i = build_id.begin(); i != build_id.end(); ++i)
 			{
-			case SHT_STRTAB:
-				if (!strcmp(s.name, ".strtab"))
-					strtab = static_cast<const char *>(image) + s.file_offset;
-				else if (!strcmp(s.name, ".dynstr"))
-					dynstr = static_cast<const char *>(image) + s.file_offset;
-				break;
-
-			case SHT_SYMTAB:
-				symtab = s;
-				break;
-
-			case SHT_DYNSYM:
-				dynsym = s;
-				break;
+				name.push_back(c_hex[*i >> 4]), name.push_back(c_hex[*i & 0x0F]);
+				if (i == build_id.begin())
+					name.push_back('/');
 			}
-		});
+			candidates.push_back(name + ".debug");
+		}
+		if (const auto debuglink = image.get_debuglink())
+		{
+			const auto directory = directory_of(path);
 
-		switch (get_bitness(image))
+			candidates.push_back(directory + "/" + debuglink);
+			candidates.push_back(directory + "/.debug/" + debuglink);
+			if ('/' == directory[0])
+				candidates.push_back(c_debug_root + directory + "/" + debuglink);
+		}
+		for (auto i = candidates.begin(); i != candidates.end(); ++i)
 		{
-		case _32bit:
-			if (strtab)
-				read_symbols<Elf32_Sym>(image, code_section_index, symtab, strtab, callback);
-			if (dynstr)
-				read_symbols<Elf32_Sym>(image, code_section_index, dynsym, dynstr, callback);
-			break;
-
-		case _64bit:
-			if (strtab)
-				read_symbols<Elf64_Sym>(image, code_section_index, symtab, strtab, callback);
-			if (dynstr)
-				read_symbols<Elf64_Sym>(image, code_section_index, dynsym, dynstr, callback);
-			break;
-
-		default:
-			throw runtime_error("Only 32-bit & 64-bit platforms are supported!");
+			if (*i == path)
+				continue;
+
+			unique_ptr<elf_image> debug_image(new elf_image(i->c_str()));
+
+			if (debug_image->valid() && (build_id.empty() || debug_image->get_build_id() == build_id))
+				return debug_image;
 		}
+		return unique_ptr<elf_image>();
 	}
 }
@@ -1,7 +1,14 @@
 #pragma once
 
+#include "filemapping.h"
+
 #include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace symreader
 {
@@ -12,6 +19,8 @@ namespace symreader
 		std::ptrdiff_t virtual_address;
 		const char *name;
 		unsigned int type;
+		unsigned int link;
+		std::size_t flags;
 		std::size_t size;
 		std::size_t entry_size;
 		std::size_t address_align;
@@ -24,6 +33,47 @@ namespace symreader
 		std::size_t size;
 	};
 
-	void read_sections(const void *image, std::size_t size, const std::function<void (const section &)> &callback);
-	void read_symbols(const void *image, std::size_t size, const std::function<void (const symbol &)> &callback);
+	// An ELF file read by sections: only the headers are read on construction, and only the sections asked for are
+	// mapped. Mapped sections stay mapped for the lifetime of the image.
+	class elf_image
+	{
+	public:
+		explicit elf_image(const char *path);
+
+		bool valid() const;
+		bool is_64bit() const;
+		const std::vector<section> &sections() const;
+		const section *find_section(const char *name) const;
+		const std::uint8_t *map_section(const section &s) const;
+
+		// Streams function symbols from .symtab and .dynsym in file order. Symbol tables are read through a fixed-size
+		// buffer, only the string tables are mapped.
+		void read_symbols(const std::function<void (const symbol &)> &callback) const;
+
+		std::vector<std::uint8_t> get_build_id() const;
+		const char *get_debuglink() const;
+
+	private:
+		elf_image(const elf_image &other);
+		void operator =(const elf_image &rhs);
+
+		template <typename ElfHeaderT, typename SectionHeaderT>
+		bool read_headers();
+
+		template <typename SymbolEntryT>
+		void read_symbols(const section &symbols, const section &names, int code_section_index,
+			const std::function<void (const symbol &)> &callback) const;
+
+	private:
+		file _file;
+		bool _64bit;
+		std::vector<section> _sections;
+		std::vector<char> _section_names;
+		mutable std::unordered_map< int, std::shared_ptr<const mapped_region> > _mappings;
+	};
+
+	// Opens the separate debug information file for the image at 'path', if any. It is looked for by the build ID (under
+	// /usr/lib/debug/.build-id) and then by .gnu_debuglink (next to the image, in its .debug subdirectory and under
+	// /usr/lib/debug). A build ID of the image, if present, must match the one of the debug file.
+	std::unique_ptr<elf_image> open_debug_image(const elf_image &image, const std::string &path);
 }
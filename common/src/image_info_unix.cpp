@@ -20,11 +20,19 @@
 
 #include <common/image_info.h>
 
-#include "elf/filemapping.h"
+#include "elf/dwarf-line.h"
 #include "elf/sym-elf.h"
 
+#include <algorithm>
+#include <common/noncopyable.h>
 #include <cxxabi.h>
+#include <elf.h>
+#include <mt/event.h>
+#include <mt/mutex.h>
+#include <mt/thread.h>
 #include <stdexcept>
+#include <string.h>
+#include <unistd.h>
 
 using namespace std;
 using namespace std::placeholders;
@@ -33,50 +41,300 @@ namespace micro_profiler
 {
 	namespace
 	{
+		const size_t c_demangling_chunk = 4096; // Symbols per demangling job.
+
+		struct demangled_chunk
+		{
+			vector<char> names;
+			vector< pair<size_t /*function*/, size_t /*name offset*/> > entries;
+		};
+
+		// Threads shared by all the images demangling their names. They are started once, so that loading many small
+		// images does not pay for a thread start each.
+		class demangling_pool : noncopyable
+		{
+		public:
+			demangling_pool();
+			~demangling_pool();
+
+			// Runs job(0), ..., job(n - 1) on the pool and the calling thread and returns once all of them are done.
+			// Concurrent calls are served one after another.
+			void run(size_t n, const function<void (size_t index)> &job);
+
+			static demangling_pool &instance();
+
+		private:
+			void worker();
+			const function<void (size_t index)> *take(size_t &index);
+			void complete();
+
+		private:
+			mt::mutex _run_mutex, _mutex;
+			mt::event _ready, _done;
+			const function<void (size_t index)> *_job;
+			size_t _next, _count, _remaining;
+			bool _exit;
+			vector< unique_ptr<mt::thread> > _threads;
+		};
+
 		class elf_image_info : public image_info
 		{
 		public:
-			elf_image_info(const string &path);
+			elf_image_info(const string &path, bool demangle_names);
 
 		private:
 			virtual void enumerate_functions(const symbol_callback_t &callback) const override;
+			virtual void enumerate_files(const file_callback_t &callback) const override;
+
+			void load() const;
 
 		private:
-			shared_ptr<const symreader::mapped_region> _image;
+			const string _path;
+			const unique_ptr<symreader::elf_image> _image;
+			mutable unique_ptr<symreader::elf_image> _debug_image;
+			const bool _demangle_names;
+			mutable mt::mutex _mutex;
+			mutable bool _loaded;
+			mutable vector<symreader::symbol> _functions;
+			mutable vector<char> _names;
+			mutable symreader::line_table _lines;
 		};
 
 
 
-		elf_image_info::elf_image_info(const string &path)
-			: _image(symreader::map_file(path.c_str()))
+		void demangle_chunk(const symreader::symbol *functions, size_t count, size_t base, demangled_chunk &chunk)
 		{
-			if (!_image->first)
+			char *demangled = 0;
+			size_t length = 0;
+
+			for (size_t i = 0; i != count; ++i)
+			{
+				const char *name = functions[i].name;
+				int status = 0;
+
+				if ('_' != name[0] || 'Z' != name[1])
+					continue;
+				if (char *demangled2 = __cxxabiv1::__cxa_demangle(name, demangled, &length, &status))
+				{
+					demangled = demangled2;
+					chunk.entries.push_back(make_pair(base + i, chunk.names.size()));
+					chunk.names.insert(chunk.names.end(), demangled2, demangled2 + strlen(demangled2) + 1);
+				}
+			}
+			free(demangled);
+		}
+
+		// Demangles the names in chunks on all available cores and packs the results into a single arena the functions'
+		// names are pointed to.
+		void demangle(vector<symreader::symbol> &functions, vector<char> &names)
+		{
+			const auto chunks = (functions.size() + c_demangling_chunk - 1) / c_demangling_chunk;
+			vector<demangled_chunk> results(chunks);
+			size_t total = 0;
+
+			demangling_pool::instance().run(chunks, [&] (size_t c) {
+				const auto base = c * c_demangling_chunk;
+
+				demangle_chunk(functions.data() + base, min(c_demangling_chunk, functions.size() - base), base,
+					results[c]);
+			});
+			for (auto i = results.begin(); i != results.end(); ++i)
+				total += i->names.size();
+			names.clear();
+			names.reserve(total);
+			for (auto i = results.begin(); i != results.end(); ++i)
+			{
+				const auto base = names.size();
+
+				names.insert(names.end(), i->names.begin(), i->names.end());
+				for (auto j = i->entries.begin(); j != i->entries.end(); ++j)
+					functions[j->first].name = names.data() + base + j->second;
+			}
+		}
+
+
+		demangling_pool::demangling_pool()
+			: _job(nullptr), _next(0), _count(0), _remaining(0), _exit(false)
+		{
+			const auto cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+			for (auto n = cores > 1 ? cores - 1 : 0; n--; )
+				_threads.push_back(unique_ptr<mt::thread>(new mt::thread([this] {	worker();	})));
+		}
+
+		demangling_pool::~demangling_pool()
+		{
+			{
+				mt::lock_guard<mt::mutex> l(_mutex);
+
+				_exit = true;
+			}
+			_ready.set();
+			for (auto i = _threads.begin(); i != _threads.end(); ++i)
+				(*i)->join();
+		}
+
+		void demangling_pool::run(size_t n, const function<void (size_t index)> &job)
+		{
+			if (n < 2 || _threads.empty())
+			{
+				for (size_t i = 0; i != n; ++i)
+					job(i);
+				return;
+			}
+
+			mt::lock_guard<mt::mutex> lr(_run_mutex);
+			size_t index;
+
+			{
+				mt::lock_guard<mt::mutex> l(_mutex);
+
+				_job = &job, _next = 0, _count = _remaining = n;
+			}
+			_ready.set();
+			while (take(index))
+				job(index), complete();
+			_done.wait();
+		}
+
+		demangling_pool &demangling_pool::instance()
+		{
+			static demangling_pool pool;
+			return pool;
+		}
+
+		void demangling_pool::worker()
+		{
+			for (size_t index; ; )
+			{
+				_ready.wait();
+				{
+					mt::lock_guard<mt::mutex> l(_mutex);
+
+					if (_exit)
+					{
+						_ready.set(); // Wakes the next thread to exit.
+						return;
+					}
+				}
+				while (const auto job = take(index))
+					(*job)(index), complete();
+			}
+		}
+
+		const function<void (size_t index)> *demangling_pool::take(size_t &index)
+		{
+			mt::lock_guard<mt::mutex> l(_mutex);
+
+			if (_next == _count)
+				return nullptr;
+			index = _next++;
+			if (_next != _count)
+				_ready.set(); // Wakes one more thread while there is work left.
+			return _job;
+		}
+
+		void demangling_pool::complete()
+		{
+			mt::lock_guard<mt::mutex> l(_mutex);
+
+			if (!--_remaining)
+				_done.set();
+		}
+
+
+		elf_image_info::elf_image_info(const string &path, bool demangle_names)
+			: _path(path), _image(new symreader::elf_image(path.c_str())), _demangle_names(demangle_names), _loaded(false)
+		{
+			if (!_image->valid())
 				throw invalid_argument("");
 		}
 
 		void elf_image_info::enumerate_functions(const symbol_callback_t &callback) const
 		{
-			char *demangled = 0;
-			size_t length = 0;
 			symbol_info symbol = { };
 
-			symreader::read_symbols(_image->first, _image->second, [&] (const symreader::symbol &elf_symbol) {
-				int status = 0;
-				char *demangled2 = __cxxabiv1::__cxa_demangle(elf_symbol.name, demangled, &length, &status);
-
-				if (demangled2 && !status)
-					demangled = demangled2;
+			load();
+			for (auto i = _functions.begin(); i != _functions.end(); ++i)
+			{
+				const auto j = lower_bound(_lines.addresses.begin(), _lines.addresses.end(), i->virtual_address);
+				const auto &position = _lines.positions[j - _lines.addresses.begin()];
 
-				symbol.name = demangled2 ? demangled2 : elf_symbol.name;
-				symbol.rva = static_cast<unsigned int>(elf_symbol.virtual_address);
-				symbol.size = static_cast<unsigned>(elf_symbol.size);
+				symbol.name = i->name;
+				symbol.rva = static_cast<unsigned int>(i->virtual_address);
+				symbol.size = static_cast<unsigned>(i->size);
+				symbol.file_id = position.file_id;
+				symbol.line = position.line;
 				callback(symbol);
+			}
+		}
+
+		void elf_image_info::enumerate_files(const file_callback_t &callback) const
+		{
+			pair<id_t, string> file;
+
+			load();
+			for (auto i = _lines.files.begin(); i != _lines.files.end(); ++i)
+			{
+				file.first = static_cast<id_t>(i - _lines.files.begin() + 1);
+				file.second = *i;
+				callback(file);
+			}
+		}
+
+		void elf_image_info::load() const
+		{
+			mt::lock_guard<mt::mutex> l(_mutex);
+
+			if (_loaded)
+				return;
+
+			const auto has_lines = _image->find_section(".debug_line") || _image->find_section(".zdebug_line");
+
+			if (!_image->find_section(".symtab") || !has_lines)
+				_debug_image = symreader::open_debug_image(*_image, _path);
+
+			const auto &symbols_image = _debug_image && !_image->find_section(".symtab") ? *_debug_image : *_image;
+			const auto &lines_image = _debug_image && !has_lines ? *_debug_image : *_image;
+
+			symbols_image.read_symbols([this] (const symreader::symbol &elf_symbol) {
+				_functions.push_back(elf_symbol);
+				_lines.addresses.push_back(elf_symbol.virtual_address);
 			});
-			free(demangled);
+			sort(_lines.addresses.begin(), _lines.addresses.end());
+			_lines.addresses.erase(unique(_lines.addresses.begin(), _lines.addresses.end()), _lines.addresses.end());
+			symreader::read_line_positions(lines_image, _lines);
+			if (_demangle_names)
+				demangle(_functions, _names);
+			_loaded = true;
 		}
 	}
 
 
-	shared_ptr< image_info > load_image_info(const string &image_path)
-	{	return shared_ptr< image_info >(new elf_image_info(image_path));	}
+	shared_ptr< image_info > load_image_info(const string &image_path, bool demangle_names)
+	{	return shared_ptr< image_info >(new elf_image_info(image_path, demangle_names));	}
+
+	void read_patchable_entries(vector<unsigned int> &rvas, const string &image_path, const byte *base)
+	{
+		const symreader::elf_image image(image_path.c_str());
+		const auto &sections = image.sections();
+
+		rvas.clear();
+		if (image.is_64bit() != (sizeof(void *) == 8))
+			return;
+		for (auto i = sections.begin(); i != sections.end(); ++i)
+		{
+			if (!(SHF_ALLOC & i->flags) || strcmp(i->name, "__patchable_function_entries"))
+				continue;
+
+			const auto entries = reinterpret_cast<const byte * const *>(base + i->virtual_address);
+
+			for (auto j = entries, end = entries + i->size / sizeof(void *); j != end; ++j)
+			{
+				if (*j >= base) // Entries of the functions discarded by the linker are left zero.
+					rvas.push_back(static_cast<unsigned int>(*j - base));
+			}
+		}
+		sort(rvas.begin(), rvas.end());
+	}
 }
@@ -254,10 +254,13 @@ namespace micro_profiler
 	}
 
 
-	shared_ptr<image_info> load_image_info(const string &image_path)
+	shared_ptr<image_info> load_image_info(const string &image_path, bool /*demangle_names*/)
 	{
 		shared_ptr<dbghelp> dh(new dbghelp);
 
 		return shared_ptr<image_info>(new dbghelp_image_info(dh, image_path));
 	}
+
+	void read_patchable_entries(vector<unsigned int> &rvas, const string &/*image_path*/, const byte * /*base*/)
+	{	rvas.clear();	}
 }
@@ -54,6 +54,9 @@ namespace micro_profiler
 		return 0;
 	}
 
+	size_t executable_memory_allocator::block::available() const
+	{	return _region.length() - _occupied;	}
+
 
 	executable_memory_allocator::executable_memory_allocator()
 		: _block(new block(block_size))
@@ -73,4 +76,16 @@ namespace micro_profiler
 
 		return shared_ptr<void>(ptr, [b] (...) { });
 	}
+
+	void executable_memory_allocator::reserve(size_t size)
+	{
+		if (size <= block_size && size > _block->available())
+			_block.reset(new block(block_size));
+	}
+
+	executable_memory_allocator::statistics executable_memory_allocator::get_statistics() const
+	{
+		statistics s = {	1, block_size, block_size - _block->available()	};
+		return s;
+	}
 }
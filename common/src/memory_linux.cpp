@@ -22,11 +22,58 @@
 
 #include <inttypes.h>
 #include <stdio.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 using namespace std;
 
 namespace micro_profiler
 {
+	namespace
+	{
+		enum membarrier_commands {
+			membarrier_query = 0,
+			membarrier_global = 1 << 0,
+			membarrier_private_expedited = 1 << 3,
+			membarrier_register_private_expedited = 1 << 4,
+			membarrier_private_expedited_sync_core = 1 << 5,
+			membarrier_register_private_expedited_sync_core = 1 << 6,
+		};
+
+		int membarrier(int command)
+		{
+#ifdef __NR_membarrier
+			return static_cast<int>(::syscall(__NR_membarrier, command, 0));
+#else
+			return (void)command, -1;
+#endif
+		}
+
+		// Picks the cheapest supported command that interrupts every running thread of the process. Any of them does
+		// on x86, as returning from an interrupt serializes; the sync-core one guarantees it elsewhere too.
+		int select_membarrier_command()
+		{
+			const auto supported = membarrier(membarrier_query);
+
+			if (supported < 0)
+				return -1;
+			if ((supported & membarrier_private_expedited_sync_core)
+					&& !membarrier(membarrier_register_private_expedited_sync_core))
+				return membarrier_private_expedited_sync_core;
+			if ((supported & membarrier_private_expedited) && !membarrier(membarrier_register_private_expedited))
+				return membarrier_private_expedited;
+			return supported & membarrier_global ? membarrier_global : -1;
+		}
+	}
+
+	void serialize_code_modifications()
+	{
+		static const auto command = select_membarrier_command();
+
+		if (command >= 0)
+			membarrier(command);
+	}
+
 	function<bool (pair<void *, size_t> &allocation)> virtual_memory::enumerate_allocations()
 	{
 		class enumerator
@@ -27,6 +27,12 @@ using namespace std;
 
 namespace micro_profiler
 {
+	void serialize_code_modifications()
+	{
+		// No process-wide serialization is available: x86 instruction fetch is coherent with stores, and the single-store
+		// modifications are seen as a whole.
+	}
+
 	function<bool (pair<void *, size_t> &allocation)> virtual_memory::enumerate_allocations()
 	{
 		struct enumerator
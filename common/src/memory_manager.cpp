@@ -35,14 +35,42 @@ namespace micro_profiler
 
 		virtual shared_ptr<void> allocate(size_t size) override
 		{
-			if (!_block)
-				_block = make_shared<block>(_reference, _distance_order, _block_size);
+			// Released allocations are never handed out again: a thread may still be executing a trampoline, or have
+			// its return address in one, long after the patch has gone, and there is no point at which the allocator
+			// could tell it is not. The tails left in the previous blocks (e.g. by a reservation) are used up before a
+			// new block is created.
+			void *ptr = nullptr;
+
+			release_empty_blocks();
+			if (!_blocks.empty() && !!(ptr = _blocks.back()->allocate(size)))
+				return make_allocation(_blocks.back(), ptr, size);
+			for (auto i = _blocks.begin(); i != _blocks.end(); ++i)
+			{
+				if (!!(ptr = (*i)->allocate(size)))
+					return make_allocation(*i, ptr, size);
+			}
+			create_block(size);
+			ptr = _blocks.back()->allocate(size);
+			return make_allocation(_blocks.back(), ptr, size);
+		}
+
+		virtual void reserve(size_t size) override
+		{
+			if (!_blocks.empty() && size <= _blocks.back()->available())
+				return;
+
+			// Reservations larger than a block get a single region of the whole size (rounded up to the block size), so
+			// that a large batch is placed in one arena with one reachable-gap search instead of one per block.
+			create_block(size);
+		}
 
-			void *ptr = _block->allocate(size);
+		virtual statistics get_statistics() const override
+		{
+			statistics s = {	_blocks.size(), 0, 0	};
 
-			if (!ptr)
-				_block = make_shared<block>(_reference, _distance_order, _block_size), ptr = _block->allocate(size);
-			return shared_ptr<void>(_block, ptr);
+			for (auto i = _blocks.begin(); i != _blocks.end(); ++i)
+				s.reserved += (*i)->size(), s.allocated += (*i)->allocated();
+			return s;
 		}
 
 	private:
@@ -50,7 +78,7 @@ namespace micro_profiler
 		{
 		public:
 			block(const_byte_range r, ptrdiff_t d, size_t block_size)
-				: _size(block_size), _occupied(0)
+				: _size(block_size), _occupied(0), _allocated(0)
 			{
 				auto e = virtual_memory::enumerate_allocations();
 				vector< pair<byte *, size_t> > allocations;
@@ -81,19 +109,55 @@ namespace micro_profiler
 				void *ptr = _region + _occupied;
 
 				_occupied += size;
+				_allocated += size;
 				return ptr;
 			}
 
+			void release(size_t size)
+			{	_allocated -= size;	}
+
+			size_t available() const
+			{	return _size - _occupied;	}
+
+			size_t size() const
+			{	return _size;	}
+
+			size_t allocated() const
+			{	return _allocated;	}
+
 		private:
 			byte *_region;
-			size_t _size, _occupied;
+			size_t _size, _occupied, _allocated;
 		};
 
+	private:
+		static shared_ptr<void> make_allocation(const shared_ptr<block> &b, void *ptr, size_t size)
+		{	return shared_ptr<void>(ptr, [b, size] (void *) {	b->release(size);	});	}
+
+		void create_block(size_t size)
+		{
+			const auto block_size = size > _block_size ? (size + _block_size - 1) / _block_size * _block_size : _block_size;
+
+			_blocks.push_back(make_shared<block>(_reference, _distance_order, block_size));
+		}
+
+		// Blocks left without live allocations are returned to the system, except for the current one.
+		void release_empty_blocks()
+		{
+			for (auto i = _blocks.begin(); _blocks.size() > 1 && i != _blocks.end() - 1; )
+			{
+				if (!(*i)->allocated())
+					i = _blocks.erase(i);
+				else
+					++i;
+			}
+		}
+
 	private:
 		const const_byte_range _reference;
 		const ptrdiff_t _distance_order;
 		const size_t _block_size;
-		shared_ptr<block> _block;
+		vector< shared_ptr<block> > _blocks;
 	};
 
 
@@ -60,6 +60,9 @@ namespace micro_profiler
 	}
 
 
+	void serialize_code_modifications()
+	{	::FlushProcessWriteBuffers();	}
+
 	size_t virtual_memory::granularity()
 	{
 		SYSTEM_INFO si = {};
@@ -22,11 +22,15 @@
 
 #include <common/file_id.h>
 #include <common/smart_ptr.h>
+#include <cstddef>
 #include <dlfcn.h>
 #include <link.h>
+#include <list>
 #include <mt/event.h>
+#include <mt/mutex.h>
 #include <mt/thread.h>
 #include <stdexcept>
+#include <string.h>
 #include <unistd.h>
 #include <unordered_map>
 
@@ -38,6 +42,11 @@ namespace micro_profiler
 	{
 		const mt::milliseconds c_mapping_monitor_interval(100);
 
+		struct load_counters
+		{
+			unsigned long long adds, subs;
+		};
+
 		int generic_protection(uint64_t segment_access)
 		{
 			int value = 0;
@@ -60,6 +69,55 @@ namespace micro_profiler
 			::dl_iterate_phdr(&local::on_module, &callback);
 		}
 
+		// Reads loader's load/unload counters off the first dl_phdr_info entry. Returns false if the loader does not
+		// maintain them (older dl_phdr_info layout).
+		bool get_load_counters(load_counters &counters)
+		{
+#if defined(__ANDROID__)
+			// Older bionic headers do not declare the counters - stick to the periodic rescan.
+			return counters.adds = counters.subs = 0, false;
+#else
+			struct local
+			{
+				static int on_module(dl_phdr_info *header, size_t size, void *counters_)
+				{
+					const auto counters = static_cast<load_counters *>(counters_);
+
+					if (size < offsetof(dl_phdr_info, dlpi_subs) + sizeof(header->dlpi_subs))
+						return -1;
+					counters->adds = header->dlpi_adds;
+					counters->subs = header->dlpi_subs;
+					return 1;
+				}
+			};
+
+			return ::dl_iterate_phdr(&local::on_module, &counters) > 0;
+#endif
+		}
+
+		void read_build_id(vector<byte> &build_id, const byte *notes, size_t size, size_t alignment)
+		{
+			const auto align = [alignment] (size_t value) {	return (value + alignment - 1) & ~(alignment - 1);	};
+
+			while (size >= sizeof(ElfW(Nhdr)))
+			{
+				const auto &note = *reinterpret_cast<const ElfW(Nhdr) *>(notes);
+				const auto name = notes + sizeof(ElfW(Nhdr));
+				const auto description = name + align(note.n_namesz);
+				const auto next = description + align(note.n_descsz);
+
+				if (next > notes + size)
+					break;
+				if (note.n_type == NT_GNU_BUILD_ID && note.n_namesz == 4 && !memcmp(name, "GNU", 4))
+				{
+					build_id.assign(description, description + note.n_descsz);
+					return;
+				}
+				size -= next - notes;
+				notes = next;
+			}
+		}
+
 		template <typename ExeNameT>
 		void update_mapping(module::mapping &mapping, const dl_phdr_info &header, const ExeNameT &get_executable_name)
 		{
@@ -68,11 +126,22 @@ namespace micro_profiler
 			mapping.path = header.dlpi_name && *header.dlpi_name ? header.dlpi_name : get_executable_name();
 			mapping.base = reinterpret_cast<byte *>(header.dlpi_addr);
 			mapping.regions.clear();
+			mapping.build_id.clear();
 			for (const ElfW(Phdr) *segment = header.dlpi_phdr; n; --n, ++segment)
+			{
 				if (segment->p_type == PT_LOAD)
+				{
 					mapping.regions.push_back(mapped_region {
 						mapping.base + segment->p_vaddr, segment->p_memsz, generic_protection(segment->p_flags)
 					});
+				}
+				else if (segment->p_type == PT_NOTE && mapping.build_id.empty())
+				{
+					// Notes are mapped and the loader lock is held while in dl_iterate_phdr() - no file I/O needed.
+					read_build_id(mapping.build_id, mapping.base + segment->p_vaddr, segment->p_memsz,
+						segment->p_align == 8 ? 8 : 4);
+				}
+			}
 		}
 	}
 
@@ -87,24 +156,41 @@ namespace micro_profiler
 		virtual mapping locate(const void *address) override;
 		virtual shared_ptr<mapping> lock_at(void *address) override;
 		virtual shared_ptr<void> notify(events &consumer) override;
+		virtual void refresh_mappings() override;
+
+	private:
+		mt::mutex _mutex;
+		list<tracker *> _trackers;
 	};
 
 	class module_platform::tracker
 	{
 	public:
-		tracker(module &owner, events &consumer);
+		tracker(module_platform &owner, events &consumer);
 		~tracker();
 
+		void check();
+
+	private:
+		typedef unordered_map< file_id, pair<module::mapping, bool /*deleted*/> > mappings_t;
+
 	private:
+		void monitor();
+		void rescan();
 		int on_module(const dl_phdr_info &header);
 		void on_module(const module::mapping &m);
 
 	private:
+		module_platform &_owner;
+		mt::mutex _mutex;
 		mt::event _exit;
 		string _executable;
 		events &_consumer;
-		unordered_map< file_id, pair<module::mapping, bool /*deleted*/> > _mappings;
+		mappings_t _mappings;
+		unordered_map<const byte *, mappings_t::value_type *> _bases;
 		module::mapping _tmp_mapping;
+		load_counters _counters;
+		bool _counters_supported;
 		unique_ptr<mt::thread> _monitor;
 	};
 
@@ -171,34 +257,93 @@ namespace micro_profiler
 	shared_ptr<void> module_platform::notify(events &consumer)
 	{	return make_shared<tracker>(*this, consumer);	}
 
+	void module_platform::refresh_mappings()
+	{
+		mt::lock_guard<mt::mutex> l(_mutex);
+
+		for (auto i = _trackers.begin(); i != _trackers.end(); ++i)
+			(*i)->check();
+	}
+
 
-	module_platform::tracker::tracker(module &owner, events &consumer)
-		: _executable(owner.executable()), _consumer(consumer)
+	module_platform::tracker::tracker(module_platform &owner, events &consumer)
+		: _owner(owner), _executable(owner.executable()), _consumer(consumer)
 	{
+		_counters_supported = get_load_counters(_counters);
 		enumerate_headers([this] (const dl_phdr_info &header) {	on_module(header);	});
-		_monitor.reset(new mt::thread([this] {
-			while (!_exit.wait(c_mapping_monitor_interval))
-			{
-				for (auto &i : _mappings)
-					i.second.second = true;
-				enumerate_headers([this] (const dl_phdr_info &header) {	on_module(header);	});
-				for (auto i = _mappings.begin(); i != _mappings.end(); )
-					if (i->second.second)
-						_consumer.unmapped(i->second.first.base), i = _mappings.erase(i);
-					else
-						i++;
-			}
-		}));
+		_monitor.reset(new mt::thread([this] {	monitor();	}));
+
+		mt::lock_guard<mt::mutex> l(_owner._mutex);
+
+		_owner._trackers.push_back(this);
 	}
 
 	module_platform::tracker::~tracker()
 	{
+		{
+			mt::lock_guard<mt::mutex> l(_owner._mutex);
+
+			_owner._trackers.remove(this);
+		}
 		_exit.set();
 		_monitor->join();
 	}
 
+	void module_platform::tracker::check()
+	{
+		mt::lock_guard<mt::mutex> l(_mutex);
+
+		// With loader counters available a check costs a single dl_iterate_phdr() callback and no syscalls. The full
+		// rescan is only made when something got loaded or unloaded.
+		if (_counters_supported)
+		{
+			load_counters counters;
+
+			get_load_counters(counters);
+			if (counters.adds == _counters.adds && counters.subs == _counters.subs)
+				return;
+			_counters = counters;
+		}
+		rescan();
+	}
+
+	void module_platform::tracker::monitor()
+	{
+		while (!_exit.wait(c_mapping_monitor_interval))
+			check();
+	}
+
+	void module_platform::tracker::rescan()
+	{
+		for (auto &i : _mappings)
+			i.second.second = true;
+		enumerate_headers([this] (const dl_phdr_info &header) {	on_module(header);	});
+		for (auto i = _mappings.begin(); i != _mappings.end(); )
+		{
+			if (i->second.second)
+			{
+				_consumer.unmapped(i->second.first.base);
+				_bases.erase(i->second.first.base);
+				i = _mappings.erase(i);
+			}
+			else
+			{
+				i++;
+			}
+		}
+	}
+
 	int module_platform::tracker::on_module(const dl_phdr_info &header)
 	{
+		const auto known = _bases.find(reinterpret_cast<const byte *>(header.dlpi_addr));
+		const auto name = header.dlpi_name && *header.dlpi_name ? header.dlpi_name : _executable.c_str();
+
+		if (known != _bases.end() && known->second->second.first.path == name)
+		{
+			// Same image at the same base: no need to stat() or access() it again.
+			known->second->second.second = false;
+			return 0;
+		}
 		update_mapping(_tmp_mapping, header, [this] {	return _executable;	});
 		if (!access(_tmp_mapping.path.c_str(), 0))
 			on_module(_tmp_mapping);
@@ -213,13 +358,15 @@ namespace micro_profiler
 		if (i == _mappings.end())
 		{
 			_consumer.mapped(m);
-			_mappings.emplace(id, make_pair(m, false));
+			_bases[m.base] = &*_mappings.emplace(id, make_pair(m, false)).first;
 			return;
 		}
 		else if (m.base != i->second.first.base)
 		{
 			_consumer.unmapped(i->second.first.base);
+			_bases.erase(i->second.first.base);
 			_consumer.mapped(i->second.first = m);
+			_bases[m.base] = &*i;
 		}
 		i->second.second = false;
 	}
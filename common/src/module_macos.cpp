@@ -113,6 +113,7 @@ namespace micro_profiler
 		virtual mapping locate(const void *address) override;
 		virtual shared_ptr<mapping> lock_at(void *address) override;
 		virtual shared_ptr<void> notify(events &consumer) override;
+		virtual void refresh_mappings() override;
 
 	private:
 		mt::mutex _mutex;
@@ -226,6 +227,9 @@ namespace micro_profiler
 		return handle;
 	}
 
+	void module_platform::refresh_mappings()
+	{	}
+
 
 	module &module::platform()
 	{
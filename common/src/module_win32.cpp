@@ -151,6 +151,7 @@ namespace micro_profiler
 		virtual mapping locate(const void *address) override;
 		virtual shared_ptr<mapping> lock_at(void *address) override;
 		virtual shared_ptr<void> notify(events &consumer) override;
+		virtual void refresh_mappings() override;
 	};
 
 	class module_platform::tracker
@@ -201,6 +202,9 @@ namespace micro_profiler
 	shared_ptr<void> module_platform::notify(events &consumer)
 	{	return make_shared<tracker>(*this, consumer);	}
 
+	void module_platform::refresh_mappings()
+	{	}
+
 
 	module_platform::tracker::tracker(module &owner, events &consumer)
 		: _ntdll(owner.load("ntdll")), _unregister(_ntdll / "LdrUnregisterDllNotification"), _consumer(consumer)
@@ -107,6 +107,123 @@ namespace micro_profiler
 				// ACT / ASSERT
 				assert_throws(ea->allocate(granularity), bad_alloc);
 			}
+
+
+			test( ReservationExceedingCurrentBlockStartsContiguousArena )
+			{
+				// INIT
+				memory_manager mm(granularity);
+				auto base = continuous_free_region(10 * granularity);
+				auto ea = mm.create_executable_allocator(const_byte_range(base + 1 * granularity, granularity), 32);
+				auto ref1 = ea->allocate(16);
+
+				// ACT
+				ea->reserve(32);
+				auto ref2 = ea->allocate(32);
+
+				// ASSERT
+				assert_equal(base + 2 * granularity, ref1.get());
+				assert_equal(base + 2 * granularity + 16, ref2.get());
+
+				// ACT
+				ea->reserve(3 * granularity);
+				auto ref3 = ea->allocate(granularity / 2);
+				auto ref4 = ea->allocate(2 * granularity);
+				auto ref5 = ea->allocate(granularity / 2);
+
+				// ASSERT
+				assert_equal(base + 3 * granularity, ref3.get());
+				assert_equal(base + 3 * granularity + granularity / 2, ref4.get());
+				assert_equal(base + 5 * granularity + granularity / 2, ref5.get());
+			}
+
+
+			test( ReleasedAllocationsAreNeitherReusedNorWritten )
+			{
+				// INIT
+				memory_manager mm(granularity);
+				auto base = continuous_free_region(10 * granularity);
+				auto ea = mm.create_executable_allocator(const_byte_range(base + 1 * granularity, granularity), 32);
+				auto ref1 = ea->allocate(32);
+				auto ref2 = ea->allocate(40);
+				byte code[] = {	0x48, 0x89, 0x5C, 0x24, 0x08, 0x57, 0x48, 0x83, 0xEC, 0x20, 0xE8, 0x01, 0x02, 0x03, 0x04, 0xC3,	};
+
+				mem_copy(ref1.get(), code, sizeof(code));
+
+				// ACT
+				ref1.reset();
+				auto ref3 = ea->allocate(32);
+				auto ref4 = ea->allocate(16);
+
+				// ASSERT
+				assert_equal(base + 2 * granularity + 72, ref3.get());
+				assert_equal(base + 2 * granularity + 104, ref4.get());
+				assert_equal(mkvector(code), vector<byte>(base + 2 * granularity, base + 2 * granularity + sizeof(code)));
+			}
+
+
+			test( TailsOfPreviousBlocksAreUsedBeforeGrowing )
+			{
+				// INIT
+				memory_manager mm(granularity);
+				auto base = continuous_free_region(10 * granularity);
+				auto ea = mm.create_executable_allocator(const_byte_range(base + 1 * granularity, granularity), 32);
+				auto ref1 = ea->allocate(granularity / 2);
+
+				ea->reserve(granularity);
+
+				auto ref2 = ea->allocate(granularity);
+
+				// ACT
+				auto ref3 = ea->allocate(granularity / 4);
+
+				// ASSERT
+				assert_equal(base + 3 * granularity, ref2.get());
+				assert_equal(base + 2 * granularity + granularity / 2, ref3.get());
+
+				// ACT
+				auto ref4 = ea->allocate(granularity / 2);
+
+				// ASSERT
+				assert_equal(base + 4 * granularity, ref4.get());
+			}
+
+
+			test( StatisticsReflectLiveAllocations )
+			{
+				// INIT
+				memory_manager mm(granularity);
+				auto base = continuous_free_region(10 * granularity);
+				auto ea = mm.create_executable_allocator(const_byte_range(base + 1 * granularity, granularity), 32);
+				auto ref1 = ea->allocate(granularity / 2);
+				auto ref2 = ea->allocate(30);
+				auto ref3 = ea->allocate(granularity);
+
+				// ACT
+				auto s = ea->get_statistics();
+
+				// ASSERT
+				assert_equal(2u, s.blocks);
+				assert_equal(2 * granularity, s.reserved);
+				assert_equal(granularity + granularity / 2 + 30, s.allocated);
+
+				// ACT
+				ref2.reset();
+				s = ea->get_statistics();
+
+				// ASSERT
+				assert_equal(granularity + granularity / 2, s.allocated);
+
+				// ACT
+				ref1.reset();
+				auto ref4 = ea->allocate(16);
+				s = ea->get_statistics();
+
+				// ASSERT (the emptied first block is returned to the system)
+				assert_equal(2u, s.blocks);
+				assert_equal(2 * granularity, s.reserved);
+				assert_equal(granularity + 16, s.allocated);
+			}
 		end_test_suite
 	}
 }
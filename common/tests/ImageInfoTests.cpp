@@ -231,6 +231,73 @@ namespace micro_profiler
 				assert_equal(files["symbol_container_2.cpp"], functions["guinea_snprintf"].file_id);
 				assert_equal(files["symbol_container_2_internal.cpp"], functions["bubble_sort"].file_id);
 			}
+#elif defined(__linux__)
+			test( FunctionsAreLinkedToSourceFilesAndLinesFromDebugLineTables )
+			{
+				// INIT
+				map<unsigned, string> files;
+				map<string, symbol_info> functions;
+				shared_ptr< image_info > ii = load_image_info(c_symbol_container_2);
+
+				// ACT
+				ii->enumerate_functions(bind(&add_function, ref(functions), _1));
+				ii->enumerate_files([&] (const pair<unsigned, string> &file) {
+					assert_is_true(files.insert(file).second);
+				});
+
+				// ASSERT
+				assert_equal("symbol_container_2.cpp", (string)*files[functions["get_function_addresses_2"].file_id]);
+				assert_equal(20u, functions["get_function_addresses_2"].line);
+				assert_equal("symbol_container_2.cpp", (string)*files[functions["guinea_snprintf"].file_id]);
+				assert_equal(53u, functions["guinea_snprintf"].line);
+				assert_equal("symbol_container_2_internal.cpp", (string)*files[functions["bubble_sort"].file_id]);
+				assert_equal(2u, functions["bubble_sort"].line);
+				assert_not_equal(functions["guinea_snprintf"].file_id, functions["bubble_sort"].file_id);
+			}
+
+
+			test( SymbolsAndLinesOfStrippedImagesAreReadFromSeparateDebugFile )
+			{
+				// INIT
+				map<unsigned, string> files;
+				map<string, symbol_info> functions;
+				shared_ptr< image_info > ii = load_image_info(c_symbol_container_2_stripped);
+
+				// ACT
+				ii->enumerate_functions(bind(&add_function, ref(functions), _1));
+				ii->enumerate_files([&] (const pair<unsigned, string> &file) {
+					files.insert(file);
+				});
+
+				// ASSERT (non-exported functions are only listed in .symtab of the debug file)
+				assert_is_true(has_function_containing(functions, "vale_of_mean_creatures::this_one_for_the_birds"));
+				assert_equal("symbol_container_2.cpp", (string)*files[functions["guinea_snprintf"].file_id]);
+				assert_equal(53u, functions["guinea_snprintf"].line);
+				assert_equal("symbol_container_2_internal.cpp", (string)*files[functions["bubble_sort"].file_id]);
+				assert_equal(2u, functions["bubble_sort"].line);
+			}
+
+
+			test( PatchableEntriesAreReadOffMappedImage )
+			{
+				// INIT
+				image img(c_symbol_container_2);
+				vector<unsigned int> rvas(3, 0u);
+
+				// ACT
+				read_patchable_entries(rvas, img.absolute_path(), img.base_ptr());
+
+				// ASSERT (guinea pigs are built with -fpatchable-function-entry=14,12)
+				assert_is_true(is_sorted(rvas.begin(), rvas.end()));
+				assert_is_true(binary_search(rvas.begin(), rvas.end(), img.get_symbol_rva("get_function_addresses_2") - 12));
+				assert_is_true(binary_search(rvas.begin(), rvas.end(), img.get_symbol_rva("guinea_snprintf") - 12));
+
+				// ACT
+				read_patchable_entries(rvas, "missingABCDEFG", img.base_ptr());
+
+				// ASSERT
+				assert_is_empty(rvas);
+			}
 #endif
 
 			test( CPPNamesAreDemangledOnEnumeration )
@@ -260,6 +327,23 @@ namespace micro_profiler
 				assert_is_true(has_function_containing(functions, "vale_of_mean_creatures::this_one_for_the_whales"));
 				assert_is_true(has_function_containing(functions, "vale_of_mean_creatures::the_abyss::bubble_sort"));
 			}
+
+#ifndef _WIN32
+			test( CPPNamesAreLeftIntactWhenDemanglingIsNotRequested )
+			{
+				// INIT
+				map<string, symbol_info> functions;
+				shared_ptr< image_info > ii = load_image_info(c_symbol_container_2, false);
+
+				// ACT
+				ii->enumerate_functions(bind(&add_function, ref(functions), _1));
+
+				// ASSERT
+				assert_is_false(has_function_containing(functions, "vale_of_mean_creatures::this_one_for_the_birds"));
+				assert_is_true(has_function_containing(functions, "_ZN22vale_of_mean_creatures22this_one_for_the_birdsEv"));
+				assert_equal(1u, functions.count("guinea_snprintf"));
+			}
+#endif
 		end_test_suite
 	}
 }
@@ -181,6 +181,29 @@ namespace micro_profiler
 			}
 
 
+#if defined(__linux__)
+			test( BuildIDIsReportedForImagesLinkedWithIt )
+			{
+				// INIT
+				image img1(module1_path);
+				image img2(module2_path);
+				vector<module::mapping> mappings;
+				const module::mapping *match1, *match2;
+				mocks::module_events e([&] (module::mapping m) {	mappings.push_back(m);	});
+
+				// ACT
+				auto s = module_helper->notify(e);
+
+				// ASSERT
+				assert_not_null(match1 = find_module(mappings, img1.base_ptr()));
+				assert_not_null(match2 = find_module(mappings, img2.base_ptr()));
+				assert_is_false(match1->build_id.empty());
+				assert_is_false(match2->build_id.empty());
+				assert_not_equal(match1->build_id, match2->build_id);
+			}
+
+
+#endif
 			test( LoadedModulesAreNotifiedUponLoad )
 			{
 				// INIT
@@ -47,6 +47,7 @@ namespace micro_profiler
 		std::string executable;
 		timestamp_t ticks_per_second;
 		unsigned int injected;
+		unsigned int protocol; // The latest of protocol_versions the collector supports.
 	};
 
 	struct thread_info
@@ -0,0 +1,268 @@
+#include <frontend/frontend.h>
+
+#include <collector/calls_collector.h>
+#include <collector/collector_app.h>
+#include <collector/module_tracker.h>
+#include <collector/thread_monitor.h>
+#include <common/benchmark/allocation_counter.h>
+#include <common/module.h>
+#include <common/smart_ptr.h>
+#include <common/time.h>
+#include <cstdio>
+#include <cstdlib>
+#include <frontend/profiling_cache.h>
+#include <mt/event.h>
+#include <mt/mutex.h>
+#include <mt/thread_callbacks.h>
+#include <patcher/interface.h>
+#include <vector>
+
+using namespace coipc;
+using namespace std;
+
+namespace micro_profiler
+{
+	void run_symbol_lookup();
+
+	namespace
+	{
+		const unsigned c_repetitions = 20;
+
+		struct graph_shape
+		{
+			unsigned threads, width, depth;
+		};
+
+		struct stage
+		{
+			stage()
+				: seconds(0), allocations(0), bytes(0)
+			{	}
+
+			double seconds;
+			size_t allocations, bytes;
+		};
+
+		void make_trace(vector<call_record> &trace, timestamp_t &t, unsigned width, unsigned depth, unsigned level = 0)
+		{
+			for (unsigned i = 0; i != width; ++i)
+			{
+				const call_record enter = {	t++, reinterpret_cast<const void *>(0x10000 + 16 * size_t(level * width + i))	};
+
+				trace.push_back(enter);
+				if (level + 1 < depth)
+					make_trace(trace, t, width, depth, level + 1);
+
+				const call_record exit = {	t++, nullptr	};
+
+				trace.push_back(exit);
+			}
+		}
+
+		// Feeds the same synthetic trace for each thread once armed - one batch per analysis cycle.
+		class synthetic_collector : public calls_collector_i
+		{
+		public:
+			synthetic_collector(const graph_shape &shape)
+				: _threads(shape.threads), _armed(false)
+			{
+				timestamp_t t = 0;
+
+				make_trace(_trace, t, shape.width, shape.depth);
+			}
+
+			void arm()
+			{
+				mt::lock_guard<mt::mutex> l(_mutex);
+
+				_armed = true;
+			}
+
+			size_t trace_size() const
+			{	return _trace.size();	}
+
+			virtual void read_collected(acceptor &a) override
+			{
+				mt::lock_guard<mt::mutex> l(_mutex);
+
+				if (!_armed)
+					return;
+
+				stopwatch sw;
+				const auto allocations0 = allocations_made();
+
+				for (unsigned tid = 1; tid <= _threads; ++tid)
+					a.accept_calls(tid, _trace.data(), _trace.size());
+				analysis.seconds += sw();
+				analysis.allocations += allocations_made() - allocations0;
+				analysis.bytes += _threads * _trace.size() * sizeof(call_record);
+				_armed = false;
+				analyzed.set();
+			}
+
+			virtual void flush() override
+			{	}
+
+		public:
+			stage analysis;
+			mt::event analyzed;
+
+		private:
+			const unsigned _threads;
+			vector<call_record> _trace;
+			mt::mutex _mutex;
+			bool _armed;
+		};
+
+		struct null_patch_manager : patch_manager
+		{
+			virtual void query(patch_states &/*states*/, id_t /*module_id*/) override
+			{	}
+
+			virtual void apply(patch_change_results &/*results*/, id_t /*module_id*/, apply_request_range /*targets*/) override
+			{	}
+
+			virtual void revert(patch_change_results &/*results*/, id_t /*module_id*/, revert_request_range /*targets*/) override
+			{	}
+		};
+
+		struct null_cache : profiling_cache
+		{
+			virtual shared_ptr<module_info_metadata> load_metadata(unsigned int /*hash*/) override
+			{	return nullptr;	}
+
+			virtual void store_metadata(const module_info_metadata &/*metadata*/) override
+			{	}
+
+			virtual vector<tables::cached_patch> load_default_patches(id_t /*cached_module_id*/) override
+			{	return vector<tables::cached_patch>();	}
+
+			virtual void update_default_patches(id_t /*cached_module_id*/, vector<unsigned int> /*add_rva*/,
+				vector<unsigned int> /*remove_rva*/) override
+			{	}
+		};
+
+		// Sits between the collector and the frontend: everything spent downstream is deserialization and merging.
+		class metering_channel : public channel, noncopyable
+		{
+		public:
+			void set_underlying(shared_ptr<channel> underlying)
+			{	_underlying = underlying;	}
+
+			virtual void disconnect() throw() override
+			{	_underlying->disconnect();	}
+
+			virtual void message(const_byte_range payload) override
+			{
+				stopwatch sw;
+				const auto allocations0 = allocations_made();
+
+				_underlying->message(payload);
+				frontend.seconds += sw();
+				frontend.allocations += allocations_made() - allocations0;
+				frontend.bytes += payload.length();
+			}
+
+		public:
+			stage frontend;
+
+		private:
+			shared_ptr<channel> _underlying;
+		};
+
+		void print(const char *name, const stage &s)
+		{
+			printf("\t%-28s %9.3fms/update %10.1f allocations/update %12u bytes/update\n", name,
+				1000.0 * s.seconds / c_repetitions, static_cast<double>(s.allocations) / c_repetitions,
+				static_cast<unsigned>(s.bytes / c_repetitions));
+		}
+
+		void run(const graph_shape &shape)
+		{
+			synthetic_collector collector(shape);
+			const auto threads = make_shared<thread_monitor>(mt::get_thread_callbacks());
+			module_tracker modules(module::platform());
+			null_patch_manager patches;
+			collector_app app(collector, overhead(0, 0), *threads, modules, patches);
+			const auto meter = make_shared<metering_channel>();
+			shared_ptr<profiling_session> session;
+			shared_ptr<void> invalidation;
+			mt::event initialized, updated, ready;
+			stage roundtrip, end_to_end;
+			const auto sync = [&] {
+				app.get_queue().schedule([&] {	ready.set();	});
+				ready.wait();
+			};
+
+			app.connect([&] (channel &outbound) -> channel_ptr_t {
+				const auto f = make_shared<frontend>(outbound, make_shared<null_cache>(), app.get_queue(),
+					app.get_queue());
+
+				f->initialized = [&] (shared_ptr<profiling_session> session_) {
+					session = session_;
+					invalidation = session->statistics.invalidate += [&] {	updated.set();	};
+					initialized.set();
+				};
+				meter->set_underlying(f);
+				return make_shared_aspect(make_shared_copy(make_pair(f, meter)), meter.get());
+			}, false);
+			initialized.wait();
+			updated.wait(); // The initial full update, carrying all the loaded modules.
+			sync();
+			meter->frontend = stage();
+
+			for (auto n = c_repetitions; n--; )
+			{
+				collector.arm();
+				collector.analyzed.wait();
+
+				stopwatch sw;
+				const auto allocations0 = allocations_made();
+
+				app.get_queue().schedule([&] {	session->statistics.request_update();	});
+				updated.wait();
+				roundtrip.seconds += sw();
+				roundtrip.allocations += allocations_made() - allocations0;
+				sync(); // Let the rest of the update (unloaded modules) be delivered.
+			}
+
+			stage collector_stage;
+
+			collector_stage.seconds = roundtrip.seconds - meter->frontend.seconds;
+			collector_stage.allocations = roundtrip.allocations - meter->frontend.allocations;
+			collector_stage.bytes = meter->frontend.bytes;
+			end_to_end.seconds = collector.analysis.seconds + roundtrip.seconds;
+			end_to_end.allocations = collector.analysis.allocations + roundtrip.allocations;
+			end_to_end.bytes = meter->frontend.bytes;
+
+			printf("Synthetic call graph: %u threads x %u callees x %u levels (%u records/thread), %u nodes in frontend\n",
+				shape.threads, shape.width, shape.depth, static_cast<unsigned>(collector.trace_size()),
+				static_cast<unsigned>(session->statistics.size()));
+			print("analysis (analyzer)", collector.analysis);
+			print("collector (handlers+IPC)", collector_stage);
+			print("frontend (deserialize+merge)", meter->frontend);
+			print("end-to-end", end_to_end);
+
+			// The frontend's data must be released in its own thread.
+			app.get_queue().schedule([&] {	invalidation.reset(), session.reset(), ready.set();	});
+			ready.wait();
+		}
+	}
+}
+
+int main(int argc, const char *argv[])
+{
+	using namespace micro_profiler;
+
+	graph_shape shape = {	4, 32, 3	};
+
+	if (argc > 1)
+		shape.threads = atoi(argv[1]);
+	if (argc > 2)
+		shape.width = atoi(argv[2]);
+	if (argc > 3)
+		shape.depth = atoi(argv[3]);
+	run(shape);
+	run_symbol_lookup();
+	return 0;
+}
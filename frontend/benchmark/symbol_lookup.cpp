@@ -0,0 +1,151 @@
+#include <frontend/symbol_resolver.h>
+
+#include <common/time.h>
+#include <cstdio>
+#include <frontend/helpers.h>
+#include <frontend/keyer.h>
+#include <map>
+#include <sdb/integrated_index.h>
+#include <vector>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace
+	{
+		const unsigned c_modules = 40;
+		const unsigned c_symbols_per_module = 20000;
+		const unsigned c_lookups = 1000000;
+
+		// The layout symbol_resolver used before: a node-based tree per module and the ordered index over mappings.
+		class map_resolver
+		{
+		public:
+			map_resolver(const tables::modules &modules, const tables::module_mappings &mappings)
+				: _mappings(mappings)
+			{
+				for (auto i = modules.begin(); i != modules.end(); ++i)
+				{
+					auto &symbols = _symbols[(*i).id];
+
+					for (auto j = (*i).symbols.begin(); j != (*i).symbols.end(); ++j)
+						symbols[j->rva] = &*j;
+				}
+			}
+
+			const string &symbol_name_by_va(long_address_t address) const
+			{
+				if (const auto mapping = find_range(sdb::ordered_index_(_mappings, keyer::base()), address))
+				{
+					const auto m = _symbols.find(mapping->module_id);
+
+					if (_symbols.end() != m)
+					{
+						const auto rva = static_cast<unsigned int>(address - mapping->base);
+
+						if (const auto candidate = find_range(m->second, rva))
+						{
+							if (rva - candidate->second->rva < candidate->second->size)
+								return candidate->second->name;
+						}
+					}
+				}
+				return _empty;
+			}
+
+		private:
+			const tables::module_mappings &_mappings;
+			containers::unordered_map< id_t, map<unsigned int, const symbol_info *> > _symbols;
+			string _empty;
+		};
+
+		unsigned random_next(unsigned &seed)
+		{	return seed = seed * 1103515245u + 12345u, seed >> 8;	}
+
+		template <typename F>
+		double measure(const F &f)
+		{
+			stopwatch sw;
+
+			sw();
+			f();
+			return sw();
+		}
+	}
+
+	void run_symbol_lookup()
+	{
+		const auto modules = make_shared<tables::modules>();
+		const auto mappings = make_shared<tables::module_mappings>();
+		vector<long_address_t> addresses;
+		unsigned seed = 1;
+
+		for (unsigned m = 1; m <= c_modules; ++m)
+		{
+			auto rec = modules->create();
+			auto mapping = mappings->create();
+			unsigned int rva = 0x1000;
+
+			(*rec).id = m;
+			for (unsigned n = 0; n != c_symbols_per_module; ++n)
+			{
+				symbol_info s = {	"f" + to_string(n), rva, 16 + random_next(seed) % 256	};
+
+				(*rec).symbols.push_back(s);
+				rva += s.size + random_next(seed) % 16;
+			}
+			rec.commit();
+			(*mapping).module_id = m;
+			(*mapping).base = 0x10000000ull * m;
+			mapping.commit();
+		}
+		vector<const tables::module *> ordered_modules;
+
+		for (auto i = modules->begin(); i != modules->end(); ++i)
+			ordered_modules.push_back(&*i);
+		for (unsigned n = 0; n != c_lookups; ++n)
+		{
+			const auto &module = *ordered_modules[random_next(seed) % c_modules];
+			const auto &s = module.symbols[random_next(seed) % module.symbols.size()];
+
+			addresses.push_back(0x10000000ull * module.id + s.rva + random_next(seed) % s.size);
+		}
+
+		modules->request_presence = [modules] (shared_ptr<void> &, id_t module_id,
+			const tables::modules::metadata_ready_cb &ready) {
+
+			for (auto i = modules->begin(); i != modules->end(); ++i)
+			{
+				if ((*i).id == module_id)
+					ready(*i);
+			}
+		};
+
+		map_resolver old_resolver(*modules, *mappings);
+		symbol_resolver resolver(modules, mappings);
+		size_t checksum[2] = {	0	};
+
+		resolver.symbol_name_by_va(addresses[0]);
+		for (unsigned m = 1; m <= c_modules; ++m)
+			resolver.symbol_name_by_va(0x10000000ull * m);
+
+		const double times[] = {
+			measure([&] {
+				for (auto i = addresses.begin(); i != addresses.end(); ++i)
+					checksum[0] += old_resolver.symbol_name_by_va(*i).size();
+			}),
+			measure([&] {
+				for (auto i = addresses.begin(); i != addresses.end(); ++i)
+					checksum[1] += resolver.symbol_name_by_va(*i).size();
+			}),
+		};
+
+		printf("Symbol lookup: %u modules x %u symbols, %u random addresses\n", c_modules, c_symbols_per_module,
+			c_lookups);
+		printf("\t%-28s %9.1fns/lookup\n", "std::map + ordered index", 1e9 * times[0] / c_lookups);
+		printf("\t%-28s %9.1fns/lookup\n", "flat Eytzinger", 1e9 * times[1] / c_lookups);
+		if (checksum[0] != checksum[1])
+			printf("\tMISMATCH: results differ between the layouts!\n");
+	}
+}
@@ -45,6 +45,7 @@ namespace micro_profiler
 		struct statistics : calls_statistics_table
 		{
 			std::function<void ()> request_update;
+			std::function<bool (bool enable)> push_updates; // Returns false if the remote cannot push updates.
 		};
 
 
@@ -89,7 +90,12 @@ namespace micro_profiler
 			typedef std::pair<unsigned int, unsigned int> patch_def;
 
 			std::function<void (id_t module_id, range<const patch_def, size_t> rva)> apply;
+			std::function<void (id_t module_id, range<const patch_def, size_t> rva)> apply_counters;
 			std::function<void (id_t module_id, range<const unsigned int, size_t> rva)> revert;
+			std::function<void (id_t module_id, range<const unsigned int, size_t> rva, bool paused)> pause;
+
+			// Has the functions of a module selected by the filter and patched on the profilee side.
+			std::function<void (const module_patch_request &filter)> apply_module;
 		};
 
 		struct cached_patch
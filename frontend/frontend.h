@@ -25,6 +25,7 @@
 
 #include <coipc/client_session.h>
 #include <common/noncopyable.h>
+#include <common/patch_results.h>
 #include <common/protocol.h>
 #include <functional>
 #include <list>
@@ -63,12 +64,17 @@ namespace micro_profiler
 		virtual void disconnect() throw() override;
 
 		void init_patcher();
-		void apply(id_t module_id, range<const tables::patches::patch_def, size_t> rva);
+		void apply(id_t module_id, range<const tables::patches::patch_def, size_t> rva, bool count_only);
 		void revert(id_t module_id, range<const unsigned int, size_t> rva);
+		void pause(id_t module_id, range<const unsigned int, size_t> rva, bool paused);
+		void apply_module(const module_patch_request &filter);
+		void update_counters(coipc::deserializer &d);
 
 		template <typename OnUpdate>
 		void request_full_update(std::shared_ptr<void> &request_, const OnUpdate &on_update);
 		void update_threads(std::vector<id_t> &thread_ids);
+		bool push_updates(bool enable);
+		void on_pushed(coipc::deserializer &d);
 		void finalize();
 
 		void request_metadata(std::shared_ptr<void> &request_, id_t module_id,
@@ -89,11 +95,11 @@ namespace micro_profiler
 		const std::shared_ptr<profiling_cache> _cache;
 		module_hashes_t _module_hashes;
 		scontext::additive _serialization_context;
-		bool _initialized;
+		bool _initialized, _threads_piggybacked;
 
 		mx_metadata_requests_t::map_type_ptr _mx_metadata_requests;
 		requests_t _requests;
-		std::shared_ptr<void> _update_request;
+		std::shared_ptr<void> _update_request, _push_request, _credit_request;
 
 		// request_apply_patches buffers
 		patch_apply_request _patch_apply_payload;
@@ -102,5 +108,16 @@ namespace micro_profiler
 		// request_revert_patches buffers
 		patch_revert_request _patch_revert_payload;
 		response_reverted_data _reverted_buffer;
+
+		// request_pause_patches buffers
+		patch_pause_request _patch_pause_payload;
+		response_paused_data _paused_buffer;
+
+		// request_apply_module_patches buffers
+		module_patch_result _module_patched_buffer;
+		decoded_patch_results _module_patched_decoded;
+
+		// response_patch_counters buffers
+		patch_counters _counters_buffer;
 	};
 }
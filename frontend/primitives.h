@@ -67,11 +67,14 @@ namespace micro_profiler
 	struct patch_state_ex : patch_state // Permitted states: dormant, active, unrecoverable_error.
 	{
 		patch_state_ex()
-			: in_transit(false), last_result(patch_change_result::ok)
+			: in_transit(false), paused(false), count_only(false), calls(0), last_result(patch_change_result::ok)
 		{	id = 0, state = dormant;	}
 
 		id_t module_id;
 		bool in_transit;
+		bool paused; // Measurement is suspended, while the patch itself stays installed.
+		bool count_only;
+		count_t calls; // Calls counted so far, for count-only patches.
 		patch_change_result::errors last_result;
 	};
 
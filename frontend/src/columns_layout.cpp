@@ -56,11 +56,18 @@ namespace micro_profiler
 	};
 
 	static int encode_state(const nullable<const patch_state_ex &> &p)
-	{	return p.has_value() ? (((*p).in_transit ? 1 : 0) << 8) | static_cast<int>((*p).state) : -1;	}
+	{
+		return p.has_value()
+			? (((*p).count_only ? 1 : 0) << 10) | (((*p).paused ? 1 : 0) << 9) | (((*p).in_transit ? 1 : 0) << 8) | static_cast<int>((*p).state) : -1;
+	}
 
 	static void format_patch_status(agge::richtext_t &text, const nullable<const patch_state_ex &> &p)
 	{
 		p.and_then([&] (const patch_state_ex &patch) {
+			if (patch.paused && !patch.in_transit && patch_state::active == patch.state)
+				return text << "paused", true;
+			if (patch.count_only && !patch.in_transit && patch_state::active == patch.state)
+				return text << "counted: ", itoa<10>(text, patch.calls), true;
 			return text << (patch.in_transit ? c_requested_patch_states : c_complete_patch_states)[patch.state], true;
 		});
 	}
@@ -68,7 +75,7 @@ namespace micro_profiler
 	namespace
 	{
 		auto by_name = [] (const statistics_model_context &context, const call_statistics &lhs, const call_statistics &rhs) {
-			return strcmp(context.resolver->symbol_name_by_va(lhs.address).c_str(), context.resolver->symbol_name_by_va(rhs.address).c_str());
+			return micro_profiler::compare(context.resolver->name_rank_by_va(lhs.address), context.resolver->name_rank_by_va(rhs.address));
 		};
 
 		auto by_threadid = [] (const statistics_model_context &context, const call_statistics &lhs_, const call_statistics &rhs_) -> int {
@@ -39,18 +39,22 @@ namespace micro_profiler
 			LOG(PREAMBLE "attempt to interact with a detached profilee - ignoring...");
 		});
 		const auto detached_frontend_stub2 = bind([] {});
+		const update_subscription c_push_subscription = {	25 /*ms*/, 32 * 1024 * 1024 /*bytes/s*/, 2	};
 	}
 
 	frontend::frontend(channel &outbound, shared_ptr<profiling_cache> cache,
 			tasker::queue &worker, tasker::queue &apartment)
 		: client_session(outbound), _worker_queue(worker), _apartment_queue(apartment),
 			_db(make_shared<profiling_session>()), _cache(cache), _initialized(false),
+			_threads_piggybacked(false),
 			_mx_metadata_requests(make_shared<mx_metadata_requests_t::map_type>())
 	{
 		_db->statistics.request_update = [this] {
 			request_full_update(_update_request, [] (shared_ptr<void> &r) {	r.reset();	});
 		};
 
+		_db->statistics.push_updates = [this] (bool enable) {	return push_updates(enable);	};
+
 		_db->modules.request_presence = [this] (shared_ptr<void> &request, id_t module_id,
 			const tables::modules::metadata_ready_cb &ready) {
 
@@ -81,6 +85,8 @@ namespace micro_profiler
 
 		subscribe(*new_request_handle(), exiting, [this] (deserializer &) {	finalize();	});
 
+		subscribe(*new_request_handle(), statistics_pushed, [this] (deserializer &d) {	on_pushed(d);	});
+
 		_requests.push_back(_db->mappings.created += [this] (tables::module_mappings::const_iterator i) {
 			_module_hashes[i->module_id] = i->hash;
 		});
@@ -93,9 +99,13 @@ namespace micro_profiler
 	frontend::~frontend()
 	{
 		_db->statistics.request_update = detached_frontend_stub2;
+		_db->statistics.push_updates = [] (bool) {	return false;	};
 		_db->modules.request_presence = detached_frontend_stub;
 		_db->patches.apply = detached_frontend_stub;
+		_db->patches.apply_counters = detached_frontend_stub;
 		_db->patches.revert = detached_frontend_stub;
+		_db->patches.pause = detached_frontend_stub;
+		_db->patches.apply_module = detached_frontend_stub;
 
 		LOG(PREAMBLE "destroyed...") % A(this);
 	}
@@ -117,14 +127,23 @@ namespace micro_profiler
 
 			d(_db->mappings, as_map);
 		};
+		auto threads_callback = [this] (deserializer &d) {
+			sdb::scontext::indexed_by<keyer::external_id, void> as_map;
+
+			d(_db->threads, as_map);
+			_threads_piggybacked = true;
+		};
 		auto update_callback = [this, &request_, on_update] (deserializer &d) {
 			d(_db->statistics, _serialization_context);
 			update_threads(_serialization_context.threads);
 			on_update(request_);
 		};
+		auto counters_callback = [this] (deserializer &d) {	update_counters(d);	};
 		pair<int, callback_t> callbacks[] = {
 			make_pair(response_modules_loaded, modules_callback),
+			make_pair(response_threads_info, threads_callback),
 			make_pair(response_statistics_update, update_callback),
+			make_pair(response_patch_counters, counters_callback),
 		};
 
 		request(request_, request_update, 0, callbacks);
@@ -132,9 +151,27 @@ namespace micro_profiler
 
 	void frontend::update_threads(vector<id_t> &thread_ids)
 	{
-		auto req = new_request_handle();
 		auto &idx = sdb::unique_index(_db->threads, keyer::external_id());
 
+		if (_threads_piggybacked)
+		{
+			// Thread infos arrive along with statistics - only the records for the unknown threads are created.
+			for (auto i = thread_ids.begin(); i != thread_ids.end(); i++)
+			{
+				if (idx.find(*i))
+					continue;
+
+				auto rec = idx[*i];
+
+				(*rec).complete = false;
+				rec.commit();
+			}
+			thread_ids.clear();
+			return;
+		}
+
+		auto req = new_request_handle();
+
 		for (auto i = thread_ids.begin(); i != thread_ids.end(); i++)
 		{
 			auto rec = idx[*i];
@@ -157,6 +194,34 @@ namespace micro_profiler
 		});
 	}
 
+	bool frontend::push_updates(bool enable)
+	{
+		if (_db->process_info.protocol < protocol_push_updates)
+			return false;
+		if (enable)
+			request(_push_request, request_subscribe_updates, c_push_subscription, no_response, [] (deserializer &) {	});
+		else
+			request(_push_request, request_unsubscribe_updates, 0, no_response, [] (deserializer &) {	});
+		return true;
+	}
+
+	void frontend::on_pushed(deserializer &d)
+	{
+		sdb::scontext::indexed_by<keyer::external_id, void> as_map;
+		const update_credit credit = {	1	};
+		unloaded_modules unmapped;
+
+		d(_db->mappings, as_map);
+		d(_db->threads, as_map);
+		_threads_piggybacked = true;
+		d(_db->statistics, _serialization_context);
+		update_threads(_serialization_context.threads);
+		d(unmapped);
+		if (_db->process_info.protocol >= protocol_patch_counters)
+			update_counters(d);
+		request(_credit_request, request_update_credit, credit, no_response, [] (deserializer &) {	});
+	}
+
 	void frontend::finalize()
 	{
 		LOG(PREAMBLE "finalizing...") % A(this);
@@ -29,6 +29,10 @@
 #include <sdb/integrated_index.h>
 #include <tasker/task.h>
 
+#if defined(__GNUC__)
+	#include <cxxabi.h>
+#endif
+
 #define PREAMBLE "Frontend (metadata): "
 
 using namespace std;
@@ -36,6 +40,45 @@ using namespace tasker;
 
 namespace micro_profiler
 {
+	namespace
+	{
+		// Collectors may be configured to ship the names as they are in the image, leaving demangling to us.
+		bool has_mangled_names(const module_info_metadata &metadata)
+		{
+#if defined(__GNUC__)
+			for (auto i = metadata.symbols.begin(); i != metadata.symbols.end(); ++i)
+			{
+				if (!i->name.compare(0, 2, "_Z"))
+					return true;
+			}
+#else
+			(void)metadata;
+#endif
+			return false;
+		}
+
+		void demangle_names(module_info_metadata &metadata)
+		{
+#if defined(__GNUC__)
+			char *demangled = 0;
+			size_t length = 0;
+
+			for (auto i = metadata.symbols.begin(); i != metadata.symbols.end(); ++i)
+			{
+				int status = 0;
+
+				if (i->name.compare(0, 2, "_Z"))
+					continue;
+				if (char *demangled2 = abi::__cxa_demangle(i->name.c_str(), demangled, &length, &status))
+					i->name = demangled = demangled2;
+			}
+			free(demangled);
+#else
+			(void)metadata;
+#endif
+		}
+	}
+
 	void frontend::request_metadata(shared_ptr<void> &request_, id_t module_id,
 		const tables::modules::metadata_ready_cb &ready)
 	{
@@ -103,15 +146,33 @@ namespace micro_profiler
 	template <typename F>
 	void frontend::request_metadata_nw(shared_ptr<void> &request_, id_t module_id, const F &ready)
 	{
+		const auto req = make_shared< shared_ptr<void> >();
+		const weak_ptr< shared_ptr<void> > wreq = req;
+
 		LOG(PREAMBLE "requesting from remote...") % A(this) % A(module_id);
-		request(request_, request_module_metadata, module_id, response_module_metadata,
-			[this, module_id, ready] (coipc::deserializer &d) {
+		request(*req, request_module_metadata, module_id, response_module_metadata,
+			[this, module_id, ready, wreq] (coipc::deserializer &d) {
 
 			auto m = make_shared<module_info_metadata>();
 
 			d(*m);
 			LOG(PREAMBLE "received...") % A(module_id) % A(m->symbols.size()) % A(m->source_files.size());
-			ready(m);
+			if (!has_mangled_names(*m))
+			{
+				ready(m);
+				return;
+			}
+
+			// Demangling a large image takes seconds, so it is done off the UI thread.
+			schedule_task([m] () -> module_ptr {
+				demangle_names(*m);
+				return m;
+			}, _worker_queue)
+				.then([ready, wreq] (const async_result<module_ptr> &m) {
+					if (!wreq.expired())
+						ready(*m);
+				}, _apartment_queue);
 		});
+		request_ = req;
 	}
 }
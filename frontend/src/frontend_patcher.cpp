@@ -35,7 +35,7 @@ namespace micro_profiler
 				? p.in_transit = true, true : false;
 		}
 
-		void set_applied(patch_state_ex &p, const patch_change_result &applied)
+		void set_applied(patch_state_ex &p, const patch_change_result &applied, bool count_only)
 		{
 			p.id = applied.id;
 			p.in_transit = false;
@@ -47,6 +47,7 @@ namespace micro_profiler
 
 			case patch_change_result::ok:
 				p.state = patch_state::active;
+				p.count_only = count_only;
 
 			default:
 				p.last_result = applied.result;
@@ -54,6 +55,13 @@ namespace micro_profiler
 			}
 		}
 
+		void set_applied(patch_state_ex &p, bool active, bool count_only)
+		{
+			if (active)
+				p.state = patch_state::active, p.count_only = count_only;
+			p.last_result = active ? patch_change_result::ok : patch_change_result::activation_error;
+		}
+
 		void set_reverted(patch_state_ex &p, const patch_change_result &reverted)
 		{
 			p.in_transit = false;
@@ -61,25 +69,43 @@ namespace micro_profiler
 				p.state = patch_state::dormant;
 			p.last_result = reverted.result;
 		}
+
+		void set_paused(patch_state_ex &p, const patch_change_result &paused, bool requested)
+		{
+			p.in_transit = false;
+			if (patch_change_result::ok == paused.result)
+				p.paused = requested;
+			p.last_result = paused.result;
+		}
 	}
 
 	void frontend::init_patcher()
 	{
 		_db->patches.apply = [this] (id_t module_id, range<const tables::patches::patch_def, size_t> rva) {
-			apply(module_id, rva);
+			apply(module_id, rva, false);
+		};
+		_db->patches.apply_counters = [this] (id_t module_id, range<const tables::patches::patch_def, size_t> rva) {
+			apply(module_id, rva, true);
 		};
 		_db->patches.revert = [this] (id_t module_id, range<const unsigned int, size_t> rva) {
 			revert(module_id, rva);
 		};
+		_db->patches.pause = [this] (id_t module_id, range<const unsigned int, size_t> rva, bool paused) {
+			pause(module_id, rva, paused);
+		};
+		_db->patches.apply_module = [this] (const module_patch_request &filter) {
+			apply_module(filter);
+		};
 	}
 
-	void frontend::apply(id_t module_id, range<const tables::patches::patch_def, size_t> rva)
+	void frontend::apply(id_t module_id, range<const tables::patches::patch_def, size_t> rva, bool count_only)
 	{
 		auto req = new_request_handle();
 		auto &idx = sdb::unique_index<keyer::symbol_id>(_db->patches);
 		auto &targets = _patch_apply_payload.functions;
 
 		_patch_apply_payload.module_id = module_id;
+		_patch_apply_payload.count_only = count_only;
 		targets.clear();
 		targets.reserve(rva.length());
 		for_each(rva.begin(), rva.end(), [&] (const tables::patches::patch_def &rva) {
@@ -93,14 +119,14 @@ namespace micro_profiler
 			return;
 		_db->patches.invalidate();
 		request(*req, request_apply_patches, _patch_apply_payload, response_patched,
-			[this, module_id, req, &idx] (coipc::deserializer &d) {
+			[this, module_id, count_only, req, &idx] (coipc::deserializer &d) {
 
 			d(_patched_buffer);
 			for (auto i = _patched_buffer.begin(); i != _patched_buffer.end(); ++i)
 			{
 				auto rec = idx[symbol_key(module_id, i->rva)];
 
-				set_applied(*rec, *i);
+				set_applied(*rec, *i, count_only);
 				rec.commit();
 			}
 			_db->patches.invalidate();
@@ -147,4 +173,92 @@ namespace micro_profiler
 			_requests.erase(req);
 		});
 	}
+
+	void frontend::pause(id_t module_id, range<const unsigned int, size_t> rva, bool paused)
+	{
+		auto req = new_request_handle();
+		auto &idx = sdb::unique_index<keyer::symbol_id>(_db->patches);
+		auto &targets = _patch_pause_payload.functions_rva;
+
+		_patch_pause_payload.module_id = module_id;
+		_patch_pause_payload.paused = paused;
+		targets.clear();
+		targets.reserve(rva.length());
+		for_each(rva.begin(), rva.end(), [&] (unsigned int rva) {
+			auto symbol_id = symbol_key(module_id, rva);
+
+			if (idx.find(symbol_id))
+			{
+				auto rec = idx[symbol_id];
+
+				if ((*rec).paused != paused && set_requested(*rec, true))
+					targets.push_back(rva);
+				rec.commit();
+			}
+		});
+		if (targets.empty())
+			return;
+		_db->patches.invalidate();
+		request(*req, request_pause_patches, _patch_pause_payload, response_paused,
+			[this, module_id, paused, req, &idx] (coipc::deserializer &d) {
+
+			d(_paused_buffer);
+			for (auto i = _paused_buffer.begin(); i != _paused_buffer.end(); ++i)
+			{
+				auto rec = idx[symbol_key(module_id, i->rva)];
+
+				set_paused(*rec, *i, paused);
+				rec.commit();
+			}
+			_db->patches.invalidate();
+			_requests.erase(req);
+		});
+	}
+
+	void frontend::apply_module(const module_patch_request &filter)
+	{
+		auto req = new_request_handle();
+		auto &idx = sdb::unique_index<keyer::symbol_id>(_db->patches);
+		const auto module_id = filter.module_id;
+		const auto count_only = filter.count_only;
+
+		request(*req, request_apply_module_patches, filter, response_module_patched,
+			[this, module_id, count_only, req, &idx] (coipc::deserializer &d) {
+
+			d(_module_patched_buffer);
+			decode_patch_results(_module_patched_decoded, _module_patched_buffer);
+			for (auto i = _module_patched_decoded.begin(); i != _module_patched_decoded.end(); ++i)
+			{
+				auto rec = idx[symbol_key(module_id, i->first)];
+
+				set_applied(*rec, i->second, count_only);
+				rec.commit();
+			}
+			_db->patches.invalidate();
+			_requests.erase(req);
+		});
+	}
+
+	void frontend::update_counters(coipc::deserializer &d)
+	{
+		auto &idx = sdb::unique_index<keyer::symbol_id>(_db->patches);
+		auto changed = false;
+
+		d(_counters_buffer);
+		for (auto i = _counters_buffer.begin(); i != _counters_buffer.end(); ++i)
+		{
+			const auto symbol_id = symbol_key(i->module_id, i->rva);
+
+			if (idx.find(symbol_id))
+			{
+				auto rec = idx[symbol_id];
+
+				if ((*rec).calls != i->calls)
+					(*rec).calls = i->calls, changed = true;
+				rec.commit();
+			}
+		}
+		if (changed)
+			_db->patches.invalidate();
+	}
 }
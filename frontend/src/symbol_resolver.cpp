@@ -20,18 +20,95 @@
 
 #include <frontend/symbol_resolver.h>
 
-#include <frontend/keyer.h>
-#include <frontend/helpers.h>
-#include <sdb/integrated_index.h>
+#include <algorithm>
 
 using namespace std;
 
 namespace micro_profiler
 {
+	namespace
+	{
+		typedef const symbol_info *symbol_ptr;
+
+		size_t eytzinger_fill(symbol_resolver::module_symbols &layout, const vector<symbol_ptr> &sorted, size_t i,
+			size_t k)
+		{
+			if (k < layout.rvas.size())
+			{
+				i = eytzinger_fill(layout, sorted, i, 2 * k);
+				layout.rvas[k] = sorted[i]->rva, layout.symbols[k] = sorted[i];
+				i = eytzinger_fill(layout, sorted, i + 1, 2 * k + 1);
+			}
+			return i;
+		}
+
+		size_t find_symbol(const symbol_resolver::module_symbols &symbols, unsigned int rva)
+		{
+			if (const auto slot = symbols.find_range(rva))
+			{
+				if (rva - symbols.rvas[slot] < symbols.symbols[slot]->size)
+					return slot;
+			}
+			return 0;
+		}
+	}
+
+	void symbol_resolver::module_symbols::assign(const vector<symbol_info> &symbols_)
+	{
+		vector<symbol_ptr> sorted;
+
+		sorted.reserve(symbols_.size());
+		for (auto i = symbols_.begin(); i != symbols_.end(); ++i)
+			sorted.push_back(&*i);
+		stable_sort(sorted.begin(), sorted.end(), [] (symbol_ptr lhs, symbol_ptr rhs) {
+			return lhs->rva < rhs->rva;
+		});
+
+		// The last of the symbols sharing an RVA wins.
+		auto w = sorted.begin();
+
+		for (auto r = sorted.begin(); r != sorted.end(); ++r)
+		{
+			if (w != sorted.begin() && (*(w - 1))->rva == (*r)->rva)
+				*(w - 1) = *r;
+			else
+				*w++ = *r;
+		}
+		sorted.erase(w, sorted.end());
+
+		rvas.assign(sorted.size() + 1, 0u);
+		symbols.assign(sorted.size() + 1, nullptr);
+		ranks.assign(sorted.size() + 1, 0u);
+		eytzinger_fill(*this, sorted, 0, 1);
+	}
+
+	size_t symbol_resolver::module_symbols::find_range(unsigned int rva) const
+	{
+		const size_t n = rvas.size();
+		size_t k = 1;
+
+		// Each step appends a bit to 'k': one when going right (the node is not greater than 'rva').
+		while (k < n)
+			k = 2 * k + (rvas[k] <= rva);
+
+		// The greatest node not above 'rva' is the one we last went right from: drop the trailing left turns and it.
+		while (!(k & 1))
+			k >>= 1;
+		return k >> 1;
+	}
+
+
 	symbol_resolver::symbol_resolver(shared_ptr<const tables::modules> modules,
 			shared_ptr<const tables::module_mappings> mappings)
-		: _modules(modules), _mappings(mappings)
-	{	}
+		: _modules(modules), _mappings(mappings), _mappings_dirty(true)
+	{
+		const auto set_dirty = [this] (tables::module_mappings::const_iterator) {	_mappings_dirty = true;	};
+
+		_mappings_connections.push_back(_mappings->created += set_dirty);
+		_mappings_connections.push_back(_mappings->modified += set_dirty);
+		_mappings_connections.push_back(_mappings->removed += set_dirty);
+		_mappings_connections.push_back(_mappings->cleared += [this] {	_mappings_dirty = true;	});
+	}
 
 	const string &symbol_resolver::symbol_name_by_va(long_address_t address) const
 	{
@@ -61,45 +138,143 @@ namespace micro_profiler
 		return false;
 	}
 
-	const symbol_info *symbol_resolver::find_symbol_by_va(long_address_t address, id_t &module_id) const
+	unsigned int symbol_resolver::name_rank_by_va(long_address_t address) const
 	{
-		if (const auto mapping = find_range(sdb::ordered_index_(*_mappings, keyer::base()), address))
+		size_t slot;
+		const auto symbols = find_slot_by_va(address, slot);
+
+		// Goes after the lookup: requesting metadata may have delivered it synchronously.
+		while (!_unranked_modules.empty())
 		{
-			auto m = _symbols_ordered.find(module_id = mapping->module_id);
+			merge_name_ranks(_symbols_ordered[_unranked_modules.back()]);
+			_unranked_modules.pop_back();
+		}
+		return symbols ? symbols->ranks[slot] : 0u;
+	}
 
-			if (_symbols_ordered.end() == m)
+	const symbol_resolver::mapping_entry *symbol_resolver::find_mapping(long_address_t address) const
+	{
+		if (_mappings_dirty)
+		{
+			_mappings_ordered.clear();
+			for (auto i = _mappings->begin(); i != _mappings->end(); ++i)
 			{
-				const auto i = _requests.insert(make_pair(mapping->module_id, shared_ptr<void>()));
-
-				if (i.second)
-				{
-					_modules->request_presence(i.first->second, mapping->module_id,
-						[this, i] (const module_info_metadata &metadata) {
-
-						auto &cached_symbols = _symbols_ordered[i.first->first];
-
-						for (auto j = metadata.symbols.begin(); j != metadata.symbols.end(); ++j)
-							cached_symbols[j->rva] = &*j;
-						_file_lines[i.first->first] = &metadata.source_files;
-						invalidate();
-						_requests.erase(i.first);
-					});
-					m = _symbols_ordered.find(mapping->module_id);
-				}
+				const mapping_entry e = {	(*i).base, (*i).module_id	};
+
+				_mappings_ordered.push_back(e);
 			}
+			stable_sort(_mappings_ordered.begin(), _mappings_ordered.end(),
+				[] (const mapping_entry &lhs, const mapping_entry &rhs) {	return lhs.base < rhs.base;	});
+			_mappings_dirty = false;
+		}
+
+		const auto i = upper_bound(_mappings_ordered.begin(), _mappings_ordered.end(), address,
+			[] (long_address_t address_, const mapping_entry &e) {	return address_ < e.base;	});
 
-			if (_symbols_ordered.end() != m)
+		return i != _mappings_ordered.begin() ? &*(i - 1) : nullptr;
+	}
+
+	const symbol_resolver::module_symbols *symbol_resolver::get_module_symbols(id_t module_id) const
+	{
+		auto m = _symbols_ordered.find(module_id);
+
+		if (_symbols_ordered.end() == m)
+		{
+			const auto i = _requests.insert(make_pair(module_id, shared_ptr<void>()));
+
+			if (i.second)
 			{
-				auto &cached_symbols = m->second;
-				const auto rva = static_cast<unsigned int>(address - mapping->base);
-
-				if (const auto candidate = find_range(cached_symbols, rva))
-				{
-					if (rva - candidate->second->rva < candidate->second->size)
-						return candidate->second;
-				}
+				_modules->request_presence(i.first->second, module_id,
+					[this, i] (const module_info_metadata &metadata) {
+
+					_symbols_ordered[i.first->first].assign(metadata.symbols);
+					_file_lines[i.first->first] = &metadata.source_files;
+					_unranked_modules.push_back(i.first->first);
+					invalidate();
+					_requests.erase(i.first);
+				});
+				m = _symbols_ordered.find(module_id);
+			}
+		}
+		return _symbols_ordered.end() != m ? &m->second : nullptr;
+	}
+
+	const symbol_info *symbol_resolver::find_symbol_by_va(long_address_t address, id_t &module_id) const
+	{
+		if (const auto mapping = find_mapping(address))
+		{
+			if (const auto symbols = get_module_symbols(module_id = mapping->module_id))
+			{
+				if (const auto slot = find_symbol(*symbols, static_cast<unsigned int>(address - mapping->base)))
+					return symbols->symbols[slot];
+			}
+		}
+		return nullptr;
+	}
+
+	const symbol_resolver::module_symbols *symbol_resolver::find_slot_by_va(long_address_t address, size_t &slot) const
+	{
+		if (const auto mapping = find_mapping(address))
+		{
+			if (const auto symbols = get_module_symbols(mapping->module_id))
+			{
+				if ((slot = find_symbol(*symbols, static_cast<unsigned int>(address - mapping->base))) != 0)
+					return symbols;
 			}
 		}
 		return nullptr;
 	}
+
+	void symbol_resolver::merge_name_ranks(module_symbols &symbols) const
+	{
+		typedef const string *name_ptr;
+
+		const auto less = [] (name_ptr lhs, name_ptr rhs) {	return *lhs < *rhs;	};
+		vector<name_ptr> names, merged;
+		vector<unsigned int> moved_to(_ranked_names.size() + 1, 0u);
+
+		// Rank zero goes to unresolved addresses (and empty names, as they collate equal); equal names share a rank.
+		for (size_t k = 1; k < symbols.symbols.size(); ++k)
+		{
+			if (!symbols.symbols[k]->name.empty())
+				names.push_back(&symbols.symbols[k]->name);
+		}
+		sort(names.begin(), names.end(), less);
+		names.erase(unique(names.begin(), names.end(), [] (name_ptr lhs, name_ptr rhs) {	return *lhs == *rhs;	}),
+			names.end());
+
+		// Only the arriving names are sorted: they are merged into the ranked ones, which keep their relative order.
+		merged.reserve(_ranked_names.size() + names.size());
+		for (auto i = _ranked_names.begin(), j = names.begin(); i != _ranked_names.end() || j != names.end(); )
+		{
+			if (i != _ranked_names.end() && (j == names.end() || !less(*j, *i)))
+			{
+				if (j != names.end() && !less(*i, *j))
+					++j;
+				merged.push_back(*i);
+				moved_to[i++ - _ranked_names.begin() + 1] = static_cast<unsigned int>(merged.size());
+			}
+			else
+			{
+				merged.push_back(*j++);
+			}
+		}
+		_ranked_names.swap(merged);
+
+		if (moved_to.size() < _ranked_names.size() + 1)
+		{
+			for (auto i = _symbols_ordered.begin(); i != _symbols_ordered.end(); ++i)
+			{
+				for (auto r = i->second.ranks.begin(); r != i->second.ranks.end(); ++r)
+					*r = moved_to[*r];
+			}
+		}
+		for (size_t k = 1; k < symbols.symbols.size(); ++k)
+		{
+			const auto &name = symbols.symbols[k]->name;
+
+			symbols.ranks[k] = name.empty() ? 0u : static_cast<unsigned int>(lower_bound(_ranked_names.begin(),
+				_ranked_names.end(), &name, less) - _ranked_names.begin() + 1);
+		}
+	}
 }
@@ -23,6 +23,33 @@ namespace micro_profiler
 			bool operator ()(char lhs, char rhs) const
 			{	return toupper(lhs) == toupper(rhs);	}
 		};
+
+		void apply_selected(const tables::patches &patches, sdb::table<selected_symbol> &selection_, bool count_only)
+		{
+			unordered_map< unsigned int, vector<tables::patches::patch_def> > s;
+
+			for (auto i = selection_.begin(); i != selection_.end(); ++i)
+				s[get<0>(*i)].push_back(tables::patches::patch_def(get<1>(*i), get<2>(*i)));
+			for (auto i = s.begin(); i != s.end(); ++i)
+			{
+				if (count_only)
+					patches.apply_counters(i->first, make_range(i->second));
+				else
+					patches.apply(i->first, make_range(i->second));
+			}
+			selection_.clear();
+		}
+
+		void pause_selected(const tables::patches &patches, sdb::table<selected_symbol> &selection_, bool paused)
+		{
+			unordered_map< unsigned int, vector<unsigned int> > s;
+
+			for (auto i = selection_.begin(); i != selection_.end(); ++i)
+				s[get<0>(*i)].push_back(get<1>(*i));
+			for (auto i = s.begin(); i != s.end(); ++i)
+				patches.pause(i->first, make_range(i->second), paused);
+			selection_.clear();
+		}
 	}
 
 	image_patch_ui::image_patch_ui(const factory &factory_, shared_ptr<image_patch_model> model,
@@ -68,17 +95,17 @@ namespace micro_profiler
 			toolbar->add(make_shared<overlay>(), percents(100));
 			toolbar->add(btn = factory_.create_control<button>("button"), pixels(120), false, 100);
 				btn->set_text(agge::style_modifier::empty + "Patch Selected");
-				_connections.push_back(btn->clicked += [model, patches, selection_] {
-					unordered_map< unsigned int, vector<tables::patches::patch_def> > s;
-
-					for (auto i = selection_->begin(); i != selection_->end(); ++i)
-						s[get<0>(*i)].push_back(tables::patches::patch_def(get<1>(*i), get<2>(*i)));
-					for (auto i = s.begin(); i != s.end(); ++i)
-						patches->apply(i->first, make_range(i->second));
-					selection_->clear();
+				_connections.push_back(btn->clicked += [patches, selection_] {
+					apply_selected(*patches, *selection_, false);
 				});
 
 			toolbar->add(btn = factory_.create_control<button>("button"), pixels(120), false, 101);
+				btn->set_text(agge::style_modifier::empty + "Count Selected");
+				_connections.push_back(btn->clicked += [patches, selection_] {
+					apply_selected(*patches, *selection_, true);
+				});
+
+			toolbar->add(btn = factory_.create_control<button>("button"), pixels(120), false, 102);
 				btn->set_text(agge::style_modifier::empty + "Revert Selected");
 					_connections.push_back(btn->clicked += [model, patches, selection_] {
 						unordered_map< unsigned int, vector<unsigned int> > s;
@@ -90,7 +117,19 @@ namespace micro_profiler
 						selection_->clear();
 					});
 
-			toolbar->add(btn = factory_.create_control<button>("button"), pixels(80), false, 102);
+			toolbar->add(btn = factory_.create_control<button>("button"), pixels(120), false, 103);
+				btn->set_text(agge::style_modifier::empty + "Pause Selected");
+				_connections.push_back(btn->clicked += [patches, selection_] {
+					pause_selected(*patches, *selection_, true);
+				});
+
+			toolbar->add(btn = factory_.create_control<button>("button"), pixels(120), false, 104);
+				btn->set_text(agge::style_modifier::empty + "Resume Selected");
+				_connections.push_back(btn->clicked += [patches, selection_] {
+					pause_selected(*patches, *selection_, false);
+				});
+
+			toolbar->add(btn = factory_.create_control<button>("button"), pixels(80), false, 105);
 				btn->set_text(agge::style_modifier::empty + "Close");
 				_connections.push_back(btn->clicked += [model] {
 				});
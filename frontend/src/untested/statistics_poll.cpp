@@ -27,15 +27,22 @@ using namespace std;
 namespace micro_profiler
 {
 	statistics_poll::statistics_poll(shared_ptr<const tables::statistics> statistics, tasker::queue &apartment_queue)
-		: _statistics(statistics), _apartment_queue(apartment_queue)
+		: _statistics(statistics), _apartment_queue(apartment_queue), _pushed(false)
 	{	}
 
+	statistics_poll::~statistics_poll()
+	{	enable(false);	}
+
 	void statistics_poll::enable(bool value)
 	{
 		if (value == enabled())
 			return;
-		if (value)
+		if (value && _statistics->push_updates && _statistics->push_updates(true))
+			_pushed = true;
+		else if (value)
 			_invalidation = _statistics->invalidate += [this] {	on_invalidate();	}, on_invalidate();
+		else if (_pushed)
+			_statistics->push_updates(false), _pushed = false;
 		else
 			_invalidation.reset();
 	}
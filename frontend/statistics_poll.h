@@ -35,6 +35,7 @@ namespace micro_profiler
 	{
 	public:
 		statistics_poll(std::shared_ptr<const tables::statistics> statistics, tasker::queue &apartment_queue);
+		~statistics_poll();
 
 		void enable(bool value);
 		bool enabled() const throw();
@@ -46,8 +47,9 @@ namespace micro_profiler
 		const std::shared_ptr<const tables::statistics> _statistics;
 		tasker::private_queue _apartment_queue;
 		wpl::slot_connection _invalidation;
+		bool _pushed;
 	};
 
 	inline bool statistics_poll::enabled() const throw()
-	{	return !!_invalidation;	}
+	{	return _pushed || !!_invalidation;	}
 }
@@ -22,7 +22,7 @@
 
 #include "database.h"
 
-#include <map>
+#include <vector>
 
 namespace micro_profiler
 {
@@ -39,22 +39,54 @@ namespace micro_profiler
 		virtual const std::string &symbol_name_by_va(long_address_t address) const;
 		virtual bool symbol_fileline_by_va(long_address_t address, fileline_t &result) const;
 
+		// Returns the collation rank of the symbol name at the address: comparing ranks of two addresses gives the same
+		// result as comparing their names. Unresolved addresses get zero. Ranks shift whenever metadata arrives (that is,
+		// along with 'invalidate'), so they must not be kept across invalidations.
+		virtual unsigned int name_rank_by_va(long_address_t address) const;
+
 	public:
 		wpl::signal<void ()> invalidate;
 
 	public:
-		typedef std::map<unsigned int /*rva*/, const symbol_info *> ordered_symbols_map_t;
+		// Symbols of a module, keyed by RVA. RVAs are kept in Eytzinger (BFS) order in a flat array: the first levels of
+		// the implicit search tree share cache lines, so a lookup touches far less memory than a node-based tree.
+		struct module_symbols
+		{
+			void assign(const std::vector<symbol_info> &symbols);
+			std::size_t find_range(unsigned int rva) const; // Returns the slot of the symbol at or below 'rva', or zero.
+
+			std::vector<unsigned int> rvas; // One-based: the root is at [1], children of [k] are at [2k] and [2k + 1].
+			std::vector<const symbol_info *> symbols; // Parallel to 'rvas'.
+			std::vector<unsigned int> ranks; // Parallel to 'rvas', assigned across all the modules loaded.
+		};
+
 		typedef containers::unordered_map<id_t /*file_id*/, std::string /*file*/> file_lines_map_t;
 
 	private:
+		struct mapping_entry
+		{
+			long_address_t base;
+			id_t module_id;
+		};
+
+	private:
+		const mapping_entry *find_mapping(long_address_t address) const;
+		const module_symbols *get_module_symbols(id_t module_id) const;
 		const symbol_info *find_symbol_by_va(long_address_t address, id_t &module_id) const;
+		const module_symbols *find_slot_by_va(long_address_t address, std::size_t &slot) const;
+		void merge_name_ranks(module_symbols &symbols) const;
 
 	private:
 		std::string _empty;
 		const std::shared_ptr<const tables::modules> _modules;
 		const std::shared_ptr<const tables::module_mappings> _mappings;
+		std::vector< std::shared_ptr<void> > _mappings_connections;
 
-		mutable containers::unordered_map<id_t /*module_id*/, ordered_symbols_map_t> _symbols_ordered;
+		mutable std::vector<mapping_entry> _mappings_ordered;
+		mutable bool _mappings_dirty;
+		mutable containers::unordered_map<id_t /*module_id*/, module_symbols> _symbols_ordered;
+		mutable std::vector<const std::string *> _ranked_names; // Distinct, in collation order: the rank is index + 1.
+		mutable std::vector<id_t> _unranked_modules;
 		mutable containers::unordered_map<id_t /*module_id*/, const file_lines_map_t *> _file_lines;
 		mutable containers::unordered_map< id_t /*module_id*/, std::shared_ptr<void> > _requests;
 	};
@@ -267,6 +267,52 @@ namespace micro_profiler
 			}
 
 
+#ifndef _MSC_VER
+			test( MangledNamesReceivedAreDemangled )
+			{
+				// INIT
+				auto frontend_ = create_frontend();
+				emulator->add_handler(request_module_metadata, [&] (server_session::response &resp, unsigned) {
+					symbol_info symbols[] = {
+						{	"_ZN16a_tiny_namespace37function_that_hides_under_a_namespaceEv", 0x0100, 1	},
+						{	"main", 0x0200, 1	},
+						{	"_Z", 0x0300, 1	},
+					};
+					pair<unsigned, string> files[] = {	make_pair(0, "main.cpp"),	};
+
+					resp(response_module_metadata, create_metadata_info(10, symbols, files));
+				});
+				emulator->add_handler(request_update, [&] (server_session::response &resp) {
+					resp(response_modules_loaded, plural
+						+ make_mapping_pair(1, 17, 0x00100000u, "a", 10));
+				});
+				emulator->message(init, format(make_initialization_data("", 1)));
+
+				// ACT
+				modules(context)->request_presence(req[0], 17, [] (module_info_metadata) {});
+				worker.run_one(), apartment.run_one();
+
+				// ASSERT (the names are demangled at the worker queue)
+				assert_null(modules_by_id(*context).find(17));
+				assert_equal(1u, worker.tasks.size());
+				assert_is_empty(apartment.tasks);
+
+				// ACT
+				worker.run_one();
+				apartment.run_till_end();
+
+				// ASSERT
+				const auto m = modules_by_id(*context).find(17);
+
+				assert_not_null(m);
+				assert_equal(3u, m->symbols.size());
+				assert_equal("a_tiny_namespace::function_that_hides_under_a_namespace()", m->symbols[0].name);
+				assert_equal("main", m->symbols[1].name);
+				assert_equal("_Z", m->symbols[2].name);
+			}
+#endif
+
+
 			test( ModuleMetadataIsNotRequestFromRemoteIfFoundLocally )
 			{
 				// INIT
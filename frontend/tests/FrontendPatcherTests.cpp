@@ -6,7 +6,7 @@
 #include "primitive_helpers.h"
 
 #include <coipc/server_session.h>
-#include <common/serialization.h>
+#include <collector/serialization.h>
 #include <frontend/keyer.h>
 #include <patcher/interface.h>
 #include <test-helpers/helpers.h>
@@ -58,12 +58,12 @@ namespace micro_profiler
 			mocks::queue queue, worker_queue;
 			shared_ptr<server_session> emulator;
 			shared_ptr<frontend> frontend_;
+			shared_ptr<profiling_session> context;
 			shared_ptr<const tables::patches> patches;
 
 			init( Init )
 			{
 				auto e = make_shared<emulator_>(queue);
-				auto context = make_shared<profiling_session>();
 
 				frontend_ = make_shared<frontend>(e->server_session, make_shared<mocks::profiling_cache>(),
 					worker_queue, queue);
@@ -75,7 +75,7 @@ namespace micro_profiler
 					context = context_;
 				};
 				emulator->message(init, [] (serializer &s) {
-					initialization_data idata = {	"", 1	};
+					initialization_data idata = {	"", 1, 0, protocol_current	};
 					s(idata);
 				});
 
@@ -122,6 +122,39 @@ namespace micro_profiler
 			}
 
 
+			test( ApplyingCountersSendsCountOnlyRequestAndMarksPatchesOnResponse )
+			{
+				// INIT
+				vector<patch_apply_request> log;
+				auto counting = [] (patch_state_ex p) {	return p.count_only = true, p;	};
+
+				emulator->add_handler(request_apply_patches, [&] (server_session::response &resp, const patch_apply_request &payload) {
+					log.push_back(payload);
+					resp(response_patched, plural
+						+ mkpatch_change(13u, patch_change_result::ok, 1)
+						+ mkpatch_change(17u, patch_change_result::unrecoverable_error, 2));
+				});
+
+				// ACT
+				patches->apply_counters(101, mkrange(plural + patch_def(13u, 5) + patch_def(17u, 7)));
+
+				// ASSERT
+				assert_equal(1u, log.size());
+				assert_is_true(log.back().count_only);
+				assert_equal(plural + patch_def(13u, 5) + patch_def(17u, 7), log.back().functions);
+				assert_equivalent(plural
+					+ counting(make_patch(101, 13, 1, false, patch_state::active))
+					+ make_patch(101, 17, 2, false, patch_state::unrecoverable_error), *patches);
+
+				// ACT
+				patches->apply(101, mkrange(plural + patch_def(19u, 5)));
+
+				// ASSERT
+				assert_equal(2u, log.size());
+				assert_is_false(log.back().count_only);
+			}
+
+
 			test( PatchApplicationSetsTableToRequestedState )
 			{
 				// INIT
@@ -563,6 +596,63 @@ namespace micro_profiler
 			}
 
 
+			test( PausingActiveFunctionsSendsRequestAndResponseSetsPausedState )
+			{
+				// INIT
+				vector<patch_pause_request> log;
+				auto paused = [] (patch_state_ex p) {	return p.paused = true, p;	};
+
+				emulator->add_handler(request_apply_patches, emulate_apply_fn());
+
+				patches->apply(19, mkrange(plural + patch_def(1, 0) + patch_def(2, 0) + patch_def(3, 0)));
+
+				emulator->add_handler(request_pause_patches, [&] (server_session::response &resp, const patch_pause_request &payload) {
+					log.push_back(payload);
+					resp.defer([] (server_session::response &resp) {
+						resp(response_paused, plural
+							+ mkpatch_change(1, patch_change_result::ok)
+							+ mkpatch_change(3, patch_change_result::unchanged));
+					});
+				});
+
+				// ACT
+				patches->pause(19, mkrange(plural + 1u + 3u + 7u), true);
+
+				// ASSERT
+				assert_equal(1u, log.size());
+				assert_equal(19u, log.back().module_id);
+				assert_equal(plural + 1u + 3u, log.back().functions_rva);
+				assert_is_true(log.back().paused);
+				assert_equivalent(plural
+					+ make_patch(19, 1, 1, true, patch_state::active)
+					+ make_patch(19, 2, 2, false, patch_state::active)
+					+ make_patch(19, 3, 3, true, patch_state::active), *patches);
+
+				// ACT
+				queue.run_one();
+
+				// ASSERT
+				assert_equivalent(plural
+					+ paused(make_patch(19, 1, 1, false, patch_state::active))
+					+ make_patch(19, 2, 2, false, patch_state::active)
+					+ make_patch(19, 3, 3, false, patch_state::active, patch_change_result::unchanged), *patches);
+
+				// ACT
+				patches->pause(19, mkrange(plural + 1u), true);
+
+				// ASSERT
+				assert_equal(1u, log.size());
+
+				// ACT
+				patches->pause(19, mkrange(plural + 1u + 2u), false);
+
+				// ASSERT
+				assert_equal(2u, log.size());
+				assert_equal(plural + 1u, log.back().functions_rva);
+				assert_is_false(log.back().paused);
+			}
+
+
 			test( RevertingNotInstalledOrErroredOrInactiveOrRequestedFunctionsDoesNotInvokeARequest )
 			{
 				// INIT
@@ -687,6 +777,120 @@ namespace micro_profiler
 					+ make_patch(19, 3, 3, false, patch_state::active, patch_change_result::activation_error), log.back());
 			}
 
+
+			test( ApplyingModulePatchesSendsFilterAndSetsTableToTheStatesReceived )
+			{
+				// INIT
+				vector<module_patch_request> log;
+				module_patch_request filter = {	101, 16, 1000, "^foo", true, 3, false	};
+				module_patch_result result;
+				auto counting = [] (patch_state_ex p) {	return p.count_only = true, p;	};
+
+				emulator->add_handler(request_apply_patches, [] (server_session::response &resp, const patch_apply_request &) {
+					resp(response_patched, plural + mkpatch_change(17u, patch_change_result::ok, 1));
+				});
+				patches->apply_counters(101, mkrange(plural + patch_def(17u, 5)));
+				assert_equivalent(plural + counting(make_patch(101, 17, 1, false, patch_state::active)), *patches);
+				emulator->add_handler(request_apply_module_patches, [&] (server_session::response &resp,
+					const module_patch_request &payload) {
+
+					log.push_back(payload);
+					resp(response_module_patched, result);
+				});
+				result.rva_deltas = plural + 13u + 4u + 100u + 3u;
+				result.activated_runs = plural + 2u + 1u + 1u;
+
+				// ACT
+				patches->apply_module(filter);
+
+				// ASSERT
+				assert_equal(1u, log.size());
+				assert_equal(101u, log.back().module_id);
+				assert_equal(16u, log.back().min_size);
+				assert_equal(1000u, log.back().max_size);
+				assert_equal("^foo", log.back().name_pattern);
+				assert_is_true(log.back().exclude_leaves);
+				assert_equal(3u, log.back().top_k);
+				assert_is_false(log.back().count_only);
+				assert_equivalent(plural
+					+ make_patch(101, 13, 0, false, patch_state::active)
+					+ make_patch(101, 17, 1, false, patch_state::active)
+					+ make_patch(101, 117, 0, false, patch_state::dormant, patch_change_result::activation_error)
+					+ make_patch(101, 120, 0, false, patch_state::active), *patches);
+
+				// INIT
+				filter.module_id = 19;
+				result.rva_deltas = plural + 13u;
+				result.activated_runs = plural + 0u + 1u;
+
+				// ACT
+				patches->apply_module(filter);
+
+				// ASSERT
+				assert_equal(2u, log.size());
+				assert_equal(19u, log.back().module_id);
+				assert_equivalent(plural
+					+ make_patch(101, 13, 0, false, patch_state::active)
+					+ make_patch(101, 17, 1, false, patch_state::active)
+					+ make_patch(101, 117, 0, false, patch_state::dormant, patch_change_result::activation_error)
+					+ make_patch(101, 120, 0, false, patch_state::active)
+					+ make_patch(19, 13, 0, false, patch_state::dormant, patch_change_result::activation_error),
+					*patches);
+
+				// INIT
+				filter.count_only = true;
+				result.rva_deltas = plural + 7u + 6u;
+				result.activated_runs = plural + 1u + 1u;
+
+				// ACT
+				patches->apply_module(filter);
+
+				// ASSERT
+				assert_equal(3u, log.size());
+				assert_is_true(log.back().count_only);
+				assert_equivalent(plural
+					+ make_patch(101, 13, 0, false, patch_state::active)
+					+ make_patch(101, 17, 1, false, patch_state::active)
+					+ make_patch(101, 117, 0, false, patch_state::dormant, patch_change_result::activation_error)
+					+ make_patch(101, 120, 0, false, patch_state::active)
+					+ counting(make_patch(19, 7, 0, false, patch_state::active))
+					+ make_patch(19, 13, 0, false, patch_state::dormant, patch_change_result::activation_error),
+					*patches);
+			}
+
+
+			test( CountersPushedWithStatisticsAreStored )
+			{
+				// INIT
+				patch_counter counters[] = {	{	101u, 13u, 17u	}, {	101u, 19u, 3u	}, {	102u, 17u, 1u	},	};
+
+				emulator->add_handler(request_apply_patches, [] (server_session::response &resp, const patch_apply_request &) {
+					resp(response_patched, plural
+						+ mkpatch_change(13u, patch_change_result::ok, 1)
+						+ mkpatch_change(17u, patch_change_result::ok, 2));
+				});
+				emulator->add_handler(request_subscribe_updates, [] (server_session::response &, const update_subscription &) {	});
+				emulator->add_handler(request_update_credit, [] (server_session::response &, const update_credit &) {	});
+				patches->apply_counters(101, mkrange(plural + patch_def(13u, 5) + patch_def(17u, 7)));
+				context->statistics.push_updates(true);
+
+				// ACT
+				emulator->message(statistics_pushed, [&] (serializer &s) {
+					s(loaded_modules());
+					s(vector< pair<unsigned, thread_info> >());
+					s(vector< pair< unsigned, vector<call_graph_types<unsigned>::node> > >());
+					s(unloaded_modules());
+					s(mkvector(counters));
+				});
+
+				// ASSERT
+				auto p1 = make_patch(101, 13, 1, false, patch_state::active);
+				auto p2 = make_patch(101, 17, 2, false, patch_state::active);
+
+				p1.count_only = p2.count_only = true;
+				p1.calls = 17;
+				assert_equivalent(plural + p1 + p2, *patches);
+			}
 		end_test_suite
 	}
 }
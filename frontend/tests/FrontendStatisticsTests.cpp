@@ -44,6 +44,7 @@ namespace micro_profiler
 			};
 
 			const initialization_data idata = {	"", 1	};
+			const initialization_data idata_push = {	"", 1, 0, protocol_push_updates	};
 
 			template <typename T>
 			function<void (serializer &s)> format(const T &v)
@@ -408,6 +409,99 @@ namespace micro_profiler
 				// ASSERT
 				assert_equal(0, disconnections);
 			}
+
+			test( PushingIsNotSubscribedIfRemoteDoesNotSupportIt )
+			{
+				// INIT
+				auto frontend_ = create_frontend();
+				auto subscriptions = 0;
+
+				emulator->add_handler(request_update, [] (server_session::response &resp) {	empty_update(resp);	});
+				emulator->add_handler(request_subscribe_updates, [&] (server_session::response &, const update_subscription &) {
+					subscriptions++;
+				});
+				emulator->message(init, format(idata));
+
+				// ACT / ASSERT
+				assert_is_false(session->statistics.push_updates(true));
+
+				// ASSERT
+				assert_equal(0, subscriptions);
+			}
+
+
+			test( PushedStatisticsAreMergedAndCreditedBack )
+			{
+				// INIT
+				auto frontend_ = create_frontend();
+				vector<update_subscription> subscriptions;
+				vector<unsigned int> credits;
+				auto unsubscriptions = 0;
+
+				emulator->add_handler(request_update, [] (server_session::response &resp) {	empty_update(resp);	});
+				emulator->add_handler(request_subscribe_updates, [&] (server_session::response &, const update_subscription &s) {
+					subscriptions.push_back(s);
+				});
+				emulator->add_handler(request_unsubscribe_updates, [&] (server_session::response &) {
+					unsubscriptions++;
+				});
+				emulator->add_handler(request_update_credit, [&] (server_session::response &, const update_credit &c) {
+					credits.push_back(c.pushes);
+				});
+				emulator->message(init, format(idata_push));
+
+				// ACT
+				assert_is_true(session->statistics.push_updates(true));
+
+				// ASSERT
+				assert_equal(1u, subscriptions.size());
+				assert_is_true(subscriptions[0].window > 0);
+				assert_equal(0u, credits.size());
+
+				// ACT
+				emulator->message(statistics_pushed, [] (serializer &s) {
+					s(plural + make_mapping_pair(1, 12, 0x00100000u));
+					s(vector< pair<unsigned, thread_info> >());
+					s(plural
+						+ make_pair(1u, plural
+							+ make_statistics(0x00100093u, 11001u, 1, 11913, 901, 13000)));
+					s(unloaded_modules());
+				});
+
+				// ASSERT
+				call_statistics reference1[] = {
+					make_call_statistics(1, 1, 0, 0x00100093u, 11001u, 1, 11913, 901, 13000),
+				};
+
+				assert_equal_pred(reference1, session->statistics, eq());
+				assert_equal(1u, session->mappings.size());
+				assert_equal(1u, credits.size());
+				assert_equal(1u, credits[0]);
+
+				// ACT
+				emulator->message(statistics_pushed, [] (serializer &s) {
+					s(loaded_modules());
+					s(vector< pair<unsigned, thread_info> >());
+					s(plural
+						+ make_pair(1u, plural
+							+ make_statistics(0x00100093u, 1u, 0, 10, 9, 10)));
+					s(unloaded_modules());
+				});
+
+				// ASSERT
+				call_statistics reference2[] = {
+					make_call_statistics(1, 1, 0, 0x00100093u, 11002u, 1, 11923, 910, 13000),
+				};
+
+				assert_equal_pred(reference2, session->statistics, eq());
+				assert_equal(2u, credits.size());
+
+				// ACT
+				assert_is_true(session->statistics.push_updates(false));
+
+				// ASSERT
+				assert_equal(1, unsubscriptions);
+			}
 		end_test_suite
 	}
 }
@@ -246,6 +246,50 @@ namespace micro_profiler
 			}
 
 
+			test( ThreadInfosPiggybackedOntoUpdateSuppressSeparateRequests )
+			{
+				// INIT
+				auto frontend_ = create_frontend();
+				auto requests = 0;
+
+				emulator->add_handler(request_update, [&] (server_session::response &resp) {
+					resp(response_threads_info, plural
+						+ make_thread_info_pair(0u, 1717, "thread 1", false));
+					resp(response_statistics_update, make_single_threaded(plural
+						+ make_pair(1321222u, unthreaded_statistic_types::node()), 0));
+				});
+				emulator->add_handler(request_threads_info, [&] (server_session::response &, const vector<unsigned int> &) {
+					requests++;
+				});
+
+				// ACT
+				emulator->message(init, format(make_initialization_data("/test", 1)));
+				const auto &threads = context->threads;
+
+				// ASSERT
+				assert_equal(0, requests);
+				assert_equivalent(plural
+					+ make_thread_info(0u, 1717, "thread 1", false), threads);
+
+				// INIT
+				emulator->add_handler(request_update, [&] (server_session::response &resp) {
+					resp(response_threads_info, plural
+						+ make_pair(0u, make_thread_info(1717, "thread 1", mt::milliseconds(), mt::milliseconds(),
+							mt::milliseconds(), true)));
+					resp(response_statistics_update, make_single_threaded(plural
+						+ make_pair(1321222u, unthreaded_statistic_types::node()), 0));
+				});
+
+				// ACT
+				context->statistics.request_update();
+
+				// ASSERT
+				assert_equal(0, requests);
+				assert_equivalent(plural
+					+ make_thread_info(0u, 1717, "thread 1", true), threads);
+			}
+
+
 			test( UpdateIsRequestedOnlyForRunningThreads )
 			{
 				// INIT
@@ -481,6 +481,104 @@ namespace micro_profiler
 				assert_is_true(requests.back().expired());
 			}
 
+
+			test( ResolutionFollowsMappingsRemoval )
+			{
+				// INIT
+				symbol_resolver r(modules, mappings);
+				symbol_info symbols[] = { { "foo", 0x010, 3 }, };
+
+				add_records_invalidate(*mappings, plural + make_mapping(0, 1u, 0x1100000) + make_mapping(1, 1u, 0x1200000));
+				add_metadata(*modules, 1u, symbols);
+
+				assert_equal("foo", r.symbol_name_by_va(0x1200010));
+
+				// ACT
+				mappings->clear();
+				add_records_invalidate(*mappings, plural + make_mapping(0, 1u, 0x1200008));
+
+				// ASSERT
+				assert_is_empty(r.symbol_name_by_va(0x1100010));
+				assert_is_empty(r.symbol_name_by_va(0x1200010));
+				assert_equal("foo", r.symbol_name_by_va(0x1200018));
+			}
+
+
+			test( NameRanksOrderAddressesAsTheirNamesAcrossModules )
+			{
+				// INIT
+				symbol_resolver r(modules, mappings);
+				symbol_info symbols1[] = { { "foo", 0x010, 3 }, { "bar", 0x101, 5 }, { "Zed", 0x108, 5 }, };
+				symbol_info symbols2[] = { { "bar", 0x010, 7 }, { "baz", 0x100, 2 }, };
+
+				add_records_invalidate(*mappings, plural
+					+ make_mapping(0, 1u, 0x1100000)
+					+ make_mapping(1, 2u, 0x1200000));
+				add_metadata(*modules, 1u, symbols1);
+				add_metadata(*modules, 2u, symbols2);
+				r.symbol_name_by_va(0x1100000);
+				r.symbol_name_by_va(0x1200000);
+
+				// ACT
+				const auto foo = r.name_rank_by_va(0x1100011);
+				const auto bar1 = r.name_rank_by_va(0x1100101);
+				const auto zed = r.name_rank_by_va(0x1100108);
+				const auto bar2 = r.name_rank_by_va(0x1200010);
+				const auto baz = r.name_rank_by_va(0x1200101);
+
+				// ASSERT
+				assert_equal(0u, r.name_rank_by_va(0x1100000));
+				assert_equal(0u, r.name_rank_by_va(0x1000000));
+				assert_is_true(0u < zed);
+				assert_is_true(zed < bar1);
+				assert_equal(bar1, bar2);
+				assert_is_true(bar2 < baz);
+				assert_is_true(baz < foo);
+			}
+
+
+			test( NameRanksAreReassignedWhenMetadataArrives )
+			{
+				// INIT
+				symbol_info symbols1[] = { { "foo", 0x010, 3 }, { "zoo", 0x101, 5 }, };
+				symbol_info symbols2[] = { { "goo", 0x010, 7 }, };
+				auto cb = make_shared<tables::modules::metadata_ready_cb>();
+				symbol_resolver r(modules, mappings);
+				vector<unsigned> log;
+
+				add_records_invalidate(*mappings, plural
+					+ make_mapping(0, 1u, 0x1100000)
+					+ make_mapping(1, 2u, 0x1200000));
+				add_metadata(*modules, 1u, symbols1);
+
+				const auto foo = r.name_rank_by_va(0x1100010);
+				const auto zoo = r.name_rank_by_va(0x1100101);
+
+				modules->request_presence = [&cb] (shared_ptr<void> &req, unsigned, tables::modules::metadata_ready_cb cb_) {
+					cb = make_shared<tables::modules::metadata_ready_cb>(cb_);
+					req = cb;
+				};
+
+				auto conn = r.invalidate += [&] {
+					log.push_back(r.name_rank_by_va(0x1100010));
+					log.push_back(r.name_rank_by_va(0x1100101));
+					log.push_back(r.name_rank_by_va(0x1200010));
+				};
+
+				// ACT / ASSERT
+				assert_equal(0u, r.name_rank_by_va(0x1200010));
+				assert_is_true(foo < zoo);
+
+				// ACT
+				(*cb)(create_metadata(symbols2));
+
+				// ASSERT
+				assert_equal(3u, log.size());
+				assert_is_true(log[0] < log[2]);
+				assert_is_true(log[2] < log[1]);
+				assert_equal(log[2], r.name_rank_by_va(0x1200016));
+			}
+
 		end_test_suite
 	}
 }
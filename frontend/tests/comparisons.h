@@ -43,6 +43,9 @@ namespace micro_profiler
 			lhs.rva < rhs.rva ? true : rhs.rva < lhs.rva ? false :
 			lhs.state < rhs.state ? true : rhs.state < lhs.state ? false :
 			lhs.in_transit < rhs.in_transit ? true : rhs.in_transit < lhs.in_transit ? false :
+			lhs.paused < rhs.paused ? true : rhs.paused < lhs.paused ? false :
+			lhs.count_only < rhs.count_only ? true : rhs.count_only < lhs.count_only ? false :
+			lhs.calls < rhs.calls ? true : rhs.calls < lhs.calls ? false :
 				lhs.last_result < rhs.last_result;
 	}
 
@@ -26,6 +26,15 @@ namespace micro_profiler
 				return _names[address] = to_string_address(address);
 			}
 
+			unsigned int symbol_resolver::name_rank_by_va(long_address_t address) const
+			{
+				// Substituted names are zero-padded hex addresses: they collate in the address order and, consisting of
+				// digits and capitals, before the lowercase names used in tests.
+				if (const auto rank = micro_profiler::symbol_resolver::name_rank_by_va(address))
+					return 0x80000000u + rank;
+				return static_cast<unsigned int>(address) & 0x7FFFFFFFu;
+			}
+
 			string symbol_resolver::to_string_address(long_address_t value)
 			{
 				stringstream s;
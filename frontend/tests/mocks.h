@@ -15,6 +15,7 @@ namespace micro_profiler
 				symbol_resolver(std::shared_ptr<tables::modules> modules, std::shared_ptr<tables::module_mappings> mappings);
 
 				virtual const std::string &symbol_name_by_va(long_address_t address) const;
+				virtual unsigned int name_rank_by_va(long_address_t address) const;
 
 				static std::string to_string_address(long_address_t value);
 
@@ -3,6 +3,7 @@
 
 #include <common/memory_manager.h>
 #include <common/time.h>
+#include <cstring>
 #include <list>
 #include <mt/tls.h>
 #include <test-helpers/helpers.h>
@@ -216,11 +217,88 @@ namespace micro_profiler
 			stack_entry _stack_entries[16];
 		};
 
+#if defined(__x86_64__) && defined(__linux__)
+		// A trace in the layout expected by the fast-path trampoline. Records are written cyclically: the interceptor
+		// (called when the fast path bails out) rewinds the cursor.
+		struct fast_interceptor
+		{
+			struct record
+			{
+				timestamp_t timestamp;
+				const void *callee;
+			};
+
+			struct return_entry
+			{
+				const void **stack_ptr;
+				const void *return_address;
+			};
+
+			enum {	records_n = 1 << 16, returns_n = 16,	};
+
+			fast_interceptor()
+				: _ptr(_records), _n_left(records_n), _return_top(_returns + 1), _return_limit(_returns + returns_n)
+			{	_returns[0].stack_ptr = reinterpret_cast<const void **>(static_cast<size_t>(-1));	}
+
+			static void describe(fast_trace_layout &layout);
+
+			static void CC_(fastcall) on_enter(fast_interceptor *self, const void **stack_ptr,
+				timestamp_t timestamp, const void *callee) _CC(fastcall)
+			{
+				const return_entry e = {	stack_ptr, *stack_ptr	};
+
+				current = self;
+				*self->_return_top++ = e;
+				self->write(timestamp, callee);
+			}
+
+			static const void *CC_(fastcall) on_exit(fast_interceptor *self, const void ** /*stack_ptr*/,
+				timestamp_t timestamp) _CC(fastcall)
+			{
+				self->write(timestamp, 0);
+				return (--self->_return_top)->return_address;
+			}
+
+			static __thread fast_interceptor *current __attribute__((tls_model("initial-exec")));
+
+		private:
+			void write(timestamp_t timestamp, const void *callee)
+			{
+				if (_n_left <= 1)
+					_ptr = _records, _n_left = records_n;
+				_ptr->timestamp = timestamp, _ptr->callee = callee;
+				_ptr++, _n_left--;
+			}
+
+		private:
+			record *_ptr;
+			unsigned int _n_left;
+			return_entry *_return_top, *_return_limit;
+			record _records[records_n];
+			return_entry _returns[returns_n];
+		};
+
+		__thread fast_interceptor *fast_interceptor::current;
+
+		void fast_interceptor::describe(fast_trace_layout &layout)
+		{
+			layout.tls_offset = thread_pointer_offset(&current);
+			layout.record_ptr = offsetof(fast_interceptor, _ptr);
+			layout.records_left = offsetof(fast_interceptor, _n_left);
+			layout.return_top = offsetof(fast_interceptor, _return_top);
+			layout.return_limit = offsetof(fast_interceptor, _return_limit);
+		}
+#endif
+
 		void empty_function()
 		{
 		}
 	}
 
+	void run_call_chains();
+	void run_live_patching();
+	void run_patching(bool machine_readable);
+
 	float measure_rdtsc(unsigned repetitions)
 	{
 		stopwatch sw;
@@ -251,17 +329,51 @@ namespace micro_profiler
 			f();
 		return static_cast<float>(1e9 * sw() / repetitions);
 	}
+
+#if defined(__x86_64__) && defined(__linux__)
+	float measure_fast_hook_overhead(unsigned repetitions)
+	{
+		stopwatch sw;
+		unique_ptr<fast_interceptor> interceptor(new fast_interceptor);
+		fast_trace_layout layout;
+		auto allocator = memory_manager(virtual_memory::granularity())
+			.create_executable_allocator(const_byte_range(tests::address_cast_hack<const byte*>(&empty_function), 1), 32);
+		shared_ptr<void> thunk = allocator->allocate(c_fast_trampoline_size + c_jump_size);
+
+		fast_interceptor::describe(layout);
+		initialize_fast_trampoline(thunk.get(), 0, interceptor.get(), layout);
+		jump_initialize(static_cast<byte*>(thunk.get()) + c_fast_trampoline_size,
+			tests::address_cast_hack<const void*>(&empty_function));
+
+		auto f = tests::address_cast_hack<decltype(&empty_function)>(thunk.get());
+
+		sw();
+		for (auto n = repetitions; n; n--)
+			f();
+		return static_cast<float>(1e9 * sw() / repetitions);
+	}
+#endif
 }
 
-int main()
+int main(int argc, const char *argv[])
 {
 	using namespace micro_profiler;
 
+	// '--json' prints only the patching suite, as one JSON object per line, for regression tracking.
+	if (argc > 1 && !strcmp(argv[1], "--json"))
+		return run_patching(true), 0;
+
 	printf("rdtsc latency: %.1fns\n", measure_rdtsc(c_repetitions));
 	printf("Hooked call time (minimal): %.1fns\n", measure_hook_overhead<minimal_interceptor>(c_repetitions));
 	printf("Hooked call time (flat queue): %.1fns\n", measure_hook_overhead<queue_interceptor<single_queue_manager<flat_queue>>>(c_repetitions));
 	printf("Hooked call time (VLE queue): %.1fns\n", measure_hook_overhead<queue_interceptor<single_queue_manager<vle_queue>>>(c_repetitions));
 	printf("Hooked call time (tls, flat queue): %.1fns\n", measure_hook_overhead<queue_interceptor<tls_queue_manager<flat_queue>>>(c_repetitions));
 	printf("Hooked call time (tls, VLE queue): %.1fns\n", measure_hook_overhead<queue_interceptor<tls_queue_manager<vle_queue>>>(c_repetitions));
+#if defined(__x86_64__) && defined(__linux__)
+	printf("Hooked call time (fast path): %.1fns\n", measure_fast_hook_overhead(c_repetitions));
+#endif
+	run_call_chains();
+	run_patching(false);
+	run_live_patching();
 	return 0;
 }
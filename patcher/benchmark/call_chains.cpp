@@ -0,0 +1,93 @@
+#include <patcher/dynamic_hooking.h>
+#include <patcher/jump.h>
+
+#include <common/memory_manager.h>
+#include <common/time.h>
+#include <cstdio>
+#include <test-helpers/helpers.h>
+#include <vector>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace
+	{
+		typedef unsigned (*chain_link_t)(unsigned depth);
+
+		const unsigned c_calls = 20000000;
+		const unsigned c_depths[] = {	4, 16, 64, 256,	};
+
+		vector<chain_link_t> g_links;
+		volatile unsigned g_sink;
+
+		struct chain_interceptor
+		{
+			chain_interceptor()
+				: _stack_ptr(_stack_entries)
+			{	}
+
+			static void CC_(fastcall) on_enter(chain_interceptor *self, const void **stack_ptr,
+				timestamp_t /*timestamp*/, const void * /*callee*/) _CC(fastcall)
+			{	*self->_stack_ptr++ = *stack_ptr;	}
+
+			static const void *CC_(fastcall) on_exit(chain_interceptor *self, const void ** /*stack_ptr*/,
+				timestamp_t /*timestamp*/) _CC(fastcall)
+			{	return *--self->_stack_ptr;	}
+
+		private:
+			const void **_stack_ptr;
+			const void *_stack_entries[512];
+		};
+
+		// Calls the next link while 'depth' allows, and not as a tail call, so that every link returns with 'ret'.
+		FORCE_NOINLINE unsigned chain_link(unsigned depth)
+		{	return depth ? 1 + g_links[depth - 1](depth - 1) : 0;	}
+
+		// Returns nanoseconds per link of a chain of 'depth' calls: plain if 'interceptor' is null, or hooked through
+		// trampolines otherwise, having their exits unpaired if requested.
+		double measure_chain(unsigned depth, chain_interceptor *interceptor, bool unpaired)
+		{
+			stopwatch sw;
+			auto allocator = memory_manager(virtual_memory::granularity())
+				.create_executable_allocator(const_byte_range(tests::address_cast_hack<const byte *>(&chain_link), 1), 32);
+			vector< shared_ptr<void> > thunks;
+
+			g_links.assign(depth, &chain_link);
+			for (auto i = 0u; interceptor && i != depth; ++i)
+			{
+				auto thunk = allocator->allocate(c_trampoline_size + c_jump_size);
+
+				initialize_trampoline(thunk.get(), 0, interceptor);
+				if (unpaired)
+					unpair_trampoline_exit(thunk.get());
+				jump_initialize(static_cast<byte *>(thunk.get()) + c_trampoline_size,
+					tests::address_cast_hack<const void *>(&chain_link));
+				g_links[i] = tests::address_cast_hack<chain_link_t>(thunk.get());
+				thunks.push_back(thunk);
+			}
+
+			const auto repetitions = c_calls / depth;
+
+			sw();
+			for (auto n = repetitions; n; n--)
+				g_sink = chain_link(depth);
+			return 1e9 * sw() / (repetitions * depth);
+		}
+	}
+
+	void run_call_chains()
+	{
+		chain_interceptor interceptor;
+
+		for (auto i = begin(c_depths); i != end(c_depths); ++i)
+		{
+			const auto plain = measure_chain(*i, nullptr, false);
+			const auto paired = measure_chain(*i, &interceptor, false);
+			const auto unpaired = measure_chain(*i, &interceptor, true);
+
+			printf("Call chain (depth %u): plain %.1fns, hooked (ret exit) %.1fns, hooked (jmp exit) %.1fns per call\n",
+				*i, plain, paired, unpaired);
+		}
+	}
+}
@@ -0,0 +1,95 @@
+#include <patcher/translated_function_patch.h>
+
+#include <common/memory.h>
+#include <common/memory_manager.h>
+#include <common/time.h>
+#include <cstdio>
+#include <mt/thread.h>
+#include <vector>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace
+	{
+		typedef int (*increment_t)(int value);
+
+		const unsigned c_threads = 8;
+		const unsigned c_cycles = 20000;
+		const unsigned c_offsets[] = {	0 /*single store*/, 4 /*parked entry*/,	};
+
+		// {lea rax, [{rcx|rdi} + 1] | mov eax, [esp + 4]; inc eax}; ret - the first instruction is as long as a jump
+		// (disp32 forms are used), so that no thread can be stopped within the bytes replaced, like in hot-patchable code.
+#if defined(_M_X64)
+		const byte c_increment_body[] = {	0x48, 0x8D, 0x81, 0x01, 0x00, 0x00, 0x00, 0xC3,	};
+#elif defined(__x86_64__)
+		const byte c_increment_body[] = {	0x48, 0x8D, 0x87, 0x01, 0x00, 0x00, 0x00, 0xC3,	};
+#else
+		const byte c_increment_body[] = {	0x8B, 0x84, 0x24, 0x04, 0x00, 0x00, 0x00, 0x40, 0xC3,	};
+#endif
+
+		struct caller_stats
+		{
+			unsigned long long calls, mismatches;
+		};
+
+		// Activates and reverts a patch of the function placed at 'offset' off an 8-byte boundary, while c_threads
+		// threads call it and check the results: an incoherently modified prologue makes them fail or crash.
+		void validate_live_patching(unsigned offset)
+		{
+			stopwatch sw;
+			const auto size = virtual_memory::granularity();
+			const auto code = static_cast<byte *>(virtual_memory::allocate(size,
+				protection::read | protection::write | protection::execute));
+			const auto target = code + 64 + offset;
+			volatile count_t counted = 0;
+			volatile bool stop = false;
+			vector<caller_stats> stats(c_threads);
+			vector< unique_ptr<mt::thread> > threads;
+
+			mem_set(code, 0xCC, size);
+			mem_copy(target, c_increment_body, sizeof(c_increment_body));
+
+			auto allocator = memory_manager(size).create_executable_allocator(const_byte_range(code, size), 32);
+			translated_function_patch patch(target, sizeof(c_increment_body), &counted, *allocator);
+			const auto f = reinterpret_cast<increment_t>(target);
+
+			for (auto i = 0u; i != c_threads; ++i)
+			{
+				threads.push_back(unique_ptr<mt::thread>(new mt::thread([f, &stop, &stats, i] {
+					caller_stats s = {	0, 0	};
+
+					for (auto value = static_cast<int>(i); !stop; value += c_threads, s.calls++)
+						s.mismatches += f(value) != value + 1;
+					stats[i] = s;
+				})));
+			}
+
+			sw();
+			for (auto n = c_cycles; n; n--)
+				patch.activate(), patch.revert();
+
+			const auto elapsed = sw();
+
+			stop = true;
+			for (auto i = threads.begin(); i != threads.end(); ++i)
+				(*i)->join();
+
+			caller_stats total = {	0, 0	};
+
+			for (auto i = stats.begin(); i != stats.end(); ++i)
+				total.calls += i->calls, total.mismatches += i->mismatches;
+			printf("Live patching (offset %u, %u threads): %.1fus per activate/revert, %llu calls (%llu counted),"
+				" %llu mismatches\n", offset, c_threads, 1e6 * elapsed / c_cycles, total.calls,
+				static_cast<unsigned long long>(counted), total.mismatches);
+			virtual_memory::free(code, size);
+		}
+	}
+
+	void run_live_patching()
+	{
+		for (auto i = begin(c_offsets); i != end(c_offsets); ++i)
+			validate_live_patching(*i);
+	}
+}
@@ -0,0 +1,399 @@
+#include <patcher/image_patch_manager.h>
+
+#include <common/memory_manager.h>
+#include <common/time.h>
+#include <cstdio>
+#include <list>
+#include <mt/mutex.h>
+#include <mt/thread.h>
+#include <mt/tls.h>
+#include <patcher/translated_function_patch.h>
+#include <vector>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace
+	{
+		typedef int (*increment_t)(int value);
+
+		const unsigned c_function_size = 32;
+		const unsigned c_call_rounds = 10;
+		const unsigned c_caller_threads = 4;
+		const unsigned c_safety_cycles = 3;
+
+		const struct
+		{
+			unsigned functions, batch_size;
+		} c_cases[] = {
+			{	10000, 1	},
+			{	10000, 1024	},
+			{	50000, 1024	},
+			{	200000, 1024	},
+			{	200000, 200000	},
+		};
+
+		struct function_shape
+		{
+			const byte *body;
+			size_t size;
+		};
+
+		// Every shape returns its argument plus one, and starts with an instruction at least as long as a jump, so that
+		// callers running concurrently with patching cannot be caught within the replaced bytes.
+#if defined(_M_X64) || defined(__x86_64__)
+	#if defined(_M_X64)
+		const byte c_arg = 1; // ecx
+	#else
+		const byte c_arg = 7; // edi
+	#endif
+		// lea rax, [arg + dword 1]; ret
+		const byte c_lea_body[] = {	0x48, 0x8D, 0x80 | c_arg, 0x01, 0x00, 0x00, 0x00, 0xC3,	};
+
+		// mov eax, 1; add eax, arg; ret
+		const byte c_immediate_body[] = {	0xB8, 0x01, 0x00, 0x00, 0x00, 0x01, 0xC0 | c_arg << 3, 0xC3,	};
+
+		// sub rsp, dword 8; lea eax, [arg + 1]; add rsp, dword 8; ret
+		const byte c_frame_body[] = {
+			0x48, 0x81, 0xEC, 0x08, 0x00, 0x00, 0x00,
+			0x8D, 0x40 | c_arg, 0x01,
+			0x48, 0x81, 0xC4, 0x08, 0x00, 0x00, 0x00,
+			0xC3,
+		};
+
+		// mov rax, qword 1; add eax, arg; ret
+		const byte c_wide_immediate_body[] = {
+			0x48, 0xB8, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x01, 0xC0 | c_arg << 3,
+			0xC3,
+		};
+#else
+		// mov eax, [esp + dword 4]; inc eax; ret
+		const byte c_lea_body[] = {	0x8B, 0x84, 0x24, 0x04, 0x00, 0x00, 0x00, 0x40, 0xC3,	};
+
+		// mov eax, 1; add eax, [esp + 4]; ret
+		const byte c_immediate_body[] = {	0xB8, 0x01, 0x00, 0x00, 0x00, 0x03, 0x44, 0x24, 0x04, 0xC3,	};
+
+		// sub esp, dword 8; mov eax, [esp + 12]; inc eax; add esp, dword 8; ret
+		const byte c_frame_body[] = {
+			0x81, 0xEC, 0x08, 0x00, 0x00, 0x00,
+			0x8B, 0x44, 0x24, 0x0C,
+			0x40,
+			0x81, 0xC4, 0x08, 0x00, 0x00, 0x00,
+			0xC3,
+		};
+
+		// mov eax, [esp + dword 4]; add eax, dword 1; ret
+		const byte c_wide_immediate_body[] = {	0x8B, 0x84, 0x24, 0x04, 0x00, 0x00, 0x00, 0x05, 0x01, 0x00, 0x00, 0x00, 0xC3,	};
+#endif
+
+		const function_shape c_shapes[] = {
+			{	c_lea_body, sizeof(c_lea_body)	},
+			{	c_immediate_body, sizeof(c_immediate_body)	},
+			{	c_frame_body, sizeof(c_frame_body)	},
+			{	c_wide_immediate_body, sizeof(c_wide_immediate_body)	},
+		};
+
+		// Keeps the return addresses in a stack per calling thread, so that the hooked functions can be called from
+		// several threads at once.
+		class return_stack_interceptor : noncopyable
+		{
+		public:
+			static void CC_(fastcall) on_enter(return_stack_interceptor *self, const void **stack_ptr,
+				timestamp_t /*timestamp*/, const void * /*callee*/) _CC(fastcall)
+			{
+				auto s = self->_stacks_tls.get();
+
+				if (!s)
+					s = &self->create_stack();
+				*s->top++ = *stack_ptr;
+			}
+
+			static const void *CC_(fastcall) on_exit(return_stack_interceptor *self, const void ** /*stack_ptr*/,
+				timestamp_t /*timestamp*/) _CC(fastcall)
+			{	return *--self->_stacks_tls.get()->top;	}
+
+		private:
+			struct return_stack
+			{
+				const void **top;
+				const void *entries[16];
+			};
+
+		private:
+			FORCE_NOINLINE return_stack &create_stack()
+			{
+				mt::lock_guard<mt::mutex> l(_mtx);
+				const auto s = &*_stacks.emplace(_stacks.end());
+
+				s->top = s->entries;
+				_stacks_tls.set(s);
+				return *s;
+			}
+
+		private:
+			mt::tls<return_stack> _stacks_tls;
+			list<return_stack> _stacks;
+			mt::mutex _mtx;
+		};
+
+		// A mapped 'module' of patchable functions of the shapes above, laid out round-robin at c_function_size apart.
+		class synthetic_image : public mapping_access, noncopyable
+		{
+		public:
+			synthetic_image(unsigned functions)
+				: _size(functions * c_function_size)
+			{
+				const auto base = static_cast<byte *>(virtual_memory::allocate(_size,
+					protection::read | protection::write | protection::execute));
+				mapped_region r = {	base, _size, protection::read | protection::execute	};
+
+				mem_set(base, 0xCC, _size);
+				for (auto i = 0u; i != functions; ++i)
+				{
+					const auto &shape = c_shapes[i % (sizeof(c_shapes) / sizeof(c_shapes[0]))];
+
+					mem_copy(base + i * c_function_size, shape.body, shape.size);
+				}
+				_mapping.base = base;
+				_mapping.regions.push_back(r);
+			}
+
+			~synthetic_image()
+			{	virtual_memory::free(_mapping.base, _size);	}
+
+			increment_t function(unsigned index) const
+			{	return reinterpret_cast<increment_t>(_mapping.base + index * c_function_size);	}
+
+			virtual shared_ptr<module::mapping> lock_mapping(id_t /*mapping_id*/) override
+			{	return make_shared<module::mapping>(_mapping);	}
+
+			virtual shared_ptr<void> notify(events &events_) override
+			{	return events_.mapped(1, 1, _mapping), nullptr;	}
+
+		private:
+			const size_t _size;
+			module::mapping _mapping;
+		};
+
+		// Keeps the allocators handed out to the patch manager, to account for the trampoline memory.
+		class metered_memory_manager : public virtual_memory_manager
+		{
+		public:
+			metered_memory_manager()
+				: _underlying(virtual_memory::granularity())
+			{	}
+
+			executable_memory_allocator::statistics get_statistics() const
+			{
+				executable_memory_allocator::statistics total = {};
+
+				for (auto i = _allocators.begin(); i != _allocators.end(); ++i)
+				{
+					const auto s = (*i)->get_statistics();
+
+					total.blocks += s.blocks, total.reserved += s.reserved, total.allocated += s.allocated;
+				}
+				return total;
+			}
+
+			virtual shared_ptr<executable_memory_allocator> create_executable_allocator(const_byte_range reference,
+				ptrdiff_t distance_order) override
+			{
+				const auto a = _underlying.create_executable_allocator(reference, distance_order);
+
+				_allocators.push_back(a);
+				return a;
+			}
+
+			virtual shared_ptr<void> scoped_protect(byte_range region, int scoped_protection,
+				int released_protection) override
+			{	return _underlying.scoped_protect(region, scoped_protection, released_protection);	}
+
+		private:
+			memory_manager _underlying;
+			vector< shared_ptr<executable_memory_allocator> > _allocators;
+		};
+
+		// Threads calling every function of the image in turn and checking the results, until destroyed.
+		class callers : noncopyable
+		{
+		public:
+			callers(const synthetic_image &image, unsigned functions)
+				: _stop(false), _calls(c_caller_threads), _mismatches(c_caller_threads)
+			{
+				for (auto i = 0u; i != c_caller_threads; ++i)
+				{
+					_threads.push_back(unique_ptr<mt::thread>(new mt::thread([this, &image, functions, i] {
+						unsigned long long calls = 0, mismatches = 0;
+
+						for (auto n = i * functions / c_caller_threads; !_stop; n = (n + 1) % functions, calls++)
+							mismatches += image.function(n)(static_cast<int>(n)) != static_cast<int>(n) + 1;
+						_calls[i] = calls, _mismatches[i] = mismatches;
+					})));
+				}
+			}
+
+			~callers()
+			{	stop();	}
+
+			void stop()
+			{
+				_stop = true;
+				for (auto i = _threads.begin(); i != _threads.end(); ++i)
+					(*i)->join();
+				_threads.clear();
+			}
+
+			unsigned long long calls() const
+			{	return sum(_calls);	}
+
+			unsigned long long mismatches() const
+			{	return sum(_mismatches);	}
+
+		private:
+			static unsigned long long sum(const vector<unsigned long long> &values)
+			{
+				unsigned long long s = 0;
+
+				for (auto i = values.begin(); i != values.end(); ++i)
+					s += *i;
+				return s;
+			}
+
+		private:
+			volatile bool _stop;
+			vector<unsigned long long> _calls, _mismatches;
+			vector< unique_ptr<mt::thread> > _threads;
+		};
+
+		struct patching_results
+		{
+			double apply, revert, reapply; // Nanoseconds per function.
+			double plain_call, hooked_call; // Nanoseconds per call.
+			double trampoline_bytes; // Allocated per function.
+			size_t reserved_bytes;
+			unsigned long long concurrent_calls, mismatches, failures;
+		};
+
+		unsigned count_failures(const patch_manager::patch_change_results &results)
+		{
+			auto failures = 0u;
+
+			for (auto i = results.begin(); i != results.end(); ++i)
+				failures += patch_change_result::ok != i->result;
+			return failures;
+		}
+
+		double measure_calls(const synthetic_image &image, unsigned functions)
+		{
+			stopwatch sw;
+			volatile int sink = 0;
+
+			sw();
+			for (auto r = c_call_rounds; r; r--)
+			{
+				for (auto i = 0u; i != functions; ++i)
+					sink = image.function(i)(sink);
+			}
+			return 1e9 * sw() / (c_call_rounds * functions);
+		}
+
+		// Applies and reverts the whole image in batches of 'batch_size', then does it again several times while other
+		// threads keep calling the functions being patched.
+		patching_results measure_patching(unsigned functions, unsigned batch_size)
+		{
+			typedef patch_manager::apply_request_range apply_range;
+			typedef patch_manager::revert_request_range revert_range;
+
+			stopwatch sw;
+			patching_results pr = {};
+			synthetic_image image(functions);
+			metered_memory_manager mm;
+			return_stack_interceptor interceptor;
+			image_patch_manager pm([&] (void *target, size_t target_size, id_t, executable_memory_allocator &a) {
+				return unique_ptr<patch>(new translated_function_patch(target, target_size, &interceptor, a));
+			}, image, mm, image_patch_manager::counter_patch_factory(), image_patch_manager::sled_patch_factory(),
+				translated_function_patch::max_size(c_trampoline_size));
+			vector<patch_manager::apply_request> targets;
+			vector<patch_manager::revert_request> rvas;
+			patch_manager::patch_change_results results;
+			const auto apply = [&] {
+				for (auto i = 0u; i < functions; i += batch_size)
+				{
+					pm.apply(results, 1, apply_range(targets.data() + i, (min)(batch_size, functions - i)));
+					pr.failures += count_failures(results);
+				}
+			};
+			const auto revert = [&] {
+				for (auto i = 0u; i < functions; i += batch_size)
+				{
+					pm.revert(results, 1, revert_range(rvas.data() + i, (min)(batch_size, functions - i)));
+					pr.failures += count_failures(results);
+				}
+			};
+
+			for (auto i = 0u; i != functions; ++i)
+			{
+				targets.push_back(make_pair(i * c_function_size, c_function_size));
+				rvas.push_back(i * c_function_size);
+			}
+
+			pr.plain_call = measure_calls(image, functions);
+			sw();
+			apply();
+			pr.apply = 1e9 * sw() / functions;
+
+			const auto s = mm.get_statistics();
+
+			pr.trampoline_bytes = static_cast<double>(s.allocated) / functions;
+			pr.reserved_bytes = s.reserved;
+			pr.hooked_call = measure_calls(image, functions);
+			sw();
+			revert();
+			pr.revert = 1e9 * sw() / functions;
+			sw();
+			apply();
+			pr.reapply = 1e9 * sw() / functions;
+			revert();
+
+			callers callers_(image, functions);
+
+			for (auto n = c_safety_cycles; n; n--)
+				apply(), revert();
+			callers_.stop();
+			pr.concurrent_calls = callers_.calls();
+			pr.mismatches = callers_.mismatches();
+			return pr;
+		}
+	}
+
+	void run_patching(bool machine_readable)
+	{
+		for (auto i = begin(c_cases); i != end(c_cases); ++i)
+		{
+			const auto r = measure_patching(i->functions, i->batch_size);
+
+			if (machine_readable)
+			{
+				printf("{\"benchmark\": \"patching\", \"functions\": %u, \"batch_size\": %u, \"apply_ns\": %.1f, "
+					"\"revert_ns\": %.1f, \"reapply_ns\": %.1f, \"plain_call_ns\": %.2f, \"hooked_call_ns\": %.2f, "
+					"\"trampoline_bytes\": %.1f, \"reserved_bytes\": %llu, \"concurrent_calls\": %llu, "
+					"\"mismatches\": %llu, \"failures\": %llu}\n",
+					i->functions, i->batch_size, r.apply, r.revert, r.reapply, r.plain_call, r.hooked_call,
+					r.trampoline_bytes, static_cast<unsigned long long>(r.reserved_bytes), r.concurrent_calls,
+					r.mismatches, r.failures);
+			}
+			else
+			{
+				printf("Patching (%u functions, %u per apply): apply %.0fns, revert %.0fns, reapply %.0fns per function\n"
+					"\tcalls: plain %.1fns, hooked %.1fns; trampolines: %.0f bytes per function, %llu bytes reserved\n"
+					"\t%llu concurrent calls, %llu mismatches, %llu failed requests\n",
+					i->functions, i->batch_size, r.apply, r.revert, r.reapply, r.plain_call, r.hooked_call,
+					r.trampoline_bytes, static_cast<unsigned long long>(r.reserved_bytes), r.concurrent_calls,
+					r.mismatches, r.failures);
+			}
+		}
+	}
+}
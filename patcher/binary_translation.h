@@ -23,6 +23,7 @@
 #include "revert_buffer.h"
 
 #include <stdexcept>
+#include <vector>
 
 namespace micro_profiler
 {
@@ -38,12 +39,37 @@ namespace micro_profiler
 
 
 
+	// Marks the offsets of move_function() that do not start an instruction.
+	const size_t c_not_an_instruction = static_cast<size_t>(-1);
+
 	size_t calculate_fragment_length(const_byte_range source, size_t min_length);
 
-	void move_function(byte *destination, const_byte_range source);
+	// Returns the length of the CET landing pad (endbr64/endbr32) 'source' starts with, or zero. The pad must stay at
+	// the entry, so that indirect calls still land on it.
+	size_t calculate_landing_pad_length(const_byte_range source);
+
+	// Returns the upper bound of the length move_function() may translate 'source' to.
+	size_t calculate_moved_length(const_byte_range source);
+
+	// Returns the upper bound of calculate_moved_length() over all the fragments calculate_fragment_length() may measure
+	// for 'min_length'.
+	size_t max_moved_length(size_t min_length);
+
+	// Moves the instructions of 'source' to 'destination', and returns the length they take there. Short jumps leaving
+	// the fragment are widened to near ones, and inner jumps are retargeted accordingly. Rip-based operands are
+	// re-offset, and 'lea/mov reg, [rip + disp]' are rewritten through a 64-bit literal if their target gets out of
+	// reach. If requested, 'offsets' receives the offset in 'destination' of each byte of 'source' that starts an
+	// instruction (c_not_an_instruction for the rest), followed by the length.
+	size_t move_function(byte *destination, const_byte_range source, std::vector<size_t> *offsets = nullptr);
 
 	void offset_displaced_references(revert_buffer &rbuffer, byte_range source, const_byte_range displaced_region,
 		const byte *displaced_to);
 
 	void validate_partial_function(const_byte_range function_fragment);
+
+	// Validates the remainder of a function like the above, except that its jumps may also land at the instructions of
+	// the 'moved' fragment preceding it - short ones not within its first 'overwritten_length' bytes. The offsets of the
+	// instructions jumped to within the overwritten bytes are put to 'overwritten_targets'.
+	void validate_partial_function(const_byte_range function_fragment, const_byte_range moved,
+		size_t overwritten_length, std::vector<size_t> &overwritten_targets);
 }
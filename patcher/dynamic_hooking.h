@@ -22,10 +22,27 @@
 
 #include <common/compiler.h>
 #include <common/types.h>
+#include <cstddef>
 
 namespace micro_profiler
 {
 	extern const size_t c_trampoline_size;
+	extern const size_t c_fast_trampoline_size; // Zero if the platform has no fast-path trampoline.
+	extern const size_t c_count_trampoline_size;
+
+	// Where a fast-path trampoline finds the calling thread's trace: a pointer to it is read from a static TLS slot at
+	// 'tls_offset' from the thread pointer, the rest are byte offsets of the trace's fields. Call records and return
+	// entries are written with the layouts of {timestamp_t, const void *callee} and {const void **stack_ptr,
+	// const void *return_address} respectively. The return stack must start with a sentinel entry having the highest
+	// possible 'stack_ptr'.
+	struct fast_trace_layout
+	{
+		std::ptrdiff_t tls_offset;
+		int record_ptr; // call_record *
+		int records_left; // unsigned int, a record that makes it zero is left to the interceptor.
+		int return_top; // return_entry *, one past the top entry.
+		int return_limit; // return_entry *
+	};
 
 	template <typename InterceptorT>
 	struct hook_types
@@ -47,10 +64,34 @@ namespace micro_profiler
 	};
 
 
+	// A trampoline only calls the interceptor while the byte at 'enabled' is nonzero, otherwise it passes control
+	// straight to the code following it. Clearing the byte pauses the measurement without touching any code. A null
+	// 'enabled' makes the trampoline unconditional.
 	void initialize_trampoline(void *at, const void *id, void *interceptor,
-		hooks<void>::on_enter_t *on_enter, hooks<void>::on_exit_t *on_exit);
+		hooks<void>::on_enter_t *on_enter, hooks<void>::on_exit_t *on_exit, const volatile byte *enabled = nullptr);
+
+	void initialize_fast_trampoline(void *at, const void *id, void *interceptor,
+		hooks<void>::on_enter_t *on_enter, hooks<void>::on_exit_t *on_exit, const fast_trace_layout &layout,
+		const volatile byte *enabled = nullptr);
+
+	// A count-only trampoline atomically increments '*counter' and passes control to the code following it: there are
+	// no timestamps, no interceptor calls and no return hook. The counter must be naturally aligned.
+	void initialize_count_trampoline(void *at, volatile count_t *counter, const volatile byte *enabled = nullptr);
+
+	// Makes a trampoline initialized at 'at' leave with 'jmp' to the caller's return address instead of 'ret'. Such a
+	// return is not paired with the caller's 'call' and makes the CPU mispredict the returns up the stack - only useful
+	// for measurements.
+	void unpair_trampoline_exit(void *at);
+
+	// Returns the offset of a static (initial-exec) TLS variable from the thread pointer.
+	std::ptrdiff_t thread_pointer_offset(const void *tls_variable);
+
+	template <typename T>
+	inline void initialize_trampoline(void *at, const void *id, T *interceptor, const volatile byte *enabled = nullptr)
+	{	initialize_trampoline(at, id, interceptor, hooks<T>::on_enter(), hooks<T>::on_exit(), enabled);	}
 
 	template <typename T>
-	inline void initialize_trampoline(void *at, const void *id, T *interceptor)
-	{	initialize_trampoline(at, id, interceptor, hooks<T>::on_enter(), hooks<T>::on_exit());	}
+	inline void initialize_fast_trampoline(void *at, const void *id, T *interceptor, const fast_trace_layout &layout,
+		const volatile byte *enabled = nullptr)
+	{	initialize_fast_trampoline(at, id, interceptor, hooks<T>::on_enter(), hooks<T>::on_exit(), layout, enabled);	}
 }
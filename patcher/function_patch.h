@@ -31,25 +31,38 @@ namespace micro_profiler
 	{
 	public:
 		template <typename T>
-		function_patch(void *target, T *interceptor, executable_memory_allocator &allocator_);
+		function_patch(void *target, T *interceptor, executable_memory_allocator &allocator_,
+			const fast_trace_layout *fast_layout = nullptr);
 
 		bool active() const;
 		virtual bool activate() override;
 		virtual bool revert() override;
+		virtual bool pause(bool paused) override;
 
 	private:
-		std::shared_ptr<void> _trampoline;
+		static std::size_t trampoline_size(const fast_trace_layout *fast_layout);
+		volatile byte &enabled() const;
+
+	private:
+		const std::size_t _trampoline_size;
+		std::shared_ptr<void> _trampoline; // Trampoline, jump to the jumper and the enable flag.
 		jumper _jumper;
 	};
 
 
 
 	template <typename T>
-	inline function_patch::function_patch(void *target, T *interceptor, executable_memory_allocator &allocator_)
-		: _trampoline(allocator_.allocate(c_trampoline_size + c_jump_size)), _jumper(target, _trampoline.get())
+	inline function_patch::function_patch(void *target, T *interceptor, executable_memory_allocator &allocator_,
+			const fast_trace_layout *fast_layout)
+		: _trampoline_size(trampoline_size(fast_layout)),
+			_trampoline(allocator_.allocate(_trampoline_size + c_jump_size + 1)), _jumper(target, _trampoline.get())
 	{
-		initialize_trampoline(_trampoline.get(), target, interceptor);
-		jump_initialize(static_cast<byte *>(_trampoline.get()) + c_trampoline_size, _jumper.entry());
+		enabled() = 1;
+		if (fast_layout && c_fast_trampoline_size)
+			initialize_fast_trampoline(_trampoline.get(), target, interceptor, *fast_layout, &enabled());
+		else
+			initialize_trampoline(_trampoline.get(), target, interceptor, &enabled());
+		jump_initialize(static_cast<byte *>(_trampoline.get()) + _trampoline_size, _jumper.entry());
 	}
 
 	inline bool function_patch::active() const
@@ -60,4 +73,20 @@ namespace micro_profiler
 
 	inline bool function_patch::revert()
 	{	return _jumper.revert();	}
+
+	inline bool function_patch::pause(bool paused)
+	{
+		volatile byte &enabled_ = enabled();
+
+		if (!enabled_ == paused)
+			return false;
+		enabled_ = !paused;
+		return true;
+	}
+
+	inline std::size_t function_patch::trampoline_size(const fast_trace_layout *fast_layout)
+	{	return fast_layout && c_fast_trampoline_size ? c_fast_trampoline_size : c_trampoline_size;	}
+
+	inline volatile byte &function_patch::enabled() const
+	{	return static_cast<byte *>(_trampoline.get())[_trampoline_size + c_jump_size];	}
 }
@@ -24,29 +24,55 @@
 
 #include <common/auto_increment.h>
 #include <functional>
+#include <map>
 #include <mt/mutex.h>
 #include <sdb/table.h>
+#include <string>
 
 namespace micro_profiler
 {
 	class executable_memory_allocator;
 
+	// Tells how the functions of a module requested for patching since it was last mapped were patched.
+	struct patch_coverage
+	{
+		patch_coverage();
+
+		unsigned int translated, sled, unpatchable;
+		std::map<std::string, unsigned int> reasons; // Unpatchable functions by the reason reported.
+	};
+
 	class image_patch_manager : public patch_manager, mapping_access::events, noncopyable
 	{
 	public:
 		typedef std::function<std::unique_ptr<patch> (void *target, std::size_t target_size, id_t id,
 			executable_memory_allocator &allocator)> patch_factory;
+		typedef std::function<std::unique_ptr<patch> (void *target, std::size_t target_size, volatile count_t *counter,
+			executable_memory_allocator &allocator)> counter_patch_factory;
+		typedef std::function<std::unique_ptr<patch> (void *target, id_t id,
+			executable_memory_allocator &allocator)> sled_patch_factory;
+		typedef std::shared_ptr< const std::vector<unsigned int> > patchable_entries_ptr;
 		struct mapping;
 
 	public:
-		image_patch_manager(patch_factory patch_factory_, mapping_access &mappings, virtual_memory_manager &memory_manager_);
+		// The size bounds are the most memory a patch made by the respective factory takes from the allocator. A batch
+		// applied reserves that much per function, unless the bound is zero.
+		image_patch_manager(patch_factory patch_factory_, mapping_access &mappings, virtual_memory_manager &memory_manager_,
+			counter_patch_factory counter_patch_factory_ = counter_patch_factory(),
+			sled_patch_factory sled_patch_factory_ = sled_patch_factory(), std::size_t patch_size_bound = 0,
+			std::size_t counter_patch_size_bound = 0);
 		~image_patch_manager();
 
 		virtual std::shared_ptr<mapping> lock_module(id_t module_id);
+		patch_coverage get_coverage(id_t module_id);
 
 		virtual void query(patch_states &states, id_t module_id) override;
 		virtual void apply(patch_change_results &results, id_t module_id, apply_request_range targets) override;
 		virtual void revert(patch_change_results &results, id_t module_id, revert_request_range targets) override;
+		virtual void apply_counters(patch_change_results &results, id_t module_id, apply_request_range targets) override;
+		virtual void read_counters(patch_counters &counters) override;
+		virtual void pause(patch_change_results &results, id_t module_id, revert_request_range targets,
+			bool paused) override;
 
 	private:
 		struct mapping_record
@@ -54,6 +80,8 @@ namespace micro_profiler
 			id_t module_id;
 			id_t mapping_id;
 			std::shared_ptr<executable_memory_allocator> allocator;
+			patchable_entries_ptr patchable_entries;
+			patch_coverage coverage;
 		};
 
 		struct patch_record
@@ -65,15 +93,26 @@ namespace micro_profiler
 			id_t module_id;
 			unsigned int rva, size;
 			enum {	dormant, active, unrecoverable_error, activation_error,	} state;
+			bool paused, count_only;
+			std::unique_ptr<count_t> counter; // Outlives the patch it is incremented by.
 			std::unique_ptr<micro_profiler::patch> patch;
+			std::unique_ptr<micro_profiler::patch> retired; // A reverted patch of the other mode, kept until unmapping.
 		};
 
 	private:
+		void apply(patch_change_results &results, id_t module_id, apply_request_range targets, bool count_only);
+		std::unique_ptr<micro_profiler::patch> create_patch(patch_record &record, byte *target,
+			executable_memory_allocator &allocator, const patchable_entries_ptr &patchable_entries,
+			patch_coverage &coverage);
+
 		virtual void mapped(id_t module_id, id_t mapping_id, const module::mapping &mapping) override;
 		virtual void unmapped(id_t mapping_id) override;
 
 	private:
 		const patch_factory _patch_factory;
+		const counter_patch_factory _counter_patch_factory;
+		const sled_patch_factory _sled_patch_factory;
+		const std::size_t _patch_size_bound, _counter_patch_size_bound;
 		mapping_access &_mapping_access;
 		virtual_memory_manager &_memory_manager;
 		mt::mutex _mtx;
@@ -85,20 +124,28 @@ namespace micro_profiler
 
 	struct image_patch_manager::mapping : module::mapping
 	{
-		mapping(const module::mapping &from, std::shared_ptr<executable_memory_allocator> allocator_)
-			: module::mapping(from), allocator(allocator_)
+		mapping(const module::mapping &from, std::shared_ptr<executable_memory_allocator> allocator_,
+				patchable_entries_ptr patchable_entries_ = nullptr)
+			: module::mapping(from), allocator(allocator_), patchable_entries(patchable_entries_)
 		{	}
 
 		std::shared_ptr<executable_memory_allocator> allocator;
+		patchable_entries_ptr patchable_entries; // Sorted RVAs of the NOP sleds reserved at the compile time.
 	};
 
 
 
+	inline patch_coverage::patch_coverage()
+		: translated(0), sled(0), unpatchable(0)
+	{	}
+
 	inline image_patch_manager::patch_record::patch_record()
-		: state(dormant)
+		: state(dormant), paused(false), count_only(false)
 	{	}
 
 	inline image_patch_manager::patch_record::patch_record(patch_record &&from)
-		: id(from.id), module_id(from.module_id), rva(from.rva), state(from.state), patch(std::move(from.patch))
+		: id(from.id), module_id(from.module_id), rva(from.rva), state(from.state), paused(from.paused),
+			count_only(from.count_only), counter(std::move(from.counter)), patch(std::move(from.patch)),
+			retired(std::move(from.retired))
 	{	}
 }
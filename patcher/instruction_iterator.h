@@ -34,6 +34,7 @@ namespace micro_profiler
 		bool fetch();
 		byte length() const;
 		bool is_rip_based() const;
+		byte displacement_offset() const; // Offset of the displacement of a rip-based operand.
 		const char *mnemonic() const;
 		const char *operands() const;
 
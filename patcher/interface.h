@@ -47,6 +47,13 @@ namespace micro_profiler
 		errors result;
 	};
 
+	struct patch_counter
+	{
+		id_t module_id;
+		unsigned int rva;
+		count_t calls; // Total number of calls counted since the patch was first applied.
+	};
+
 	struct mapping_access
 	{
 		struct events;
@@ -68,6 +75,7 @@ namespace micro_profiler
 	{
 		typedef std::vector<patch_change_result> patch_change_results;
 		typedef std::vector<patch_state> patch_states;
+		typedef std::vector<patch_counter> patch_counters;
 		typedef std::pair<unsigned int /*rva*/, unsigned int /*size*/> apply_request;
 		typedef range<const apply_request, size_t> apply_request_range;
 		typedef unsigned int /*rva*/ revert_request;
@@ -78,6 +86,16 @@ namespace micro_profiler
 		virtual void query(patch_states &states, id_t module_id) = 0;
 		virtual void apply(patch_change_results &results, id_t module_id, apply_request_range targets) = 0;
 		virtual void revert(patch_change_results &results, id_t module_id, revert_request_range targets) = 0;
+
+		// Applies count-only patches: the calls are just counted, with no timing and no call tree. A function patched
+		// in the other mode must be reverted first. The counts are read with read_counters().
+		virtual void apply_counters(patch_change_results &results, id_t module_id, apply_request_range targets) = 0;
+		virtual void read_counters(patch_counters &counters) = 0;
+
+		// Pauses (or resumes) measurement of the patched functions without changing their code. The state is kept for
+		// patches not yet applied and survives revert/apply.
+		virtual void pause(patch_change_results &results, id_t module_id, revert_request_range targets,
+			bool paused) = 0;
 	};
 
 	struct patch
@@ -85,5 +103,6 @@ namespace micro_profiler
 		virtual ~patch() {	}
 		virtual bool activate() = 0;
 		virtual bool revert() = 0;
+		virtual bool pause(bool paused) = 0; // Returns false if the patch was already in the state requested.
 	};
 }
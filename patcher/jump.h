@@ -27,4 +27,7 @@ namespace micro_profiler
 	extern const std::size_t c_jump_size;
 	
 	void jump_initialize(void *at, const void *target);
+
+	// Initializes a jump at 'at' to be copied to 'location' later.
+	void jump_initialize(void *at, const void *target, const void *location);
 }
@@ -26,31 +26,118 @@
 
 using namespace std;
 
+#if defined(__x86_64__) && defined(__linux__)
+	#define MP_FAST_TRAMPOLINE
+#endif
+
 extern "C" {
 	extern const uint8_t micro_profiler_trampoline_proto;
+	extern const uint8_t micro_profiler_trampoline_proto_exit;
 	extern const uint8_t micro_profiler_trampoline_proto_end;
+	extern const uint8_t micro_profiler_count_trampoline_proto;
+	extern const uint8_t micro_profiler_count_trampoline_proto_end;
+#ifdef MP_FAST_TRAMPOLINE
+	extern const uint8_t micro_profiler_fast_trampoline_proto;
+	extern const uint8_t micro_profiler_fast_trampoline_proto_end;
+#endif
 }
 
 namespace micro_profiler
 {
+	namespace
+	{
+		const byte c_always_enabled = 1;
+
+		void set_hooks(byte_range prologue, const void *id, void *interceptor, hooks<void>::on_enter_t *on_enter,
+			hooks<void>::on_exit_t *on_exit, const volatile byte *enabled)
+		{
+			if (!enabled)
+				enabled = &c_always_enabled;
+			replace(prologue, 0x0A, [enabled] (...) {	return reinterpret_cast<size_t>(enabled);	});
+			replace(prologue, 1, [interceptor] (...) {	return reinterpret_cast<size_t>(interceptor);	});
+			replace(prologue, 2, [id] (...) {	return reinterpret_cast<size_t>(id);	});
+			replace(prologue, 3, [on_enter] (...) {	return reinterpret_cast<size_t>(on_enter);	});
+			replace(prologue, 0x83, [on_enter] (ptrdiff_t address) {
+				return reinterpret_cast<ptrdiff_t>(on_enter) - address;
+			});
+			replace(prologue, 4, [on_exit] (...) {	return reinterpret_cast<size_t>(on_exit);	});
+			replace(prologue, 0x84, [on_exit] (ptrdiff_t address) {
+				return reinterpret_cast<ptrdiff_t>(on_exit) - address;
+			});
+		}
+	}
+
 	const size_t c_trampoline_size = &micro_profiler_trampoline_proto_end - &micro_profiler_trampoline_proto;
+	const size_t c_count_trampoline_size = &micro_profiler_count_trampoline_proto_end
+		- &micro_profiler_count_trampoline_proto;
+#ifdef MP_FAST_TRAMPOLINE
+	const size_t c_fast_trampoline_size = &micro_profiler_fast_trampoline_proto_end
+		- &micro_profiler_fast_trampoline_proto;
+#else
+	const size_t c_fast_trampoline_size = 0;
+#endif
 
 
 	void initialize_trampoline(void *at, const void *id, void *interceptor,
-		hooks<void>::on_enter_t *on_enter, hooks<void>::on_exit_t *on_exit)
+		hooks<void>::on_enter_t *on_enter, hooks<void>::on_exit_t *on_exit, const volatile byte *enabled)
 	{
 		byte_range prologue(static_cast<byte *>(at), c_trampoline_size);
 
 		mem_copy(prologue.begin(), &micro_profiler_trampoline_proto, prologue.length());
-		replace(prologue, 1, [interceptor] (...) {	return reinterpret_cast<size_t>(interceptor);	});
-		replace(prologue, 2, [id] (...) {	return reinterpret_cast<size_t>(id);	});
-		replace(prologue, 3, [on_enter] (...) {	return reinterpret_cast<size_t>(on_enter);	});
-		replace(prologue, 0x83, [on_enter] (ptrdiff_t address) {
-			return reinterpret_cast<ptrdiff_t>(on_enter) - address;
-		});
-		replace(prologue, 4, [on_exit] (...) {	return reinterpret_cast<size_t>(on_exit);	});
-		replace(prologue, 0x84, [on_exit] (ptrdiff_t address) {
-			return reinterpret_cast<ptrdiff_t>(on_exit) - address;
-		});
+		set_hooks(prologue, id, interceptor, on_enter, on_exit, enabled);
+	}
+
+	void initialize_fast_trampoline(void *at, const void *id, void *interceptor,
+		hooks<void>::on_enter_t *on_enter, hooks<void>::on_exit_t *on_exit, const fast_trace_layout &layout,
+		const volatile byte *enabled)
+	{
+#ifdef MP_FAST_TRAMPOLINE
+		byte_range prologue(static_cast<byte *>(at), c_fast_trampoline_size);
+
+		mem_copy(prologue.begin(), &micro_profiler_fast_trampoline_proto, prologue.length());
+		set_hooks(prologue, id, interceptor, on_enter, on_exit, enabled);
+		replace(prologue, 5, [&layout] (...) {	return static_cast<int32_t>(layout.tls_offset);	});
+		replace(prologue, 6, [&layout] (...) {	return static_cast<int32_t>(layout.record_ptr);	});
+		replace(prologue, 7, [&layout] (...) {	return static_cast<int32_t>(layout.records_left);	});
+		replace(prologue, 8, [&layout] (...) {	return static_cast<int32_t>(layout.return_top);	});
+		replace(prologue, 9, [&layout] (...) {	return static_cast<int32_t>(layout.return_limit);	});
+#else
+		(void)layout;
+		initialize_trampoline(at, id, interceptor, on_enter, on_exit, enabled);
+#endif
+	}
+
+	void initialize_count_trampoline(void *at, volatile count_t *counter, const volatile byte *enabled)
+	{
+		byte_range prologue(static_cast<byte *>(at), c_count_trampoline_size);
+		const auto counter_halves = reinterpret_cast<volatile size_t *>(counter);
+
+		if (!enabled)
+			enabled = &c_always_enabled;
+		mem_copy(prologue.begin(), &micro_profiler_count_trampoline_proto, prologue.length());
+		replace(prologue, 0x0A, [enabled] (...) {	return reinterpret_cast<size_t>(enabled);	});
+		replace(prologue, 0x0B, [counter_halves] (...) {	return reinterpret_cast<size_t>(counter_halves);	});
+		replace(prologue, 0x0C, [counter_halves] (...) {	return reinterpret_cast<size_t>(counter_halves + 1);	});
+	}
+
+	void unpair_trampoline_exit(void *at)
+	{
+		const byte c_jump_ecx_rcx[] = {	0xFF, 0xE1,	};
+
+		mem_copy(static_cast<byte *>(at) + (&micro_profiler_trampoline_proto_exit - &micro_profiler_trampoline_proto),
+			c_jump_ecx_rcx, sizeof(c_jump_ecx_rcx));
+	}
+
+	ptrdiff_t thread_pointer_offset(const void *tls_variable)
+	{
+#ifdef MP_FAST_TRAMPOLINE
+		const byte *thread_pointer;
+
+		asm ("mov %%fs:0, %0" : "=r"(thread_pointer));
+		return static_cast<const byte *>(tls_variable) - thread_pointer;
+#else
+		(void)tls_variable;
+		return 0;
+#endif
 	}
 }
@@ -20,6 +20,9 @@
 
 #include <patcher/image_patch_manager.h>
 
+#include <algorithm>
+#include <common/image_info.h>
+#include <common/memory.h>
 #include <common/smart_ptr.h>
 #include <logger/log.h>
 #include <patcher/exceptions.h>
@@ -82,14 +85,38 @@ namespace micro_profiler
 			return locks;
 		}
 
+		// A sled may start before the entry of its function (-fpatchable-function-entry=N,M places M of the N NOPs before
+		// the entry), so the function at 'rva' has one only if it is the recorded sled start or is preceded by nothing but
+		// the NOPs of the sled recorded last before it.
+		bool has_sled(const image_patch_manager::patchable_entries_ptr &entries, const byte *target, unsigned int rva)
+		{
+			if (!entries)
+				return false;
+
+			auto i = upper_bound(entries->begin(), entries->end(), rva);
+
+			return i != entries->begin() && all_of(target - (rva - *--i), target, [] (byte b) {	return 0x90 == b;	});
+		}
+
 		template <typename T>
 		void prepare(vector<T> &v, size_t capacity)
 		{	v.clear(), v.reserve(capacity);	}
+
+		void accumulate(patch_coverage &to, const patch_coverage &from)
+		{
+			to.translated += from.translated, to.sled += from.sled, to.unpatchable += from.unpatchable;
+			for (auto i = from.reasons.begin(); i != from.reasons.end(); ++i)
+				to.reasons[i->first] += i->second;
+		}
 	}
 
 	image_patch_manager::image_patch_manager(patch_factory patch_factory_, mapping_access &mapping_access_,
-			virtual_memory_manager &memory_manager_)
-		: _patch_factory(patch_factory_), _mapping_access(mapping_access_), _memory_manager(memory_manager_),
+			virtual_memory_manager &memory_manager_, counter_patch_factory counter_patch_factory_,
+			sled_patch_factory sled_patch_factory_, size_t patch_size_bound, size_t counter_patch_size_bound)
+		: _patch_factory(patch_factory_), _counter_patch_factory(counter_patch_factory_),
+			_sled_patch_factory(sled_patch_factory_), _patch_size_bound(patch_size_bound),
+			_counter_patch_size_bound(counter_patch_size_bound), _mapping_access(mapping_access_),
+			_memory_manager(memory_manager_),
 			_mapping_subscription(mapping_access_.notify(*this))
 	{	}
 
@@ -119,13 +146,22 @@ namespace micro_profiler
 
 		if (const auto l = find_mapping(m) ? _mapping_access.lock_mapping(m.mapping_id) : nullptr)
 		{
-			auto c = make_shared_copy(make_tuple(mapping(*l, m.allocator), l, protect(_memory_manager, l->regions)));
+			auto c = make_shared_copy(make_tuple(mapping(*l, m.allocator, m.patchable_entries), l,
+				protect(_memory_manager, l->regions)));
 
 			return make_shared_aspect(c, &get<0>(*c));
 		}
 		return nullptr;
 	}
 
+	patch_coverage image_patch_manager::get_coverage(id_t module_id)
+	{
+		mt::lock_guard<mt::mutex> l(_mtx);
+		const auto m = sdb::unique_index<module_keyer>(_mappings).find(module_id);
+
+		return m ? m->coverage : patch_coverage();
+	}
+
 	void image_patch_manager::query(patch_states &states, id_t module_id)
 	{
 		mt::lock_guard<mt::mutex> l(_mtx);
@@ -157,13 +193,42 @@ namespace micro_profiler
 	}
 
 	void image_patch_manager::apply(patch_change_results &results, id_t module_id, apply_request_range targets)
+	{	apply(results, module_id, targets, false);	}
+
+	void image_patch_manager::apply_counters(patch_change_results &results, id_t module_id,
+		apply_request_range targets)
+	{	apply(results, module_id, targets, true);	}
+
+	void image_patch_manager::read_counters(patch_counters &counters)
+	{
+		mt::lock_guard<mt::mutex> l(_mtx);
+
+		counters.clear();
+		for (auto i = _patches.begin(); i != _patches.end(); ++i)
+		{
+			if (i->counter)
+			{
+				patch_counter c = {	i->module_id, i->rva, *static_cast<const volatile count_t *>(i->counter.get())	};
+
+				counters.push_back(c);
+			}
+		}
+	}
+
+	void image_patch_manager::apply(patch_change_results &results, id_t module_id, apply_request_range targets,
+		bool count_only)
 	{
 		prepare(results, targets.length());
 
 		auto locked = lock_module(module_id);
+		const auto size_bound = count_only ? _counter_patch_size_bound : _patch_size_bound;
+		auto reserved = !size_bound;
+		patch_coverage coverage;
 		mt::lock_guard<mt::mutex> l(_mtx);
 		auto &patch_idx = sdb::unique_index(_patches, module_rva_keyer());
 
+		// The batch is applied in two passes under the single protection change made by lock_module(): all the
+		// trampolines are built first (into one arena reserved on the first build), then all the jumps are written.
 		for (auto i = targets.begin(); i != targets.end(); ++i)
 		{
 			auto patch_record = patch_idx[make_tuple(module_id, i->first)]; // Postcondition: id, rva, module_id are set.
@@ -175,22 +240,31 @@ namespace micro_profiler
 				switch (p.state)
 				{
 				case patch_record::dormant:
+					if (p.count_only != count_only)
+					{
+						// A thread may still be running through the reverted trampoline, so it stays intact until the
+						// module is unmapped and gets reused should the mode be switched back.
+						swap(p.patch, p.retired);
+						p.count_only = count_only;
+					}
 					p.size = i->second;
 					p.state = patch_record::unrecoverable_error;
 					result.result = patch_change_result::unrecoverable_error;
 					if (!p.patch && locked)
-						p.patch = move(_patch_factory(locked->base + i->first, i->second, p.id, *locked->allocator));
+					{
+						if (locked->allocator && !reserved)
+							locked->allocator->reserve((targets.end() - i) * size_bound), reserved = true;
+						p.patch = create_patch(p, locked->base + i->first, *locked->allocator,
+							locked->patchable_entries, coverage);
+					}
 					p.state = patch_record::activation_error;
 					result.result = patch_change_result::activation_error;
 
 				case patch_record::activation_error:
-					if (p.patch)
-						if (locked) // TODO: check 'locked' as well.
-							p.patch->activate();
-						else
-							break;
-					p.state = patch_record::active;
-					result.result = patch_change_result::ok;
+					if (!p.patch) // Pending: gets activated once the module is mapped.
+						p.state = patch_record::active, result.result = patch_change_result::ok;
+					else
+						result.result = patch_change_result::activation_error;
 					break;
 
 				case patch_record::active:
@@ -209,6 +283,55 @@ namespace micro_profiler
 			patch_record.commit();
 			results.push_back(result);
 		}
+
+		if (!locked)
+			return;
+
+		if (coverage.translated || coverage.sled || coverage.unpatchable)
+		{
+			auto mapping_record = sdb::unique_index<module_keyer>(_mappings)[module_id];
+			auto &total = (*mapping_record).coverage;
+
+			accumulate(total, coverage);
+			LOG(PREAMBLE "coverage...") % A(module_id) % A(total.translated) % A(total.sled) % A(total.unpatchable);
+			for (auto i = coverage.reasons.begin(); i != coverage.reasons.end(); ++i)
+				LOG(PREAMBLE "unpatchable functions...") % A(module_id) % A(i->first) % A(i->second);
+			mapping_record.commit();
+		}
+
+		auto serialized = false;
+
+		for (auto r = results.begin(); r != results.end(); ++r)
+		{
+			if (patch_change_result::activation_error != r->result)
+				continue;
+
+			// Trampolines may have been built over the released ones, which other threads could have prefetched.
+			if (!serialized)
+				serialize_code_modifications(), serialized = true;
+
+			auto patch_record = patch_idx[make_tuple(module_id, r->rva)];
+			auto &p = *patch_record;
+
+			try
+			{
+				if (patch_record::active == p.state)
+				{
+					r->result = patch_change_result::unchanged; // The same function requested twice in a batch.
+				}
+				else
+				{
+					p.patch->activate();
+					p.state = patch_record::active;
+					r->result = patch_change_result::ok;
+				}
+			}
+			catch (exception &e)
+			{
+				LOGE("Failed to activate patch...") % A(p.module_id) % A(p.id) % A(p.rva) % A(e.what());
+			}
+			patch_record.commit();
+		}
 	}
 
 	void image_patch_manager::revert(patch_change_results &results, id_t module_id, revert_request_range targets)
@@ -249,6 +372,89 @@ namespace micro_profiler
 		}
 	}
 
+	void image_patch_manager::pause(patch_change_results &results, id_t module_id, revert_request_range targets,
+		bool paused)
+	{
+		prepare(results, targets.length());
+
+		// No code is modified here: trampolines check their enable flags, so neither the module lock nor the protection
+		// change is required.
+		mt::lock_guard<mt::mutex> l(_mtx);
+		auto &patch_idx = sdb::unique_index(_patches, module_rva_keyer());
+
+		for (auto i = targets.begin(); i != targets.end(); ++i)
+		{
+			auto key = make_tuple(module_id, *i);
+			patch_change_result result = {	0, *i, patch_change_result::unchanged,	};
+
+			if (patch_idx.find(key))
+			{
+				auto patch_record = patch_idx[key];
+				auto &p = *patch_record;
+
+				result.id = p.id;
+				if (p.paused != paused)
+				{
+					if (p.patch)
+						p.patch->pause(paused);
+					if (p.retired)
+						p.retired->pause(paused);
+					p.paused = paused;
+					result.result = patch_change_result::ok;
+				}
+				patch_record.commit();
+			}
+			results.push_back(result);
+		}
+	}
+
+	unique_ptr<patch> image_patch_manager::create_patch(patch_record &record, byte *target,
+		executable_memory_allocator &allocator, const patchable_entries_ptr &patchable_entries,
+		patch_coverage &coverage)
+	try
+	{
+		unique_ptr<patch> p;
+		auto sled = false;
+
+		if (record.count_only)
+		{
+			if (!_counter_patch_factory)
+				throw invalid_argument("count-only patches are not supported");
+			if (!record.counter)
+				record.counter.reset(new count_t(0));
+			p = _counter_patch_factory(target, record.size, record.counter.get(), allocator);
+		}
+		else
+		{
+			// A compiler-reserved NOP sled takes no binary translation; a sled that cannot be used (e.g. is not
+			// preceded by enough padding) is fallen back from.
+			if (_sled_patch_factory && has_sled(patchable_entries, target, record.rva))
+			{
+				try
+				{
+					p = _sled_patch_factory(target, record.id, allocator);
+					sled = !!p;
+				}
+				catch (patch_exception &e)
+				{
+					LOG(PREAMBLE "unusable sled, translating...") % A(record.module_id) % A(record.rva) % A(e.what());
+				}
+			}
+			if (!p)
+				p = _patch_factory(target, record.size, record.id, allocator);
+		}
+		if (record.paused)
+			p->pause(true);
+		(sled ? coverage.sled : coverage.translated)++;
+		return p;
+	}
+	catch (exception &e)
+	{
+		coverage.unpatchable++;
+		coverage.reasons[e.what()]++;
+		throw;
+	}
+
 	void image_patch_manager::mapped(id_t module_id, id_t mapping_id, const module::mapping &mapping)
 	{
 		auto allocator = [&] () -> shared_ptr<executable_memory_allocator> {
@@ -270,14 +476,21 @@ namespace micro_profiler
 			}
 			return !empty ? _memory_manager.create_executable_allocator(const_byte_range(b, (e - b)), 32) : nullptr;
 		}();
+		const auto patchable_entries = [&] () -> patchable_entries_ptr {
+			auto entries = make_shared< vector<unsigned int> >();
+
+			read_patchable_entries(*entries, mapping.path, mapping.base);
+			return !entries->empty() ? entries : nullptr;
+		}();
 		auto protection_scope = protect(_memory_manager, mapping.regions);
+		patch_coverage coverage;
 		mt::lock_guard<mt::mutex> l(_mtx);
 		auto &patch_idx = sdb::unique_index(_patches, module_rva_keyer());
 		auto mapping_record = sdb::unique_index(_mappings, module_keyer())[module_id];
 
 		(*mapping_record).mapping_id = mapping_id;
 		(*mapping_record).allocator = allocator;
-		mapping_record.commit();
+		(*mapping_record).patchable_entries = patchable_entries;
 		for (auto r = sdb::multi_index(_patches, module_keyer()).equal_range(module_id); r.first != r.second; r.first++)
 		{
 			auto patch_record = patch_idx[make_tuple(module_id, r.first->rva)];
@@ -290,7 +503,7 @@ namespace micro_profiler
 				case patch_record::activation_error:
 				case patch_record::active:
 					p.state = patch_record::unrecoverable_error;
-					p.patch = move(_patch_factory(mapping.base + p.rva, p.size, p.id, *allocator));
+					p.patch = create_patch(p, mapping.base + p.rva, *allocator, patchable_entries, coverage);
 					p.state = patch_record::activation_error;
 					p.patch->activate();
 					p.state = patch_record::active;
@@ -302,6 +515,8 @@ namespace micro_profiler
 			}
 			patch_record.commit();
 		}
+		(*mapping_record).coverage = coverage; // Only the patches reapplied to the new mapping are accounted.
+		mapping_record.commit();
 	}
 
 	void image_patch_manager::unmapped(id_t mapping_id)
@@ -316,8 +531,15 @@ namespace micro_profiler
 			auto patch_record = patch_idx[make_tuple(module_id, r.first->rva)];
 
 			(*patch_record).patch.reset();
+			(*patch_record).retired.reset();
 			patch_record.commit();
 		}
+		if (const auto allocator = (*mapping_record).allocator)
+		{
+			const auto s = allocator->get_statistics();
+
+			LOG(PREAMBLE "trampoline memory on unmapping...") % A(module_id) % A(s.blocks) % A(s.reserved) % A(s.allocated);
+		}
 		mapping_record.remove();
 	}
 }
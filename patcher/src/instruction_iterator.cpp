@@ -85,6 +85,9 @@ namespace micro_profiler
 		return false;
 	}
 
+	byte instruction_iterator_::displacement_offset() const
+	{	return _impl->instructions[_impl->current].detail->x86.encoding.disp_offset;	}
+
 	const char *instruction_iterator_::mnemonic() const
 	{	return _impl->instructions[_impl->current].mnemonic;	}
 
@@ -1,10 +1,13 @@
 #include <patcher/binary_translation.h>
 
+#include <algorithm>
 #include <capstone/capstone.h>
 #include <common/memory.h>
 #include <common/noncopyable.h>
+#include <cstring>
 #include <patcher/instruction_iterator.h>
 #include <stddef.h>
+#include <vector>
 
 using namespace std;
 
@@ -54,6 +57,138 @@ namespace micro_profiler
 				return;
 			}
 		}
+
+		bool fits_dword(ptrdiff_t value)
+		{	return static_cast<sdword>(value) == value;	}
+
+		// A moved instruction together with the location of its relative displacement (if any) and the address the
+		// displacement refers to.
+		struct moved_instruction
+		{
+			const byte *ptr;
+			byte length, displacement_offset, displacement_size;
+			bool rip_based;
+			const byte *target;
+		};
+
+		struct displacement_locator : displacement_visitor<const byte>
+		{
+			virtual void visit_byte(const byte *displacement) const
+			{	locate(displacement, sizeof(sbyte), *reinterpret_cast<const sbyte *>(displacement));	}
+
+			virtual void visit_dword(const byte *displacement) const
+			{	locate(displacement, sizeof(sdword), *reinterpret_cast<const sdword *>(displacement));	}
+
+			void locate(const byte *displacement, byte size, ptrdiff_t value) const
+			{
+				instruction->displacement_offset = static_cast<byte>(displacement - instruction->ptr);
+				instruction->displacement_size = size;
+				instruction->target = displacement + size + value;
+			}
+
+			moved_instruction *instruction;
+		};
+
+		void read_instructions(vector<moved_instruction> &instructions, const_byte_range source)
+		{
+			displacement_locator l;
+
+			for (instruction_iterator<const byte> i(source); i.fetch(); )
+			{
+				moved_instruction mi = {	i.ptr(), i.length(), 0, 0, i.is_rip_based(), nullptr	};
+
+				if (0xCC == *i.ptr())
+					throw inconsistent_function_range_exception("debug interrupt met");
+				if (mi.rip_based)
+				{
+					mi.displacement_offset = i.displacement_offset();
+					mi.displacement_size = sizeof(sdword);
+					mi.target = mi.ptr + mi.length + *reinterpret_cast<const sdword *>(mi.ptr + mi.displacement_offset);
+				}
+				l.instruction = &mi;
+				visit_instruction(l, i);
+				instructions.push_back(mi);
+			}
+		}
+
+		// Recognizes '[rex] lea|mov reg, [rip + disp32]', which can be rewritten through a 64-bit literal, if the address
+		// it refers to cannot be reached from where it is moved to.
+		bool is_rip_load(const moved_instruction &mi, byte &rex, byte &opcode, byte &reg)
+		{
+			const auto rex_ = (mi.ptr[0] & 0xF0) == 0x40 ? mi.ptr[0] : static_cast<byte>(0);
+			const auto ptr = mi.ptr + !!rex_;
+
+			if ((ptr[0] != 0x8D && ptr[0] != 0x8B) || (ptr[1] & 0xC7) != 0x05 || mi.length != (ptr - mi.ptr) + 6)
+				return false;
+			rex = rex_, opcode = ptr[0], reg = static_cast<byte>((ptr[1] >> 3 & 7) | (rex_ & 4 ? 8 : 0));
+			return true;
+		}
+
+		size_t rewrite_rip_load(byte *destination, const moved_instruction &mi)
+		{
+			byte rex, opcode, reg;
+			const auto at = destination;
+
+			is_rip_load(mi, rex, opcode, reg);
+			if (0x8D == opcode && !(rex & 8))
+			{
+				// lea r32: mov r32, imm32
+				if (reg & 8)
+					*destination++ = 0x41;
+				*destination++ = static_cast<byte>(0xB8 | (reg & 7));
+				mem_copy(destination, &mi.target, 4);
+				return destination + 4 - at;
+			}
+
+			const auto address = reinterpret_cast<unsigned long long>(mi.target);
+
+			// mov r64, imm64
+			*destination++ = static_cast<byte>(0x48 | (reg & 8 ? 1 : 0));
+			*destination++ = static_cast<byte>(0xB8 | (reg & 7));
+			mem_copy(destination, &address, 8);
+			destination += 8;
+			if (0x8B == opcode)
+			{
+				// mov r, [r64]
+				const auto rex_load = static_cast<byte>(0x40 | (rex & 8) | (reg & 8 ? 5 : 0));
+				const auto r = static_cast<byte>((reg & 7) << 3 | (reg & 7));
+
+				if (rex_load != 0x40)
+					*destination++ = rex_load;
+				*destination++ = 0x8B;
+				if ((reg & 7) == 4)
+					*destination++ = static_cast<byte>((r & 0x38) | 0x04), *destination++ = 0x24; // [rsp/r12] takes SIB.
+				else if ((reg & 7) == 5)
+					*destination++ = static_cast<byte>(r | 0x40), *destination++ = 0x00; // [rbp/r13] takes disp8.
+				else
+					*destination++ = r;
+			}
+			return destination - at;
+		}
+
+		// Tells if a rip-based load is to be rewritten through a literal, when placed at 'destination' (if known).
+		bool needs_literal(const moved_instruction &mi, const byte *destination)
+		{
+			byte rex, opcode, reg;
+
+			return mi.rip_based && is_rip_load(mi, rex, opcode, reg)
+				&& (!destination || !fits_dword(mi.target - (destination + mi.length)));
+		}
+
+		// Returns the length of the translated instruction, or its upper bound if 'destination' is not known yet.
+		size_t translated_length(const moved_instruction &mi, const_byte_range source, const byte *destination)
+		{
+			if (needs_literal(mi, destination))
+			{
+				byte rewritten[16];
+				const auto length = rewrite_rip_load(rewritten, mi);
+
+				return destination ? length : (max)(length, static_cast<size_t>(mi.length));
+			}
+			if (sizeof(sbyte) == mi.displacement_size && !source.inside(mi.target))
+				return 0xEB == *mi.ptr ? 5u /*jmp rel32*/ : 6u /*jcc rel32*/;
+			return mi.length;
+		}
 	}
 
 	inconsistent_function_range_exception::inconsistent_function_range_exception(const char *message)
@@ -75,44 +210,106 @@ namespace micro_profiler
 		return actual_length;
 	}
 
-	void move_function(byte *destination, const_byte_range source)
+	size_t calculate_landing_pad_length(const_byte_range source)
 	{
-		struct offset_displacement : displacement_visitor<const byte>
+		const byte endbr[] = {	0xF3, 0x0F, 0x1E,	}; // endbr64 (0xFA) / endbr32 (0xFB)
+
+		return source.length() >= 4 && !memcmp(source.begin(), endbr, sizeof(endbr))
+			&& (0xFA == source.begin()[3] || 0xFB == source.begin()[3]) ? 4u : 0u;
+	}
+
+	size_t calculate_moved_length(const_byte_range source)
+	{
+		vector<moved_instruction> instructions;
+		size_t length = 0;
+
+		read_instructions(instructions, source);
+		for (auto i = instructions.begin(); i != instructions.end(); ++i)
+			length += translated_length(*i, source, nullptr);
+		return length;
+	}
+
+	size_t max_moved_length(size_t min_length)
+	{
+		// No instruction grows more than threefold (a short jump widened to 'jcc rel32'), a literal load taking 14 bytes
+		// at most. The last instruction starts within 'min_length' bytes and is up to 15 bytes long.
+		return 3 * (min_length - 1) + 15;
+	}
+
+	size_t move_function(byte *destination, const_byte_range source, vector<size_t> *offsets)
+	{
+		vector<moved_instruction> instructions;
+		vector<size_t> offsets_(source.length() + 1, c_not_an_instruction);
+		size_t length = 0;
+
+		read_instructions(instructions, source);
+		for (auto i = instructions.begin(); i != instructions.end(); ++i)
 		{
-			offset_displacement(const_byte_range source, ptrdiff_t delta)
-				: _source(source), _delta(delta)
-			{	}
+			offsets_[i->ptr - source.begin()] = length;
+			length += translated_length(*i, source, destination + length);
+		}
+		offsets_[source.length()] = length;
 
-			virtual void visit_byte(const byte *displacement) const
+		for (auto i = instructions.begin(); i != instructions.end(); ++i)
+		{
+			const auto at = destination + offsets_[i->ptr - source.begin()];
+			const auto translated = translated_length(*i, source, at);
+			ptrdiff_t displacement;
+
+			if (!i->displacement_size)
 			{
-				if (!is_target_inside<sbyte>(displacement, _source))
-					throw inconsistent_function_range_exception("short relative jump outside the moved range");
+				mem_copy(at, i->ptr, i->length);
 			}
+			else if (source.inside(i->target))
+			{
+				// An inner jump: retargeted to where its target is moved to.
+				const auto target_offset = offsets_[i->target - source.begin()];
 
-			virtual void visit_dword(const byte *displacement) const
+				if (c_not_an_instruction == target_offset)
+					throw inconsistent_function_range_exception("relative jump into the middle of an instruction");
+				displacement = (destination + target_offset) - (at + i->length);
+				if (sizeof(sbyte) == i->displacement_size && static_cast<sbyte>(displacement) != displacement)
+					throw inconsistent_function_range_exception("short relative jump cannot reach its moved target");
+				mem_copy(at, i->ptr, i->length);
+				if (sizeof(sbyte) == i->displacement_size)
+				{
+					at[i->displacement_offset] = static_cast<byte>(displacement);
+				}
+				else
+				{
+					const auto displacement_ = static_cast<sdword>(displacement);
+
+					mem_copy(at + i->displacement_offset, &displacement_, sizeof(displacement_));
+				}
+			}
+			else if (needs_literal(*i, at))
 			{
-				if (!is_target_inside<sdword>(displacement, _source))
-					*reinterpret_cast<dword *>(dest + (displacement - src)) += static_cast<sdword>(_delta);
+				rewrite_rip_load(at, *i);
 			}
+			else
+			{
+				// An outer reference: keeps pointing to the same address, through a near jump if it was a short one.
+				const auto widened = translated != i->length;
+				const auto displacement_offset = widened ? translated - sizeof(sdword) : i->displacement_offset;
 
-			const byte *src;
-			byte *dest;
+				if (!widened)
+					mem_copy(at, i->ptr, i->length);
+				else if (0xEB == *i->ptr)
+					at[0] = 0xE9;
+				else
+					at[0] = 0x0F, at[1] = static_cast<byte>(0x80 | (*i->ptr & 0x0F));
+				displacement = i->target - (at + translated);
+				if (!fits_dword(displacement))
+					throw inconsistent_function_range_exception("relative reference cannot reach its target");
 
-		private:
-			const_byte_range _source;
-			ptrdiff_t _delta;
-		} v(source, source.begin() - destination);
+				const auto displacement_ = static_cast<sdword>(displacement);
 
-		for (instruction_iterator<const byte> i(source); i.fetch(); destination += i.length())
-		{
-			if (i.is_rip_based())
-				throw inconsistent_function_range_exception("rip-based addressing is not supported yet");
-			if (0xCC == *i.ptr())
-				throw inconsistent_function_range_exception("debug interrupt met");
-			mem_copy(destination, i.ptr(), i.length());
-			v.src = i.ptr(), v.dest = destination;
-			visit_instruction(v, i);
+				mem_copy(at + displacement_offset, &displacement_, sizeof(displacement_));
+			}
 		}
+		if (offsets)
+			offsets->swap(offsets_);
+		return length;
 	}
 
 	void offset_displaced_references(revert_buffer &rbuffer, byte_range source, const_byte_range displaced_region,
@@ -192,4 +389,63 @@ namespace micro_profiler
 			if (*i.ptr() != 0xE8 /*call*/)
 				visit_instruction(v, i);
 	}
+
+	void validate_partial_function(const_byte_range function_fragment, const_byte_range moved,
+		size_t overwritten_length, vector<size_t> &overwritten_targets)
+	{
+		struct jump_range_validator : displacement_visitor<const byte>
+		{
+			jump_range_validator(const_byte_range function_fragment, const_byte_range moved, size_t overwritten_length)
+				: _function_fragment(function_fragment), _moved(moved), _overwritten_length(overwritten_length),
+					_boundaries(moved.length())
+			{
+				for (instruction_iterator<const byte> i(moved); i.fetch(); )
+					_boundaries[i.ptr() - moved.begin()] = true;
+			}
+
+			virtual void visit_dword(const byte *displacement) const
+			{
+				if (!is_target_inside<sdword>(displacement, _function_fragment))
+					validate_moved_target(displacement + sizeof(sdword) + *reinterpret_cast<const sdword *>(displacement), false);
+			}
+
+			virtual void visit_byte(const byte *displacement) const
+			{
+				if (!is_target_inside<const sbyte>(displacement, _function_fragment))
+					validate_moved_target(displacement + sizeof(sbyte) + *reinterpret_cast<const sbyte *>(displacement), true);
+			}
+
+		private:
+			void validate_moved_target(const byte *target, bool short_) const
+			{
+				const auto offset = static_cast<size_t>(target - _moved.begin());
+
+				if (!_moved.inside(target))
+					throw inconsistent_function_range_exception("relative jump outside the function");
+				if (!_boundaries[offset])
+					throw inconsistent_function_range_exception("relative jump into the middle of a moved instruction");
+				if (offset < _overwritten_length)
+				{
+					if (short_)
+						throw inconsistent_function_range_exception("short relative jump into the overwritten prologue");
+					targets.push_back(offset);
+				}
+			}
+
+		public:
+			mutable vector<size_t> targets;
+
+		private:
+			const_byte_range _function_fragment, _moved;
+			size_t _overwritten_length;
+			vector<bool> _boundaries;
+		} v(function_fragment, moved, overwritten_length);
+
+		for (instruction_iterator<const byte> i(function_fragment); i.fetch(); )
+			if (*i.ptr() != 0xE8 /*call*/)
+				visit_instruction(v, i);
+		sort(v.targets.begin(), v.targets.end());
+		v.targets.erase(unique(v.targets.begin(), v.targets.end()), v.targets.end());
+		overwritten_targets.swap(v.targets);
+	}
 }
@@ -55,4 +55,11 @@ namespace micro_profiler
 
 	void jump_initialize(void *at, const void *target)
 	{	static_cast<assembler::jump *>(at)->init(target);	}
+
+	void jump_initialize(void *at, const void *target, const void *location)
+	{
+		const auto shift = static_cast<const byte *>(location) - static_cast<const byte *>(at);
+
+		static_cast<assembler::jump *>(at)->init(static_cast<const byte *>(target) - shift);
+	}
 }
@@ -0,0 +1,91 @@
+//	Copyright (c) 2011-2023 by Artem A. Gevorkyan (gevorkyan.org)
+//
+//	Permission is hereby granted, free of charge, to any person obtaining a copy
+//	of this software and associated documentation files (the "Software"), to deal
+//	in the Software without restriction, including without limitation the rights
+//	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+//	copies of the Software, and to permit persons to whom the Software is
+//	furnished to do so, subject to the following conditions:
+//
+//	The above copyright notice and this permission notice shall be included in
+//	all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+//	THE SOFTWARE.
+
+
+#include <patcher/live_write.h>
+
+#include <common/memory.h>
+#include <cstdint>
+
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace
+	{
+		const size_t c_cache_line_size = 64;
+		const byte c_park[] = {	0xEB, 0xFE,	}; // jmp $
+
+		void store_atomic(uint64_t *at, uint64_t value)
+		{
+#ifdef _MSC_VER
+			auto destination = reinterpret_cast<volatile long long *>(at);
+
+			for (auto expected = *destination;
+				_InterlockedCompareExchange64(destination, static_cast<long long>(value), expected) != expected;
+				expected = *destination)
+			{	}
+#else
+			__atomic_store_n(at, value, __ATOMIC_SEQ_CST);
+#endif
+		}
+
+		void store_atomic(byte *at, const byte *value)
+		{
+			uint16_t bits;
+
+			mem_copy(&bits, value, sizeof(bits));
+			*reinterpret_cast<volatile uint16_t *>(at) = bits;
+		}
+	}
+
+	void write_code(void *at, const void *replacement, size_t length)
+	{
+		const auto at_ = static_cast<byte *>(at);
+		const auto replacement_ = static_cast<const byte *>(replacement);
+		const auto offset = reinterpret_cast<size_t>(at_) & (sizeof(uint64_t) - 1);
+
+		if (offset + length <= sizeof(uint64_t))
+		{
+			const auto word = reinterpret_cast<uint64_t *>(at_ - offset);
+			uint64_t value = *word;
+
+			mem_copy(reinterpret_cast<byte *>(&value) + offset, replacement_, length);
+			store_atomic(word, value);
+		}
+		else if (c_cache_line_size - 1 != (reinterpret_cast<size_t>(at_) & (c_cache_line_size - 1)))
+		{
+			store_atomic(at_, c_park);
+			serialize_code_modifications();
+			mem_copy(at_ + sizeof(c_park), replacement_ + sizeof(c_park), length - sizeof(c_park));
+			serialize_code_modifications();
+			store_atomic(at_, replacement_);
+			serialize_code_modifications();
+		}
+		else
+		{
+			mem_copy(at_, replacement_, length); // A 2-byte store split across cache lines is not atomic.
+		}
+	}
+}
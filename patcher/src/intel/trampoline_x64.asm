@@ -19,9 +19,13 @@
 ;	THE SOFTWARE.
 
 .code
-	PUBLIC micro_profiler_trampoline_proto, micro_profiler_trampoline_proto_end
+	PUBLIC micro_profiler_trampoline_proto, micro_profiler_trampoline_proto_exit, micro_profiler_trampoline_proto_end
+	PUBLIC micro_profiler_count_trampoline_proto, micro_profiler_count_trampoline_proto_end
 
 	micro_profiler_trampoline_proto: ; argument passing: RCX, RDX, R8, and R9, <stack>
+		mov	r11, [enabled]
+		cmp	byte ptr [r11], 0
+		je		trampoline_proto_end ; paused: run the original code untouched
 		push	rcx
 		push	rdx
 		push	r8
@@ -60,16 +64,33 @@
 		sub	rsp, 028h
 		call	[on_exit]
 		add	rsp, 028h
-		mov	rcx, rax ; jump-as-return here
+		mov	rcx, rax ; return address
 		pop	r11
 		pop	r10
 		pop	rax
-		jmp	rcx
+	micro_profiler_trampoline_proto_exit:
+		push	rcx ; 'ret' pairs with the caller's 'call', keeping the return stack buffer balanced
+		ret
 
 		interceptor	dq	3141592600000001h
 		callee_id	dq	3141592600000002h
 		on_enter	dq	3141592600000003h
 		on_exit	dq	3141592600000004h
+		enabled	dq	314159260000000Ah
 	trampoline_proto_end:
 	micro_profiler_trampoline_proto_end:
+
+	; The count-only variant: increments the call counter and continues to the original code.
+	micro_profiler_count_trampoline_proto:
+		mov	r11, [count_enabled]
+		cmp	byte ptr [r11], 0
+		je		count_trampoline_proto_end
+		mov	r11, [counter]
+		lock inc	qword ptr [r11]
+		jmp	count_trampoline_proto_end
+
+		count_enabled	dq	314159260000000Ah
+		counter	dq	314159260000000Bh
+	count_trampoline_proto_end:
+	micro_profiler_count_trampoline_proto_end:
 end
@@ -19,11 +19,17 @@
 #	THE SOFTWARE.
 
 .text
-	.globl micro_profiler_trampoline_proto, micro_profiler_trampoline_proto_end
-	.globl _micro_profiler_trampoline_proto, _micro_profiler_trampoline_proto_end
+	.globl micro_profiler_trampoline_proto, micro_profiler_trampoline_proto_exit, micro_profiler_trampoline_proto_end
+	.globl _micro_profiler_trampoline_proto, _micro_profiler_trampoline_proto_exit, _micro_profiler_trampoline_proto_end
+	.globl micro_profiler_fast_trampoline_proto, micro_profiler_fast_trampoline_proto_end
+	.globl micro_profiler_count_trampoline_proto, micro_profiler_count_trampoline_proto_end
+	.globl _micro_profiler_count_trampoline_proto, _micro_profiler_count_trampoline_proto_end
 
 	micro_profiler_trampoline_proto:	# argument passing: RDI, RSI, RDX, RCX, R8, and R9, <stack>
 	_micro_profiler_trampoline_proto:
+		mov	$0x314159260000000A, %r11 # enable flag address
+		cmpb	$0x00, (%r11)
+		je		trampoline_proto_end # paused: run the original code untouched
 		push	%rdi
 		push	%rsi
 		push	%rdx
@@ -62,7 +68,134 @@
 		add	$0x88, %rsp
 		mov	%rax, %rcx # restore return address
 		pop	%rax
-		jmp	*%rcx
+	micro_profiler_trampoline_proto_exit:
+	_micro_profiler_trampoline_proto_exit:
+		push	%rcx # 'ret' pairs with the caller's 'call', keeping the return stack buffer balanced
+		ret
 	trampoline_proto_end:
 	micro_profiler_trampoline_proto_end:
 	_micro_profiler_trampoline_proto_end:
+
+	# The fast-path variant: the calling thread's trace is taken from a static TLS slot (5, thread pointer-relative);
+	# call records are written through its cursor (6 - record pointer, 7 - records left) and return entries are pushed
+	# onto its return stack (8 - top, 9 - limit) inline. The interceptor is only called when the thread has no trace
+	# yet, when a record would complete the buffer, on tail calls, on return stack growth and on unwinding.
+	micro_profiler_fast_trampoline_proto:
+		mov	$0x314159260000000A, %r11 # enable flag address
+		cmpb	$0x00, (%r11)
+		je		fast_trampoline_proto_end
+		mov	%fs:0x31415905, %r11
+		test	%r11, %r11
+		jz		fast_enter_slow
+		cmpl	$0x01, 0x31415907(%r11)
+		jbe	fast_enter_slow
+		mov	0x31415908(%r11), %r10
+		cmp	0x31415909(%r11), %r10
+		je		fast_enter_slow
+		cmp	%rsp, -0x10(%r10)
+		je		fast_enter_slow
+		mov	(%rsp), %rax
+		mov	%rsp, (%r10) # return_entry::stack_ptr
+		mov	%rax, 0x08(%r10) # return_entry::return_address
+		add	$0x10, %r10
+		mov	%r10, 0x31415908(%r11)
+		push	%rdx
+		rdtsc
+		shl	$0x20, %rdx
+		or		%rax, %rdx
+		mov	0x31415906(%r11), %r10
+		mov	%rdx, (%r10) # call_record::timestamp
+		mov	$0x3141592600000002, %rax
+		mov	%rax, 0x08(%r10) # call_record::callee
+		add	$0x10, %r10
+		mov	%r10, 0x31415906(%r11)
+		decl	0x31415907(%r11)
+		pop	%rdx
+		jmp	fast_enter_done
+
+	fast_enter_slow:
+		push	%rdi
+		push	%rsi
+		push	%rdx
+		push	%rcx
+		push	%r8
+		push	%r9
+		rdtsc
+		mov	$0x3141592600000001, %rdi # 1st argument, interceptor
+		lea	0x30(%rsp), %rsi # 2nd argument, stack_ptr
+		shl	$0x20, %rdx
+		or		%rax, %rdx # 3rd argument, timestamp
+		mov	$0x3141592600000002, %rcx # 4th argument, callee
+		mov	$0x3141592600000003, %rax # on_enter() address
+		sub	$0x88, %rsp
+		call	*%rax
+		add	$0x88, %rsp
+		pop	%r9
+		pop	%r8
+		pop	%rcx
+		pop	%rdx
+		pop	%rsi
+		pop	%rdi
+
+	fast_enter_done:
+		add	$0x08, %rsp
+		call	fast_trampoline_proto_end
+
+		push	%rax
+		push	%rdx
+		mov	%fs:0x31415905, %r11
+		test	%r11, %r11
+		jz		fast_exit_slow
+		cmpl	$0x01, 0x31415907(%r11)
+		jbe	fast_exit_slow
+		mov	0x31415908(%r11), %r10
+		lea	0x08(%rsp), %rax # stack_ptr
+		cmp	%rax, -0x20(%r10)
+		jbe	fast_exit_slow # Frames skipped by unwinding are to be popped as well.
+		sub	$0x10, %r10
+		mov	%r10, 0x31415908(%r11)
+		mov	0x08(%r10), %rcx # return address
+		rdtsc
+		shl	$0x20, %rdx
+		or		%rax, %rdx
+		mov	0x31415906(%r11), %r10
+		mov	%rdx, (%r10) # call_record::timestamp
+		movq	$0x00, 0x08(%r10) # call_record::callee
+		add	$0x10, %r10
+		mov	%r10, 0x31415906(%r11)
+		decl	0x31415907(%r11)
+		pop	%rdx
+		pop	%rax
+		push	%rcx
+		ret
+
+	fast_exit_slow:
+		pop	%rdx
+		rdtsc
+		mov	$0x3141592600000001, %rdi # 1st argument, interceptor
+		lea	(%rsp), %rsi # 2nd argument, stack_ptr
+		shl	$0x20, %rdx
+		or		%rax, %rdx # 3rd argument, timestamp
+		mov	$0x3141592600000004, %rax # on_exit() address
+		sub	$0x88, %rsp
+		call	*%rax
+		add	$0x88, %rsp
+		mov	%rax, %rcx # restore return address
+		pop	%rax
+		push	%rcx
+		ret
+	fast_trampoline_proto_end:
+	micro_profiler_fast_trampoline_proto_end:
+
+	# The count-only variant: increments the call counter (0x0B) and continues to the original code. No timestamps
+	# are taken and nothing is done on return.
+	micro_profiler_count_trampoline_proto:
+	_micro_profiler_count_trampoline_proto:
+		mov	$0x314159260000000A, %r11 # enable flag address
+		cmpb	$0x00, (%r11)
+		je		count_trampoline_proto_end
+		mov	$0x314159260000000B, %r11 # counter address
+		lock incq	(%r11)
+	count_trampoline_proto_end:
+	micro_profiler_count_trampoline_proto_end:
+	_micro_profiler_count_trampoline_proto_end:
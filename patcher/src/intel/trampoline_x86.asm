@@ -20,9 +20,12 @@
 
 .model flat
 .code
-	PUBLIC _micro_profiler_trampoline_proto, _micro_profiler_trampoline_proto_end
+	PUBLIC _micro_profiler_trampoline_proto, _micro_profiler_trampoline_proto_exit, _micro_profiler_trampoline_proto_end
+	PUBLIC _micro_profiler_count_trampoline_proto, _micro_profiler_count_trampoline_proto_end
 
 	_micro_profiler_trampoline_proto: ; fastcall argument passing: ECX, EDX, <stack>
+		cmp	byte ptr ds:[3141590Ah], 0 ; enable flag
+		je		trampoline_proto_end ; paused: run the original code untouched
 		push	eax ; some MS CRT functions accept arguments in EAX register...
 		push	ecx
 		push	edx
@@ -51,7 +54,20 @@
 	on_exit:
 		mov	ecx, eax
 		pop	eax
-		jmp	ecx ; jmp to return address instead of ret
+	_micro_profiler_trampoline_proto_exit:
+		push	ecx ; 'ret' pairs with the caller's 'call', keeping the return stack buffer balanced
+		ret
 	trampoline_proto_end:
 	_micro_profiler_trampoline_proto_end:
+
+	; The count-only variant: increments the 64-bit call counter (low, then carry into the high half) and continues to
+	; the original code.
+	_micro_profiler_count_trampoline_proto:
+		cmp	byte ptr ds:[3141590Ah], 0 ; enable flag
+		je		count_trampoline_proto_end
+		lock inc	dword ptr ds:[3141590Bh]
+		jnz	count_trampoline_proto_end
+		lock inc	dword ptr ds:[3141590Ch]
+	count_trampoline_proto_end:
+	_micro_profiler_count_trampoline_proto_end:
 end
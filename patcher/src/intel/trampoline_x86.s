@@ -19,11 +19,15 @@
 #	THE SOFTWARE.
 
 .text
-	.globl micro_profiler_trampoline_proto, micro_profiler_trampoline_proto_end
-	.globl _micro_profiler_trampoline_proto, _micro_profiler_trampoline_proto_end
+	.globl micro_profiler_trampoline_proto, micro_profiler_trampoline_proto_exit, micro_profiler_trampoline_proto_end
+	.globl _micro_profiler_trampoline_proto, _micro_profiler_trampoline_proto_exit, _micro_profiler_trampoline_proto_end
+	.globl micro_profiler_count_trampoline_proto, micro_profiler_count_trampoline_proto_end
+	.globl _micro_profiler_count_trampoline_proto, _micro_profiler_count_trampoline_proto_end
 
 	micro_profiler_trampoline_proto:	# argument passing: RDI, RSI, RDX, RCX, R8, and R9, <stack>
 	_micro_profiler_trampoline_proto:
+		cmpb	$0x00, 0x3141590A # enable flag
+		je		trampoline_proto_end # paused: run the original code untouched
 		push	%ecx
 		push	%edx
 		rdtsc
@@ -50,7 +54,24 @@
 	on_exit:
 		mov	%eax, %ecx # restore return address
 		pop	%eax
-		jmp	*%ecx
+	micro_profiler_trampoline_proto_exit:
+	_micro_profiler_trampoline_proto_exit:
+		push	%ecx # 'ret' pairs with the caller's 'call', keeping the return stack buffer balanced
+		ret
 	trampoline_proto_end:
 	micro_profiler_trampoline_proto_end:
 	_micro_profiler_trampoline_proto_end:
+
+	# The count-only variant: increments the 64-bit call counter (0x0B - low half, 0x0C - high half) and continues to
+	# the original code. The carry is propagated by a separate locked increment, so a concurrent reader may briefly
+	# see a count 2^32 behind.
+	micro_profiler_count_trampoline_proto:
+	_micro_profiler_count_trampoline_proto:
+		cmpb	$0x00, 0x3141590A # enable flag
+		je		count_trampoline_proto_end
+		lock incl	0x3141590B
+		jnz	count_trampoline_proto_end
+		lock incl	0x3141590C
+	count_trampoline_proto_end:
+	micro_profiler_count_trampoline_proto_end:
+	_micro_profiler_count_trampoline_proto_end:
@@ -25,6 +25,7 @@
 #include "replace.h"
 
 #include <common/memory.h>
+#include <cstdint>
 #include <patcher/exceptions.h>
 #include <patcher/instruction_iterator.h>
 #include <stdexcept>
@@ -36,6 +37,7 @@ namespace micro_profiler
 	namespace
 	{
 		const auto c_short_jump_size = static_cast<signed char>(sizeof(assembler::short_jump));
+		const size_t c_cache_line_size = 64;
 
 		template <typename T>
 		bool is_uniform(T *ptr, size_t n)
@@ -48,6 +50,16 @@ namespace micro_profiler
 			return true;
 		}
 
+		// The entry is switched with a single 16-bit store, so that a thread entering the function concurrently executes
+		// either of the instructions, but never a mix of their bytes.
+		void store_entry(byte *target, const assembler::short_jump &value)
+		{
+			uint16_t bits;
+
+			mem_copy(&bits, &value, sizeof(bits));
+			*reinterpret_cast<volatile uint16_t *>(target) = bits;
+		}
+
 		void VALIDATION_OVERRIDE(byte* instruction)
 		{
 			// Relative displacement operands at the start of the function are not supported yet.
@@ -74,6 +86,8 @@ namespace micro_profiler
 		: _target(static_cast<byte *>(target)), _active(0)
 	{
 		VALIDATION_OVERRIDE(_target);
+		if (c_cache_line_size - 1 == (reinterpret_cast<size_t>(_target) & (c_cache_line_size - 1)))
+			throw currently_prohibited(); // A store split across cache lines is not atomic.
 
 		instruction_iterator<const byte> ins(const_byte_range(_target, 15 /*max length of a single instruction*/));
 		const auto extra = static_cast<signed char>(ins.fetch() ? ins.length() : 0);
@@ -97,8 +111,12 @@ namespace micro_profiler
 	{
 		if (_active)
 			return false;
-		*reinterpret_cast<assembler::short_jump *>(_fuse_revert) = *reinterpret_cast<assembler::short_jump *>(_target);
-		reinterpret_cast<assembler::short_jump *>(_target)->init(prologue());
+		const assembler::short_jump divert = {
+			0xEB, static_cast<byte>(prologue() - (_target + c_short_jump_size))
+		};
+
+		mem_copy(_fuse_revert, _target, c_short_jump_size);
+		store_entry(_target, divert);
 		_active = -1;
 		return true;
 	}
@@ -107,7 +125,7 @@ namespace micro_profiler
 	{
 		if (!_active)
 			return false;
-		*reinterpret_cast<assembler::short_jump *>(_target) = *reinterpret_cast<assembler::short_jump *>(_fuse_revert);
+		store_entry(_target, *reinterpret_cast<const assembler::short_jump *>(_fuse_revert));
 		_active = 0;
 		return true;
 	}
@@ -20,24 +20,49 @@
 
 #include <patcher/translated_function_patch.h>
 
+#include "intel/jump.h"
+
 #include <patcher/binary_translation.h>
 #include <patcher/jump.h>
+#include <patcher/live_write.h>
 
 using namespace std;
 
 namespace micro_profiler
 {
+	translated_function_patch::translated_function_patch(void *target, size_t size, volatile count_t *counter,
+			executable_memory_allocator &allocator_)
+		: _target_function(after_landing_pad(target, size)), _active(false)
+	{
+		const auto at = layout(allocator_, c_count_trampoline_size); // enabled() is only valid after layout().
+
+		initialize_count_trampoline(at, counter, &enabled());
+	}
+
+	size_t translated_function_patch::max_size(size_t trampoline_size)
+	{	return trampoline_size + max_moved_length(c_jump_size) + c_jump_size + c_jump_size + 1;	}
+
+	size_t translated_function_patch::trampoline_size(const fast_trace_layout *fast_layout)
+	{	return fast_layout && c_fast_trampoline_size ? c_fast_trampoline_size : c_trampoline_size;	}
+
 	bool translated_function_patch::active() const
 	{	return _active;	}
 
 	bool translated_function_patch::activate()
 	{
-		const auto unused = _target_function.prefix(_prologue_size).suffix(c_jump_size);
+		assembler::jump divert;
 
 		if (active())
 			return false;
-		jump_initialize(_target_function.data(), _trampoline.get());
-		mem_set(unused.data(), 0xCC, unused.length());
+
+		// The jumps back into the bytes to be overwritten are retargeted to the moved instructions first.
+		for (auto i = _retargets.begin(); i != _retargets.end(); ++i)
+		{
+			offset_displaced_references(_references, _target_function.suffix(_prologue_size),
+				const_byte_range(_target_function.data() + i->first, 1), _trampoline.get() + i->second);
+		}
+		jump_initialize(&divert, _trampoline.get(), _target_function.data());
+		write_code(_target_function.data(), &divert, sizeof(divert));
 		_active = true;
 		return true;
 	}
@@ -46,38 +71,74 @@ namespace micro_profiler
 	{
 		if (!active())
 			return false;
-		mem_copy(_target_function.data(), _trampoline.get() + _prologue_backup_offset, _prologue_size);
+		write_code(_target_function.data(), _trampoline.get() + _prologue_backup_offset, c_jump_size);
+		for (auto i = _references.begin(); i != _references.end(); ++i)
+			i->restore();
+		_references.clear();
 		_active = false;
 		return true;
 	}
 
-	void translated_function_patch::init(executable_memory_allocator &allocator_, void *interceptor,
-		hooks<void>::on_enter_t *on_enter, hooks<void>::on_exit_t *on_exit)
+	bool translated_function_patch::pause(bool paused)
+	{
+		volatile byte &enabled_ = enabled();
+
+		if (!enabled_ == paused)
+			return false;
+		enabled_ = !paused;
+		return true;
+	}
+
+	byte_range translated_function_patch::after_landing_pad(void *target, size_t size)
+	{
+		const byte_range function(static_cast<byte *>(target), size);
+
+		return function.suffix(calculate_landing_pad_length(function));
+	}
+
+	void translated_function_patch::init(executable_memory_allocator &allocator_, const void *id, void *interceptor,
+		hooks<void>::on_enter_t *on_enter, hooks<void>::on_exit_t *on_exit, const fast_trace_layout *fast_layout)
+	{
+		const auto at = layout(allocator_, trampoline_size(fast_layout));
+
+		if (fast_layout && c_fast_trampoline_size)
+			initialize_fast_trampoline(at, id, interceptor, on_enter, on_exit, *fast_layout, &enabled());
+		else
+			initialize_trampoline(at, id, interceptor, on_enter, on_exit, &enabled());
+	}
+
+	byte *translated_function_patch::layout(executable_memory_allocator &allocator_, size_t trampoline_size)
 	{
 		if (_target_function.length() < c_jump_size)
 			throw inconsistent_function_range_exception("function to be patched is too small");
 
 		const auto moved_size = static_cast<byte>(calculate_fragment_length(_target_function, c_jump_size));
+		const auto moved = _target_function.prefix(moved_size);
 		const auto continuation = _target_function.suffix(moved_size);
+		vector<size_t> overwritten_targets, offsets;
 
-		validate_partial_function(continuation);
+		validate_partial_function(continuation, moved, c_jump_size, overwritten_targets);
 
-		_prologue_backup_offset = static_cast<byte>(c_trampoline_size + moved_size + c_jump_size);
-		const auto trampoline = static_pointer_cast<byte>(allocator_.allocate(_prologue_backup_offset + moved_size));
-		_trampoline = trampoline;
-		_prologue_size = moved_size;
-
-		auto ptr = trampoline.get();
-
-		initialize_trampoline(ptr, _target_function.data() /*id*/, interceptor, on_enter, on_exit);
-		ptr += c_trampoline_size;
+		const auto trampoline = static_pointer_cast<byte>(allocator_.allocate(trampoline_size
+			+ calculate_moved_length(moved) + c_jump_size + c_jump_size + 1));
+		auto ptr = trampoline.get() + trampoline_size;
 
-		move_function(ptr, _target_function.prefix(moved_size));
-		ptr += moved_size;
+		ptr += move_function(ptr, moved, &offsets);
 
 		jump_initialize(ptr, continuation.data());
 		ptr += c_jump_size;
 
-		mem_copy(ptr, _target_function.data(), _prologue_size);
+		// Only the jump is written over the prologue: the instructions past it are left for the jumps landing there.
+		mem_copy(ptr, _target_function.data(), c_jump_size);
+		_trampoline = trampoline;
+		_prologue_size = moved_size;
+		_prologue_backup_offset = static_cast<unsigned short>(ptr - trampoline.get());
+		for (auto i = overwritten_targets.begin(); i != overwritten_targets.end(); ++i)
+			_retargets.push_back(make_pair(static_cast<byte>(*i), static_cast<unsigned short>(trampoline_size + offsets[*i])));
+		enabled() = 1;
+		return trampoline.get();
 	}
+
+	volatile byte &translated_function_patch::enabled() const
+	{	return _trampoline.get()[_prologue_backup_offset + c_jump_size];	}
 }
@@ -263,7 +263,7 @@ namespace micro_profiler
 			}
 
 
-			test( ImagesWithExternalShortJumpsCannotBeMoved )
+			test( ExternalShortJumpsAreWidenedToNearOnesWhenMoved )
 			{
 				// INIT
 				byte instructions[0x0400] = {
@@ -274,12 +274,19 @@ namespace micro_profiler
 				};
 
 				// ACT / ASSERT
-				assert_throws(move_function(instructions + 0x30, const_byte_range(instructions, 2)),
-					inconsistent_function_range_exception);
+				assert_equal(5u, move_function(instructions + 0x30, const_byte_range(instructions, 2)));
+				assert_equal(10u, move_function(instructions + 0x40, const_byte_range(instructions + 4, 4)));
+
+				// ASSERT
+				byte reference1[] = {	0xE9, 0xCF, 0xFF, 0xFF, 0xFF,	};
+				byte reference2[] = {	0xE9, 0xBA, 0xFF, 0xFF, 0xFF, 0xE9, 0xB3, 0xFF, 0xFF, 0xFF,	};
+
+				assert_equal(reference1, const_byte_range(instructions + 0x30, 5));
+				assert_equal(reference2, const_byte_range(instructions + 0x40, 10));
 			}
 
 
-			test( ImagesWithExternalShortConditionalJumpsCannotBeMoved )
+			test( ExternalShortConditionalJumpsAreWidenedToNearOnesWhenMoved )
 			{
 				// INIT
 				byte instructions[0x0400] = {
@@ -287,42 +294,206 @@ namespace micro_profiler
 					0x78, 0x0E, 0x79, 0x0C, 0x7A, 0x0A, 0x7B, 0x08, 0x7C, 0x06, 0x7D, 0x04, 0x7E, 0x02, 0x7F, 0x00,
 				};
 
+				for (byte i = 0; i != 0x10; ++i)
+				{
 				// ACT / ASSERT
-				assert_throws(move_function(instructions + 0x30, const_byte_range(instructions, 2)),
-					inconsistent_function_range_exception);
-				assert_throws(move_function(instructions + 0x30, const_byte_range(instructions + 2, 2)),
-					inconsistent_function_range_exception);
-				assert_throws(move_function(instructions + 0x30, const_byte_range(instructions + 4, 2)),
-					inconsistent_function_range_exception);
-				assert_throws(move_function(instructions + 0x30, const_byte_range(instructions + 6, 2)),
-					inconsistent_function_range_exception);
-				assert_throws(move_function(instructions + 0x30, const_byte_range(instructions + 8, 2)),
-					inconsistent_function_range_exception);
-				assert_throws(move_function(instructions + 0x30, const_byte_range(instructions + 10, 2)),
-					inconsistent_function_range_exception);
-				assert_throws(move_function(instructions + 0x30, const_byte_range(instructions + 12, 2)),
-					inconsistent_function_range_exception);
-				assert_throws(move_function(instructions + 0x30, const_byte_range(instructions + 14, 2)),
-					inconsistent_function_range_exception);
-				assert_throws(move_function(instructions + 0x30, const_byte_range(instructions + 16, 2)),
-					inconsistent_function_range_exception);
-				assert_throws(move_function(instructions + 0x30, const_byte_range(instructions + 18, 2)),
-					inconsistent_function_range_exception);
-				assert_throws(move_function(instructions + 0x30, const_byte_range(instructions + 20, 2)),
-					inconsistent_function_range_exception);
-				assert_throws(move_function(instructions + 0x30, const_byte_range(instructions + 22, 2)),
-					inconsistent_function_range_exception);
-				assert_throws(move_function(instructions + 0x30, const_byte_range(instructions + 24, 2)),
-					inconsistent_function_range_exception);
-				assert_throws(move_function(instructions + 0x30, const_byte_range(instructions + 26, 2)),
-					inconsistent_function_range_exception);
-				assert_throws(move_function(instructions + 0x30, const_byte_range(instructions + 28, 2)),
-					inconsistent_function_range_exception);
-				assert_throws(move_function(instructions + 0x30, const_byte_range(instructions + 30, 2)),
+					assert_equal(6u, move_function(instructions + 0x30, const_byte_range(instructions + 2 * i, 2)));
+
+				// ASSERT
+					byte reference[] = {	0x0F, static_cast<byte>(0x80 + i), 0xEA, 0xFF, 0xFF, 0xFF,	};
+
+					assert_equal(reference, const_byte_range(instructions + 0x30, 6));
+				}
+			}
+
+
+			test( InnerJumpsAreRetargetedAccordingToWidenedInstructions )
+			{
+				// INIT
+				byte instructions[0x0400] = {
+					0xEB, 0x02,	// jmp +2 (inner)
+					0x74, 0x0E,	// je +0x0E (external)
+					0x90,
+				};
+				vector<size_t> offsets;
+
+				// ACT
+				assert_equal(9u, move_function(instructions + 0x30, const_byte_range(instructions, 5), &offsets));
+
+				// ASSERT
+				byte reference[] = {	0xEB, 0x06, 0x0F, 0x84, 0xDA, 0xFF, 0xFF, 0xFF, 0x90,	};
+				size_t reference_offsets[] = {
+					0, c_not_an_instruction, 2, c_not_an_instruction, 8, 9,
+				};
+
+				assert_equal(reference, const_byte_range(instructions + 0x30, 9));
+				assert_equal(reference_offsets, offsets);
+			}
+
+
+			test( InnerShortJumpsThatCannotReachTheirMovedTargetsProhibitMoving )
+			{
+				// INIT
+				byte instructions[0x0400] = {};
+				const auto source = instructions + 0x100;
+
+				source[0] = 0xEB, source[1] = 0x7E, source[0x80] = 0x90;
+				for (auto i = 2; i != 0x80; i += 2)
+					source[i] = 0x74, source[i + 1] = 0x80; // External, but the last one.
+
+				// ACT / ASSERT
+				assert_throws(move_function(instructions + 0x300, const_byte_range(source, 0x81)),
 					inconsistent_function_range_exception);
 			}
 
 
+			test( UpperBoundOfMovedLengthAccountsForWidenedJumps )
+			{
+				// INIT
+				byte instructions[] = {
+					0xEB, 0x02, 0x74, 0x10, 0x90, 0xE9, 0x00, 0x00, 0x00, 0x00,
+				};
+
+				// ACT / ASSERT
+				assert_equal(5u, calculate_moved_length(const_byte_range(instructions, 2)));
+				assert_equal(2u + 6u + 1u + 5u, calculate_moved_length(mkrange(instructions)));
+				assert_equal(5u, calculate_moved_length(const_byte_range(instructions + 5, 5)));
+			}
+
+
+			test( UpperBoundOfMovedLengthHoldsForAnyPrologue )
+			{
+				// INIT
+				byte jumps[] = {	0x74, 0x40, 0x75, 0x40, 0x76, 0x40, 0x90,	};
+				byte mixed[] = {	0x90, 0x74, 0x40, 0x55, 0x0F, 0x84, 0x40, 0x00, 0x00, 0x00,	};
+				const auto jumps_prologue = const_byte_range(jumps, calculate_fragment_length(mkrange(jumps), 5));
+				const auto mixed_prologue = const_byte_range(mixed, calculate_fragment_length(mkrange(mixed), 5));
+
+				// ACT / ASSERT
+				assert_equal(6u, jumps_prologue.length());
+				assert_equal(18u, calculate_moved_length(jumps_prologue));
+				assert_is_true(calculate_moved_length(jumps_prologue) <= max_moved_length(5));
+				assert_equal(10u, mixed_prologue.length());
+				assert_is_true(calculate_moved_length(mixed_prologue) <= max_moved_length(5));
+				assert_is_true(15u <= max_moved_length(1));
+			}
+
+
+			test( LandingPadIsRecognizedAtTheEntry )
+			{
+				// INIT
+				byte endbr64[] = {	0xF3, 0x0F, 0x1E, 0xFA, 0x55,	};
+				byte endbr32[] = {	0xF3, 0x0F, 0x1E, 0xFB,	};
+				byte other1[] = {	0xF3, 0x0F, 0x1E, 0xFC, 0x55,	};
+				byte other2[] = {	0x55, 0xF3, 0x0F, 0x1E, 0xFA,	};
+
+				// ACT / ASSERT
+				assert_equal(4u, calculate_landing_pad_length(mkrange(endbr64)));
+				assert_equal(4u, calculate_landing_pad_length(mkrange(endbr32)));
+				assert_equal(0u, calculate_landing_pad_length(const_byte_range(endbr64, 3)));
+				assert_equal(0u, calculate_landing_pad_length(mkrange(other1)));
+				assert_equal(0u, calculate_landing_pad_length(mkrange(other2)));
+			}
+
+#if defined(_M_X64) || defined(__x86_64__)
+
+			test( RipBasedOperandsAreReoffsetWhenMoved )
+			{
+				// INIT
+				byte instructions[0x0400] = {};
+				byte source[] = {
+					0x48, 0x8B, 0x05, 0xF0, 0x00, 0x00, 0x00,	// mov rax, [rip + 0xF0]
+					0x83, 0x3D, 0x10, 0x00, 0x00, 0x00, 0x05,	// cmp dword ptr [rip + 0x10], 5
+				};
+
+				mem_copy(instructions + 0x10, source, sizeof(source));
+
+				// ACT / ASSERT
+				assert_is_true(14u <= calculate_moved_length(const_byte_range(instructions + 0x10, 14)));
+				assert_equal(14u, move_function(instructions + 0x200, const_byte_range(instructions + 0x10, 14)));
+
+				// ASSERT
+				byte reference[] = {
+					0x48, 0x8B, 0x05, 0x00, 0xFF, 0xFF, 0xFF,
+					0x83, 0x3D, 0x20, 0xFE, 0xFF, 0xFF, 0x05,
+				};
+
+				assert_equal(reference, const_byte_range(instructions + 0x200, 14));
+			}
+
+
+			test( RipBasedLoadsAreRewrittenThroughLiteralsWhenTheirTargetsGetOutOfReach )
+			{
+				// INIT
+				byte instructions[0x0400] = {};
+				byte lea64[] = {	0x48, 0x8D, 0x05, 0xF0, 0xFF, 0xFF, 0x7F,	}; // lea rax, [rip + 0x7FFFFFF0]
+				byte lea32[] = {	0x44, 0x8D, 0x0D, 0xF0, 0xFF, 0xFF, 0x7F,	}; // lea r9d, [rip + 0x7FFFFFF0]
+				byte mov64[] = {	0x4C, 0x8B, 0x25, 0xF0, 0xFF, 0xFF, 0x7F,	}; // mov r12, [rip + 0x7FFFFFF0]
+				byte mov32[] = {	0x8B, 0x2D, 0xF0, 0xFF, 0xFF, 0x7F,	}; // mov ebp, [rip + 0x7FFFFFF0]
+				const auto source = instructions + 0x300;
+				const auto destination = instructions + 0x10;
+				const byte *target;
+
+				// INIT / ACT
+				mem_copy(source, lea64, sizeof(lea64));
+				target = source + sizeof(lea64) + 0x7FFFFFF0;
+
+				// ACT / ASSERT
+				assert_equal(10u, calculate_moved_length(const_byte_range(source, sizeof(lea64))));
+				assert_equal(10u, move_function(destination, const_byte_range(source, sizeof(lea64))));
+
+				// ASSERT
+				assert_equal(0x48, destination[0]);
+				assert_equal(0xB8, destination[1]);
+				assert_equal(target, *reinterpret_cast<const byte * const *>(destination + 2));
+
+				// INIT / ACT
+				mem_copy(source, lea32, sizeof(lea32));
+				target = source + sizeof(lea32) + 0x7FFFFFF0;
+
+				// ACT / ASSERT
+				assert_equal(6u, move_function(destination, const_byte_range(source, sizeof(lea32))));
+
+				// ASSERT
+				assert_equal(0x41, destination[0]);
+				assert_equal(0xB9, destination[1]);
+				assert_equal(static_cast<unsigned>(reinterpret_cast<size_t>(target)),
+					*reinterpret_cast<const unsigned *>(destination + 2));
+
+				// INIT / ACT
+				mem_copy(source, mov64, sizeof(mov64));
+				target = source + sizeof(mov64) + 0x7FFFFFF0;
+
+				// ACT / ASSERT
+				assert_equal(14u, calculate_moved_length(const_byte_range(source, sizeof(mov64))));
+				assert_equal(14u, move_function(destination, const_byte_range(source, sizeof(mov64))));
+
+				// ASSERT
+				byte reference3[] = {	0x4D, 0x8B, 0x24, 0x24,	}; // mov r12, [r12]
+
+				assert_equal(0x49, destination[0]);
+				assert_equal(0xBC, destination[1]);
+				assert_equal(target, *reinterpret_cast<const byte * const *>(destination + 2));
+				assert_equal(reference3, const_byte_range(destination + 10, 4));
+
+				// INIT / ACT
+				mem_copy(source, mov32, sizeof(mov32));
+				target = source + sizeof(mov32) + 0x7FFFFFF0;
+
+				// ACT / ASSERT
+				assert_equal(13u, move_function(destination, const_byte_range(source, sizeof(mov32))));
+
+				// ASSERT
+				byte reference4[] = {	0x8B, 0x6D, 0x00,	}; // mov ebp, [rbp + 0]
+
+				assert_equal(0x48, destination[0]);
+				assert_equal(0xBD, destination[1]);
+				assert_equal(target, *reinterpret_cast<const byte * const *>(destination + 2));
+				assert_equal(reference4, const_byte_range(destination + 10, 3));
+			}
+
+#endif
+
 			test( ImagesWithInnerShortJumpsCanBeMoved )
 			{
 				// INIT
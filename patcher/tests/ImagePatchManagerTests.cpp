@@ -1,9 +1,12 @@
 #include <patcher/image_patch_manager.h>
 
+#include "guineapigs.h"
 #include "helpers.h"
 #include "mocks.h"
 
 #include <common/smart_ptr.h>
+#include <patcher/exceptions.h>
+#include <common/module.h>
 #include <test-helpers/comparisons.h>
 #include <test-helpers/helpers.h>
 #include <tuple>
@@ -123,7 +126,7 @@ namespace micro_profiler
 			}
 
 
-			test( PatchCreationIsRequestedAtOffsetLockedBaseOnApply )
+			test( PatchesAreCreatedAtOffsetLockedBaseAndActivatedAfterAllAreCreatedOnApply )
 			{
 				// INIT
 				auto ea1 = make_shared<executable_memory_allocator>();
@@ -166,10 +169,10 @@ namespace micro_profiler
 					+ make_tuple(3u, 98321u, ea1.get()), targets);
 				assert_equal(plural
 					+ make_pair((void*)(0x1910221 + 0x10010), 0)
-					+ make_pair((void*)(0x1910221 + 0x10010), 1)
 					+ make_pair((void*)(0x1910221 + 0x100210), 0)
-					+ make_pair((void*)(0x1910221 + 0x100210), 1)
 					+ make_pair((void*)(0x1910221 + 0x9910), 0)
+					+ make_pair((void*)(0x1910221 + 0x10010), 1)
+					+ make_pair((void*)(0x1910221 + 0x100210), 1)
 					+ make_pair((void*)(0x1910221 + 0x9910), 1), targets2);
 				assert_equal(plural
 					+ make_patch_apply(0x10010, patch_change_result::ok, 1)
@@ -201,8 +204,8 @@ namespace micro_profiler
 					+ make_tuple(5u, 100000u, ea2.get()), targets);
 				assert_equal(plural
 					+ make_pair((void*)(0x1000 + 0x13), 0)
-					+ make_pair((void*)(0x1000 + 0x13), 1)
 					+ make_pair((void*)(0x1000 + 0x02), 0)
+					+ make_pair((void*)(0x1000 + 0x13), 1)
 					+ make_pair((void*)(0x1000 + 0x02), 1), targets2);
 				assert_equal(plural
 					+ make_patch_apply(0x13, patch_change_result::ok, 4)
@@ -414,12 +417,12 @@ namespace micro_profiler
 				// ASSERT
 				assert_equal(plural
 					+ make_pair((void*)(0x1910221 + 0x10001), 0)
-					+ make_pair((void*)(0x1910221 + 0x10001), 1)
 					+ make_pair((void*)(0x1910221 + 0x10002), 0)
-					+ make_pair((void*)(0x1910221 + 0x10002), 1)
 					+ make_pair((void*)(0x1910221 + 0x10003), 0)
-					+ make_pair((void*)(0x1910221 + 0x10003), 1)
 					+ make_pair((void*)(0x1910221 + 0x10004), 0)
+					+ make_pair((void*)(0x1910221 + 0x10001), 1)
+					+ make_pair((void*)(0x1910221 + 0x10002), 1)
+					+ make_pair((void*)(0x1910221 + 0x10003), 1)
 					+ make_pair((void*)(0x1910221 + 0x10004), 1), targets);
 				assert_equal(plural
 					+ make_patch_apply(0x10001, patch_change_result::ok, 1)
@@ -1372,6 +1375,447 @@ namespace micro_profiler
 					+ make_patch_apply(0x20001, patch_change_result::activation_error, 2)
 					+ make_patch_apply(0x30002, patch_change_result::activation_error, 3), results);
 			}
+
+			test( PausingIsForwardedToCreatedPatchesWithoutLockingTheModule )
+			{
+				// INIT
+				vector< pair<void *, int /*act*/> > targets;
+				patch_manager::patch_states states;
+				auto locks = 0;
+				auto pm = make_shared<image_patch_manager_overriden>([&] (void *target, size_t, id_t, executable_memory_allocator &) {
+					return unique_ptr<patch>(new mocks::patch([&] (void *target, int act) {
+						targets.push_back(make_pair(target, act));
+					}, target));
+				}, mappings, memory_manager_);
+				patch_manager::apply_request functions1[] = {
+					make_pair(10u, 0u), make_pair(20u, 0u), make_pair(30u, 0u),
+				};
+				unsigned functions2[] = {	20u, 30u, 40u,	};
+				unsigned functions3[] = {	30u,	};
+
+				pm->on_lock_module = [&] (id_t /*module_id*/) {
+					return locks++, make_shared_copy(make_mapping((void*)0x10000000, ""));
+				};
+				pm->apply(results, 13u, mkrange(functions1));
+				targets.clear();
+				locks = 0;
+
+				// ACT
+				pm->pause(results, 13u, mkrange(functions2), true);
+
+				// ASSERT
+				assert_equal(0, locks);
+				assert_equal(plural
+					+ make_pair((void*)(0x10000000 + 20), 4)
+					+ make_pair((void*)(0x10000000 + 30), 4), targets);
+				assert_equal(plural
+					+ make_patch_apply(20u, patch_change_result::ok, 2)
+					+ make_patch_apply(30u, patch_change_result::ok, 3)
+					+ make_patch_apply(40u, patch_change_result::unchanged, 0), results);
+
+				// INIT
+				targets.clear();
+
+				// ACT
+				pm->pause(results, 13u, mkrange(functions2), true);
+
+				// ASSERT
+				assert_is_empty(targets);
+				assert_equal(plural
+					+ make_patch_apply(20u, patch_change_result::unchanged, 2)
+					+ make_patch_apply(30u, patch_change_result::unchanged, 3)
+					+ make_patch_apply(40u, patch_change_result::unchanged, 0), results);
+
+				// ACT
+				pm->pause(results, 13u, mkrange(functions3), false);
+
+				// ASSERT
+				assert_equal(0, locks);
+				assert_equal(plural
+					+ make_pair((void*)(0x10000000 + 30), 5), targets);
+				assert_equal(plural
+					+ make_patch_apply(30u, patch_change_result::ok, 3), results);
+
+				// ACT
+				pm->query(states, 13u);
+
+				// ASSERT
+				assert_equivalent_pred(plural
+					+ make_patch_state(10u, patch_state::active, 1)
+					+ make_patch_state(20u, patch_state::active, 2)
+					+ make_patch_state(30u, patch_state::active, 3), states, less());
+			}
+
+
+			test( PendingPatchPausedBeforeMappingIsCreatedPaused )
+			{
+				// INIT
+				vector< pair<void *, int /*act*/> > targets;
+				auto pm = make_shared<image_patch_manager>([&] (void *target, size_t, id_t, executable_memory_allocator &) {
+					return unique_ptr<patch>(new mocks::patch([&] (void *target, int act) {
+						targets.push_back(make_pair(target, act));
+					}, target));
+				}, mappings, memory_manager_);
+				patch_manager::apply_request functions[] = {	make_pair(0x10002u, 0u),	};
+				unsigned pfunctions[] = {	0x10002u,	};
+
+				pm->apply(results, 1u, mkrange(functions));
+
+				// ACT
+				pm->pause(results, 1u, mkrange(pfunctions), true);
+
+				// ASSERT
+				assert_is_empty(targets);
+				assert_equal(plural
+					+ make_patch_apply(0x10002, patch_change_result::ok, 1), results);
+
+				// INIT
+				mappings.on_lock_mapping = [&] (id_t) {
+					return make_shared_copy(make_mapping((void*)0x10000000, ""));
+				};
+
+				// ACT
+				mappings.subscription->mapped(1u, 100u, make_mapping((void *)0x10000000, ""));
+
+				// ASSERT
+				assert_equal(plural
+					+ make_pair((void*)(0x10000000 + 0x10002), 0)
+					+ make_pair((void*)(0x10000000 + 0x10002), 4)
+					+ make_pair((void*)(0x10000000 + 0x10002), 1), targets);
+			}
+
+			test( CountOnlyPatchesAreCreatedByCounterFactoryAndTheirCountersAreRead )
+			{
+				// INIT
+				vector< pair<void *, int /*act*/> > targets;
+				vector<volatile count_t *> counters;
+				patch_manager::patch_counters read;
+				auto pm = make_shared<image_patch_manager>([&] (void *target, size_t, id_t, executable_memory_allocator &) {
+					return unique_ptr<patch>(new mocks::patch([&] (void *target, int act) {
+						targets.push_back(make_pair(target, act + 10));
+					}, target));
+				}, mappings, memory_manager_, [&] (void *target, size_t, volatile count_t *counter, executable_memory_allocator &) {
+					counters.push_back(counter);
+					return unique_ptr<patch>(new mocks::patch([&] (void *target, int act) {
+						targets.push_back(make_pair(target, act));
+					}, target));
+				});
+				patch_manager::apply_request functions[] = {	make_pair(0x100u, 0u), make_pair(0x200u, 0u),	};
+				unsigned rfunctions[] = {	0x200u,	};
+
+				mappings.on_lock_mapping = [&] (id_t) {
+					return make_shared_copy(make_mapping((void*)0x10000000, ""));
+				};
+				mappings.subscription->mapped(1u, 100u, make_mapping((void *)0x10000000, ""));
+
+				// ACT
+				pm->apply_counters(results, 1u, mkrange(functions));
+
+				// ASSERT
+				assert_equal(plural
+					+ make_pair((void*)0x10000100, 0)
+					+ make_pair((void*)0x10000200, 0)
+					+ make_pair((void*)0x10000100, 1)
+					+ make_pair((void*)0x10000200, 1), targets);
+				assert_equal(plural
+					+ make_patch_apply(0x100, patch_change_result::ok, 1)
+					+ make_patch_apply(0x200, patch_change_result::ok, 2), results);
+				assert_equal(2u, counters.size());
+				assert_not_equal(counters[0], counters[1]);
+
+				// INIT
+				*counters[0] = 13;
+				*counters[1] = 191;
+
+				// ACT
+				pm->read_counters(read);
+
+				// ASSERT
+				assert_equal(2u, read.size());
+				assert_equal(0x100u, read[0].rva);
+				assert_equal(13u, read[0].calls);
+				assert_equal(0x200u, read[1].rva);
+				assert_equal(191u, read[1].calls);
+
+				// INIT
+				targets.clear();
+
+				// ACT
+				pm->apply(results, 1u, mkrange(functions));
+
+				// ASSERT
+				assert_is_empty(targets);
+				assert_equal(plural
+					+ make_patch_apply(0x100, patch_change_result::unchanged, 1)
+					+ make_patch_apply(0x200, patch_change_result::unchanged, 2), results);
+
+				// ACT (a reverted count-only patch is rebuilt in the profiling mode, keeping the count)
+				pm->revert(results, 1u, mkrange(rfunctions));
+				pm->apply(results, 1u, mkrange(functions));
+				pm->read_counters(read);
+
+				// ASSERT
+				assert_equal(plural
+					+ make_pair((void*)0x10000200, 2)
+					+ make_pair((void*)0x10000200, 10)
+					+ make_pair((void*)0x10000200, 11), targets);
+				assert_equal(2u, read.size());
+				assert_equal(191u, read[1].calls);
+			}
+
+
+			test( CountOnlyPatchesAreUnrecoverableWithoutCounterFactory )
+			{
+				// INIT
+				auto pm = make_shared<image_patch_manager>([&] (void *target, size_t, id_t, executable_memory_allocator &) {
+					return unique_ptr<patch>(new mocks::patch([&] (void *, int) {	}, target));
+				}, mappings, memory_manager_);
+				patch_manager::apply_request functions[] = {	make_pair(0x100u, 0u),	};
+				patch_manager::patch_counters read;
+
+				mappings.on_lock_mapping = [&] (id_t) {
+					return make_shared_copy(make_mapping((void*)0x10000000, ""));
+				};
+				mappings.subscription->mapped(1u, 100u, make_mapping((void *)0x10000000, ""));
+
+				// ACT
+				pm->apply_counters(results, 1u, mkrange(functions));
+				pm->read_counters(read);
+
+				// ASSERT
+				assert_equal(plural
+					+ make_patch_apply(0x100, patch_change_result::unrecoverable_error, 1), results);
+				assert_is_empty(read);
+			}
+
+			test( PatchOfPreviousModeIsKeptUntilUnmappingAndReusedOnSwitchingBack )
+			{
+				// INIT
+				vector< pair<void *, int /*act*/> > targets;
+				auto pm = make_shared<image_patch_manager>([&] (void *target, size_t, id_t, executable_memory_allocator &) {
+					return unique_ptr<patch>(new mocks::patch([&] (void *target, int act) {
+						targets.push_back(make_pair(target, act + 10));
+					}, target));
+				}, mappings, memory_manager_, [&] (void *target, size_t, volatile count_t *, executable_memory_allocator &) {
+					return unique_ptr<patch>(new mocks::patch([&] (void *target, int act) {
+						targets.push_back(make_pair(target, act));
+					}, target));
+				});
+				patch_manager::apply_request functions[] = {	make_pair(0x100u, 0u),	};
+				unsigned rfunctions[] = {	0x100u,	};
+
+				mappings.on_lock_mapping = [&] (id_t) {
+					return make_shared_copy(make_mapping((void*)0x10000000, ""));
+				};
+				mappings.subscription->mapped(1u, 100u, make_mapping((void *)0x10000000, ""));
+				pm->apply(results, 1u, mkrange(functions));
+				pm->revert(results, 1u, mkrange(rfunctions));
+				targets.clear();
+
+				// ACT
+				pm->apply_counters(results, 1u, mkrange(functions));
+				pm->revert(results, 1u, mkrange(rfunctions));
+				pm->pause(results, 1u, mkrange(rfunctions), true);
+
+				// ASSERT (the reverted profiling patch and its trampoline are not destroyed)
+				assert_equal(plural
+					+ make_pair((void*)0x10000100, 0)
+					+ make_pair((void*)0x10000100, 1)
+					+ make_pair((void*)0x10000100, 2)
+					+ make_pair((void*)0x10000100, 4)
+					+ make_pair((void*)0x10000100, 14), targets);
+
+				// INIT
+				targets.clear();
+
+				// ACT
+				pm->apply(results, 1u, mkrange(functions));
+
+				// ASSERT
+				assert_equal(plural
+					+ make_pair((void*)0x10000100, 11), targets);
+				assert_equal(plural
+					+ make_patch_apply(0x100, patch_change_result::ok, 1), results);
+
+				// INIT
+				targets.clear();
+
+				// ACT
+				mappings.subscription->unmapped(100u);
+
+				// ASSERT
+				assert_equal(plural
+					+ make_pair((void*)0x10000100, 13)
+					+ make_pair((void*)0x10000100, 3), targets);
+			}
+
+
+			test( CoverageOfPatchedFunctionsIsAccountedPerModuleAndResetOnRemapping )
+			{
+				// INIT
+				auto pm = make_shared<image_patch_manager>([&] (void *target, size_t, id_t, executable_memory_allocator &) {
+					if (target == (void*)(0x10000000 + 0x10002) || target == (void*)(0x10000000 + 0x30002))
+						throw runtime_error("function is too small");
+					if (target == (void*)(0x10000000 + 0x40000))
+						throw runtime_error("debug interrupt met");
+					return unique_ptr<patch>(new mocks::patch([] (void *, int) {	}, target));
+				}, mappings, memory_manager_);
+				patch_manager::apply_request functions1[] = {
+					make_pair(0x20001u, 0u), make_pair(0x10002u, 0u), make_pair(0x30002u, 0u),
+				};
+				patch_manager::apply_request functions2[] = {
+					make_pair(0x40000u, 0u), make_pair(0x50000u, 0u),
+				};
+
+				mappings.on_lock_mapping = [&] (id_t) {
+					return make_shared_copy(make_mapping((void*)0x10000000, ""));
+				};
+
+				mappings.subscription->mapped(1u, 100u, make_mapping((void *)0x10000000, ""));
+				mappings.subscription->mapped(2u, 101u, make_mapping((void *)0x20000000, ""));
+
+				// ACT
+				auto c = pm->get_coverage(1);
+
+				// ASSERT
+				assert_equal(0u, c.translated);
+				assert_equal(0u, c.unpatchable);
+				assert_is_empty(c.reasons);
+
+				// ACT
+				pm->apply(results, 1u, mkrange(functions1));
+				pm->apply(results, 1u, mkrange(functions2));
+				c = pm->get_coverage(1);
+
+				// ASSERT
+				assert_equal(2u, c.translated);
+				assert_equal(0u, c.sled);
+				assert_equal(3u, c.unpatchable);
+				assert_equal(2u, c.reasons.size());
+				assert_equal(1u, c.reasons["debug interrupt met"]);
+				assert_equal(2u, c.reasons["function is too small"]);
+
+				// ACT
+				c = pm->get_coverage(2);
+
+				// ASSERT
+				assert_equal(0u, c.translated);
+				assert_equal(0u, c.unpatchable);
+
+				// ACT
+				mappings.subscription->unmapped(100u);
+				mappings.subscription->mapped(1u, 102u, make_mapping((void *)0x10000000, ""));
+				c = pm->get_coverage(1);
+
+				// ASSERT
+				assert_equal(2u, c.translated);
+				assert_equal(0u, c.unpatchable);
+				assert_is_empty(c.reasons);
+			}
+
+#ifdef __linux__
+			test( FunctionsHavingNOPSledsArePatchedBySledFactory )
+			{
+				// INIT
+				const auto this_module = module::platform().locate(address_cast_hack<const void *>(&recursive_factorial));
+				const auto rva = [&] (const void *function) {
+					return static_cast<unsigned>(static_cast<const byte *>(function) - this_module.base);
+				};
+				vector< tuple<char, void *, id_t> > created;
+				auto pm = make_shared<image_patch_manager>([&] (void *target, size_t, id_t id, executable_memory_allocator &) {
+					created.push_back(make_tuple('t', target, id));
+					return unique_ptr<patch>(new mocks::patch([] (void *, int) {	}, target));
+				}, mappings, memory_manager_, image_patch_manager::counter_patch_factory(),
+					[&] (void *target, id_t id, executable_memory_allocator &) {
+
+					created.push_back(make_tuple('s', target, id));
+					return unique_ptr<patch>(new mocks::patch([] (void *, int) {	}, target));
+				});
+				const auto sledded = rva(address_cast_hack<const void *>(&recursive_factorial));
+				const auto plain = rva(address_cast_hack<const void *>(&make_patch_state));
+				patch_manager::apply_request functions[] = {	make_pair(sledded, 0u), make_pair(plain, 0u),	};
+
+				mappings.on_lock_mapping = [&] (id_t) {
+					return make_shared_copy(make_mapping(this_module.base, this_module.path));
+				};
+
+				// guineapigs.cpp is built with -fpatchable-function-entry=14,12.
+				mappings.subscription->mapped(1u, 100u, make_mapping(this_module.base, this_module.path));
+
+				// ACT
+				pm->apply(results, 1u, mkrange(functions));
+
+				// ASSERT
+				assert_equal(plural
+					+ make_tuple('s', static_cast<void *>(this_module.base + sledded), 1u)
+					+ make_tuple('t', static_cast<void *>(this_module.base + plain), 2u), created);
+			}
+
+
+			test( OnlyFunctionsPrecededByNothingButSledNOPsArePatchedBySledFactory )
+			{
+				// INIT
+				const auto this_module = module::platform().locate(address_cast_hack<const void *>(&recursive_factorial));
+				vector<char> created;
+				auto pm = make_shared<image_patch_manager>([&] (void *target, size_t, id_t, executable_memory_allocator &) {
+					created.push_back('t');
+					return unique_ptr<patch>(new mocks::patch([] (void *, int) {	}, target));
+				}, mappings, memory_manager_, image_patch_manager::counter_patch_factory(),
+					[&] (void *target, id_t, executable_memory_allocator &) {
+
+					created.push_back('s');
+					return unique_ptr<patch>(new mocks::patch([] (void *, int) {	}, target));
+				});
+				const auto sledded = static_cast<unsigned>(address_cast_hack<const byte *>(&recursive_factorial)
+					- this_module.base);
+				patch_manager::apply_request functions[] = {
+					make_pair(sledded + 3, 0u), make_pair(sledded + 7, 0u), make_pair(sledded - 5, 0u),
+				};
+
+				mappings.on_lock_mapping = [&] (id_t) {
+					return make_shared_copy(make_mapping(this_module.base, this_module.path));
+				};
+				mappings.subscription->mapped(1u, 100u, make_mapping(this_module.base, this_module.path));
+
+				// ACT
+				pm->apply(results, 1u, mkrange(functions));
+
+				// ASSERT
+				assert_equal(plural + 't' + 't' + 's', created);
+			}
+
+
+			test( UnusableSledsAreFallenBackFromToTranslation )
+			{
+				// INIT
+				const auto this_module = module::platform().locate(address_cast_hack<const void *>(&recursive_factorial));
+				vector<char> created;
+				auto pm = make_shared<image_patch_manager>([&] (void *target, size_t, id_t, executable_memory_allocator &) {
+					created.push_back('t');
+					return unique_ptr<patch>(new mocks::patch([] (void *, int) {	}, target));
+				}, mappings, memory_manager_, image_patch_manager::counter_patch_factory(),
+					[&] (void *, id_t, executable_memory_allocator &) -> unique_ptr<patch> {
+
+					created.push_back('s');
+					throw padding_insufficient();
+				});
+				const auto sledded = static_cast<unsigned>(address_cast_hack<const byte *>(&recursive_factorial)
+					- this_module.base);
+				patch_manager::apply_request functions[] = {	make_pair(sledded, 0u),	};
+
+				mappings.on_lock_mapping = [&] (id_t) {
+					return make_shared_copy(make_mapping(this_module.base, this_module.path));
+				};
+				mappings.subscription->mapped(1u, 100u, make_mapping(this_module.base, this_module.path));
+
+				// ACT
+				pm->apply(results, 1u, mkrange(functions));
+
+				// ASSERT
+				assert_equal(plural + 's' + 't', created);
+				assert_equal(plural + make_patch_apply(sledded, patch_change_result::ok, 1), results);
+			}
+#endif
 		end_test_suite
 	}
 }
@@ -341,6 +341,21 @@ namespace micro_profiler
 			}
 
 
+			test( ConstructionFailsIfEntrySwitchWouldStraddleCacheLines )
+			{
+				// INIT
+				auto dt = static_cast<const void *>(edge.get() + virtual_memory::granularity());
+				auto target = edge.get() + 63; // The edge is cache line-aligned.
+
+				target[-1] = 0x90, target[0] = 0x90, target[1] = 0x90; // nop, nop
+
+				// INIT / ACT / ASSERT
+				assert_throws(auto_jumper(target, dt), currently_prohibited);
+				target--;
+				auto_jumper(target, dt);
+			}
+
+
 			test( AttemptToConstructOverSingleByteOpcodedFunctionFails )
 			{
 				// INIT
@@ -0,0 +1,66 @@
+#include <patcher/live_write.h>
+
+#include <common/memory.h>
+#include <cstdint>
+#include <ut/assert.h>
+#include <ut/test.h>
+#include <vector>
+
+using namespace std;
+
+namespace micro_profiler
+{
+	namespace tests
+	{
+		namespace
+		{
+			const byte c_code[] = {	0xE9, 0x01, 0x02, 0x03, 0x04, 0xCC, 0xCC, 0x90, 0x90, 0x90, 0xC3,	};
+
+			vector<byte> write_at(size_t offset, size_t length)
+			{
+				uint64_t storage[24];
+				const auto line = reinterpret_cast<byte *>((reinterpret_cast<size_t>(storage) + 63) & ~size_t(63));
+
+				mem_set(line, 0x11, 128);
+				write_code(line + offset, c_code, length);
+				return vector<byte>(line, line + 128);
+			}
+
+			vector<byte> expected_at(size_t offset, size_t length)
+			{
+				vector<byte> expected(128, 0x11);
+
+				mem_copy(expected.data() + offset, c_code, length);
+				return expected;
+			}
+		}
+
+		begin_test_suite( LiveWriteTests )
+			test( CodeFittingAnAlignedWordIsWrittenWithoutTouchingNeighbours )
+			{
+				// ACT / ASSERT
+				assert_equal(expected_at(0, 5), write_at(0, 5));
+				assert_equal(expected_at(3, 5), write_at(3, 5));
+				assert_equal(expected_at(8, 8), write_at(8, 8));
+				assert_equal(expected_at(15, 1), write_at(15, 1));
+			}
+
+
+			test( CodeCrossingWordsIsWrittenCompletely )
+			{
+				// ACT / ASSERT
+				assert_equal(expected_at(4, 5), write_at(4, 5));
+				assert_equal(expected_at(7, 11), write_at(7, 11));
+				assert_equal(expected_at(0, 11), write_at(0, 11));
+			}
+
+
+			test( CodeStartingAtTheEndOfACacheLineIsWrittenCompletely )
+			{
+				// ACT / ASSERT
+				assert_equal(expected_at(63, 5), write_at(63, 5));
+				assert_equal(expected_at(62, 11), write_at(62, 11));
+			}
+		end_test_suite
+	}
+}
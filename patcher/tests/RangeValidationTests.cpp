@@ -101,6 +101,53 @@ namespace micro_profiler
 				validate_partial_function(mkrange(ins7_valid));
 			}
 
+
+
+			test( JumpsIntoMovedFragmentAreValidatedAndCollected )
+			{
+				// INIT
+				byte ins0[] = {
+					0xB8, 0x01, 0x00, 0x00, 0x00, 0x90, 0x90, // moved
+					0x0F, 0x84, 0xF3, 0xFF, 0xFF, 0xFF, // je @0
+					0xE9, 0xF3, 0xFF, 0xFF, 0xFF, // jmp @5
+					0xEB, 0xF2, // jmp @6
+					0x90,
+					0xE9, 0xE6, 0xFF, 0xFF, 0xFF, // jmp @0
+				};
+				vector<size_t> targets;
+
+				// ACT
+				validate_partial_function(const_byte_range(ins0 + 7, sizeof(ins0) - 7), const_byte_range(ins0, 7), 6,
+					targets);
+
+				// ASSERT
+				size_t reference1[] = {	0, 5,	};
+
+				assert_equal(reference1, targets);
+
+				// ACT
+				validate_partial_function(const_byte_range(ins0 + 7, sizeof(ins0) - 7), const_byte_range(ins0, 7), 5,
+					targets);
+
+				// ASSERT
+				size_t reference2[] = {	0,	};
+
+				assert_equal(reference2, targets);
+
+				// INIT
+				byte ins1[] = {	0xB8, 0x01, 0x00, 0x00, 0x00, 0x90, 0x90, 0xEB, 0xF7,	}; // short jump @0
+				byte ins2[] = {	0xB8, 0x01, 0x00, 0x00, 0x00, 0x90, 0x90, 0xE9, 0xF6, 0xFF, 0xFF, 0xFF,	}; // jmp @2
+				byte ins3[] = {	0xB8, 0x01, 0x00, 0x00, 0x00, 0x90, 0x90, 0xE9, 0xF3, 0xFF, 0xFF, 0xFF,	}; // jmp @-1
+
+				// ACT / ASSERT
+				assert_throws(validate_partial_function(const_byte_range(ins1 + 7, 2), const_byte_range(ins1, 7), 5,
+					targets), inconsistent_function_range_exception);
+				assert_throws(validate_partial_function(const_byte_range(ins2 + 7, 5), const_byte_range(ins2, 7), 5,
+					targets), inconsistent_function_range_exception);
+				assert_throws(validate_partial_function(const_byte_range(ins3 + 7, 5), const_byte_range(ins3, 7), 5,
+					targets), inconsistent_function_range_exception);
+			}
+
 		end_test_suite
 	}
 }
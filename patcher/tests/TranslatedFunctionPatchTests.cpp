@@ -80,6 +80,68 @@ namespace micro_profiler
 			}
 
 
+			test( LandingPadIsKeptAtTheEntryOfPatchedFunction )
+			{
+				// INIT
+				const byte endbr64[] = {	0xF3, 0x0F, 0x1E, 0xFA,	};
+				const auto size = sizeof(endbr64) + 10 * c_jump_size;
+				auto function = static_pointer_cast<byte>(allocator.allocate(size));
+				const auto f = function.get();
+
+				mem_set(f, 0x90, size);
+				mem_copy(f, endbr64, sizeof(endbr64));
+
+				const vector<byte> original(f, f + size);
+				translated_function_patch patch(f, size, &trace, allocator);
+
+				// ACT
+				patch.activate();
+
+				// ASSERT
+				assert_equal(endbr64, const_byte_range(f, sizeof(endbr64)));
+				assert_not_equal(0x90, f[sizeof(endbr64)]);
+				assert_is_true(equal(original.begin() + sizeof(endbr64) + c_jump_size, original.end(),
+					f + sizeof(endbr64) + c_jump_size));
+
+				// ACT
+				patch.revert();
+
+				// ASSERT
+				assert_is_true(equal(original.begin(), original.end(), f));
+			}
+
+
+			test( JumpsIntoOverwrittenPrologueAreRetargetedWhileActive )
+			{
+				// INIT
+				const auto size = 10 * c_jump_size;
+				auto function = static_pointer_cast<byte>(allocator.allocate(size));
+				const auto f = function.get();
+				const auto jump_back = f + 2 * c_jump_size;
+
+				mem_set(f, 0x90, size);
+				jump_initialize(jump_back, f + 1);
+
+				const vector<byte> original(f, f + size);
+				translated_function_patch patch(f, size, &trace, allocator);
+
+				// ACT
+				patch.activate();
+
+				// ASSERT
+				const auto target = jump_back + 5 + *reinterpret_cast<const int *>(jump_back + 1);
+
+				assert_not_equal(f + 1, target);
+				assert_equal(0x90, *target);
+
+				// ACT
+				patch.revert();
+
+				// ASSERT
+				assert_is_true(equal(original.begin(), original.end(), f));
+			}
+
+
 			test( PatchIsNotActiveActiveAtConstruction )
 			{
 				// INIT / ACT
@@ -134,6 +196,37 @@ namespace micro_profiler
 			}
 
 
+			test( PausingStopsTracingAndResumingRestoresIt )
+			{
+				// INIT
+				translated_function_patch patch(address_cast_hack<void *>(&recursive_factorial),
+					get_function_size(&recursive_factorial), &trace, allocator);
+
+				patch.activate();
+
+				// ACT / ASSERT
+				assert_is_true(patch.pause(true));
+				assert_is_false(patch.pause(true));
+
+				// ACT / ASSERT
+				assert_equal(6, recursive_factorial(3));
+
+				// ASSERT
+				assert_is_true(patch.active());
+				assert_is_empty(trace.call_log);
+
+				// ACT / ASSERT
+				assert_is_true(patch.pause(false));
+				assert_is_false(patch.pause(false));
+
+				// ACT
+				recursive_factorial(3);
+
+				// ASSERT
+				assert_is_false(trace.call_log.empty());
+			}
+
+
 			test( PatchedFunctionCallsHookCallbacks )
 			{
 				// INIT / ACT
@@ -79,6 +79,9 @@ namespace micro_profiler
 
 			bool patch::revert()
 			{	return _on_patch_action(_target, 2), true;	}
+
+			bool patch::pause(bool paused)
+			{	return _on_patch_action(_target, paused ? 4 : 5), true;	}
 		}
 	}
 }
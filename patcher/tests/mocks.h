@@ -84,6 +84,7 @@ namespace micro_profiler
 
 				virtual bool activate() override;
 				virtual bool revert() override;
+				virtual bool pause(bool paused) override;
 
 			private:
 				const std::function<void (void *target, int act)> _on_patch_action;
@@ -22,6 +22,9 @@
 
 #include "dynamic_hooking.h"
 #include "interface.h"
+#include "revert_buffer.h"
+
+#include <vector>
 
 namespace micro_profiler
 {
@@ -29,20 +32,37 @@ namespace micro_profiler
 	{
 	public:
 		template <typename T>
-		translated_function_patch(void *target, std::size_t size, T *interceptor, executable_memory_allocator &allocator_);
+		translated_function_patch(void *target, std::size_t size, T *interceptor, executable_memory_allocator &allocator_,
+			const fast_trace_layout *fast_layout = nullptr);
+
+		// Constructs a count-only patch: calls to the target are counted in '*counter' and are not traced.
+		translated_function_patch(void *target, std::size_t size, volatile count_t *counter,
+			executable_memory_allocator &allocator_);
+
+		// Returns the upper bound of the memory a patch with a trampoline of 'trampoline_size' bytes takes from the
+		// allocator.
+		static std::size_t max_size(std::size_t trampoline_size);
+		static std::size_t trampoline_size(const fast_trace_layout *fast_layout);
 
 		bool active() const;
 		virtual bool activate() override;
 		virtual bool revert() override;
+		virtual bool pause(bool paused) override;
 
 	private:
-		void init(executable_memory_allocator &allocator_, void *interceptor,
-			hooks<void>::on_enter_t *on_enter, hooks<void>::on_exit_t *on_exit);
+		static byte_range after_landing_pad(void *target, std::size_t size);
+		void init(executable_memory_allocator &allocator_, const void *id, void *interceptor,
+			hooks<void>::on_enter_t *on_enter, hooks<void>::on_exit_t *on_exit, const fast_trace_layout *fast_layout);
+		byte *layout(executable_memory_allocator &allocator_, std::size_t trampoline_size);
+		volatile byte &enabled() const;
 
 	private:
-		std::shared_ptr<const byte> _trampoline;
-		const byte_range _target_function;
-		byte _prologue_backup_offset, _prologue_size;
+		std::shared_ptr<byte> _trampoline; // Trampoline, moved prologue, jump back, prologue backup and the enable flag.
+		const byte_range _target_function; // Past the CET landing pad, if any.
+		std::vector< std::pair<byte /*prologue offset*/, unsigned short /*trampoline offset*/> > _retargets;
+		revert_buffer _references;
+		unsigned short _prologue_backup_offset;
+		byte _prologue_size;
 		bool _active;
 	};
 
@@ -50,7 +70,7 @@ namespace micro_profiler
 
 	template <typename T>
 	inline translated_function_patch::translated_function_patch(void *target, std::size_t size, T *interceptor,
-			executable_memory_allocator &allocator_)
-		: _target_function(static_cast<byte *>(target), size), _active(false)
-	{	init(allocator_, interceptor, hooks<T>::on_enter(), hooks<T>::on_exit());	}
+			executable_memory_allocator &allocator_, const fast_trace_layout *fast_layout)
+		: _target_function(after_landing_pad(target, size)), _active(false)
+	{	init(allocator_, target /*id*/, interceptor, hooks<T>::on_enter(), hooks<T>::on_exit(), fast_layout);	}
 }
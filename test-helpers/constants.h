@@ -10,6 +10,7 @@ namespace micro_profiler
 		extern const std::string c_symbol_container_1;
 		extern const std::string c_symbol_container_2;
 		extern const std::string c_symbol_container_2_instrumented;
+		extern const std::string c_symbol_container_2_stripped;
 		extern const std::string c_symbol_container_3_nosymbols;
 
 		extern const std::string c_guinea_ipc_spawn;
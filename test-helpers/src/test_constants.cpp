@@ -19,6 +19,7 @@ namespace micro_profiler
 		const string c_symbol_container_1 = ~c_this_module & normalize::lib("symbol_container_1");
 		const string c_symbol_container_2 = ~c_this_module & normalize::lib("symbol_container_2");
 		const string c_symbol_container_2_instrumented = ~c_this_module & normalize::lib("symbol_container_2_instrumented");
+		const string c_symbol_container_2_stripped = ~c_this_module & normalize::lib("symbol_container_2_stripped");
 		const string c_symbol_container_3_nosymbols = ~c_this_module & normalize::lib("symbol_container_3_nosymbols");
 
 		const string c_guinea_ipc_spawn = ~c_this_module & normalize::exe("guinea_ipc_spawn");